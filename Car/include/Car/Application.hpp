@@ -4,6 +4,7 @@
 
 #include "Car/Core/Timestep.hpp"
 #include "Car/Events/Event.hpp"
+#include "Car/FramePacer.hpp"
 
 #include "Car/Layers/Layer.hpp"
 #include "Car/Layers/LayerStack.hpp"
@@ -11,6 +12,8 @@
 #include "Car/Window.hpp"
 
 namespace Car {
+    class RenderThread;
+
     class Application {
     public:
         struct Specification {
@@ -20,6 +23,22 @@ namespace Car {
             int32_t targetFPS = 60; // -1 is unlimited
             bool resizable = true;
             bool useImGui = true;
+            // how many frames the cpu can get ahead of the gpu
+            uint32_t framesInFlight = 2;
+            // waits for the gpu before the input is read instead of after, the frame is built from fresher input at
+            // the cost of the cpu and the gpu working less in parallel
+            bool lowLatency = false;
+            // records and submits the frames on a thread of its own while the main thread builds the next one. in
+            // onRender only Renderer2D can be used (it records into the frame packet), the raw Renderer calls need
+            // the thread that records. with lowLatency the main thread waits for the render thread to be idle
+            bool renderThread = false;
+            // threads of Car::Jobs, 0 is one per core besides the main thread
+            uint32_t jobWorkers = 0;
+            // ticks per second of onFixedUpdate, -1 disables it
+            int32_t fixedUpdateRate = -1;
+            // the most ticks one frame can run, when the simulation falls further behind the rest of the time is
+            // dropped so a slow frame does not make the next one slower
+            uint32_t maxFixedUpdatesPerFrame = 8;
         };
 
     public:
@@ -48,9 +67,18 @@ namespace Car {
         virtual void onImGuiRender(double deltaTime) { UNUSED(deltaTime); };
 
         virtual void onUpdate(double deltaTime) { UNUSED(deltaTime); }
-        virtual void onRender() {}
+        // runs fixedUpdateRate times per second of real time no matter the frame rate, zero or more times per frame
+        // before onUpdate. fixedDeltaTime is always 1 / fixedUpdateRate
+        virtual void onFixedUpdate(double fixedDeltaTime) { UNUSED(fixedDeltaTime); }
+        // alpha is how far the frame is between the last two fixed updates in [0, 1), meant to interpolate the
+        // state they produced. it is always 1 without fixed updates
+        virtual void onRender(double alpha) { UNUSED(alpha); }
 
         inline const Ref<Car::Window> getWindow() const { return mWindow; }
+        // frame time, its variance and the input latency over the last frames
+        const FramePacer::Stats& getFrameStats() const { return mFramePacer.getStats(); }
+        // 0 when fixed updates are disabled
+        double getFixedDeltaTime() const { return mFixedDeltaTime; }
         static const Car::Application* Get();
 
         // meant to be called by EntryPoint
@@ -61,11 +89,18 @@ namespace Car {
 
     private:
         void onEvent(Car::Event& event);
+        // runs the fixed updates that dt covers and returns the interpolation alpha
+        double runFixedUpdates(double dt);
 
     private:
         Ref<Car::Window> mWindow;
         Car::ImGuiLayer mImGuiLayer;
         Car::LayerStack mLayerStack;
+        Car::FramePacer mFramePacer;
+        Scope<Car::RenderThread> mRenderThread;
+
+        double mFixedDeltaTime = 0.0;
+        double mFixedAccumulator = 0.0;
     };
 
     // To be defined in CLIENT
@@ -6,6 +6,9 @@
 #include "Car/Application.hpp"
 #include <imgui.h>
 #include "Car/Time.hpp"
+#include "Car/FramePacer.hpp"
+#include "Car/RenderThread.hpp"
+#include "Car/Jobs.hpp"
 #include "Car/Core/Timestep.hpp"
 #include "Car/Core/Log.hpp"
 #include "Car/ResourceManager.hpp"
@@ -26,8 +29,11 @@
 /////////////////////////////////////////
 #include "Car/Renderer/Renderer.hpp"
 #include "Car/Renderer/Renderer2D.hpp"
+#include "Car/Renderer/ParticleSystem2D.hpp"
 #include "Car/Renderer/Font.hpp"
+#include "Car/Renderer/TextLayout.hpp"
 #include "Car/Renderer/Shader.hpp"
+#include "Car/Renderer/ComputeShader.hpp"
 #include "Car/Renderer/UniformBuffer.hpp"
 #include "Car/Renderer/VertexArray.hpp"
 #include "Car/Renderer/Texture2D.hpp"
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Car/Core/Core.hpp"
+
+#include <array>
+
+// how many frames the stats are taken over
+#ifndef CR_FRAME_PACER_HISTORY
+#define CR_FRAME_PACER_HISTORY 120
+#endif // CR_FRAME_PACER_HISTORY
+
+namespace Car {
+    // keeps the frames of Application::run at the target rate. the clock is monotonic, the wait sleeps for as long as
+    // sleeping is known to not overshoot and spins for the rest so the frames start within a fraction of a
+    // millisecond of their deadline. deadlines are spaced by the frame period instead of being taken from whenever
+    // the last frame ended so the rate does not drift
+    class FramePacer {
+    public:
+        // all times are in seconds, over the last CR_FRAME_PACER_HISTORY frames
+        struct Stats {
+            double averageFrameTime = 0.0;
+            double frameTimeVariance = 0.0;
+            double minFrameTime = 0.0;
+            double maxFrameTime = 0.0;
+            // from reading the input to submitting the frame that used it
+            double averageInputLatency = 0.0;
+            double maxInputLatency = 0.0;
+            // how late the waits woke up on average, the lower the steadier the frame rate
+            double averageWakeError = 0.0;
+        };
+
+    public:
+        // -1 is unlimited
+        FramePacer(int32_t targetFPS = -1);
+
+        void setTargetFPS(int32_t targetFPS);
+        int32_t getTargetFPS() const { return mTargetFPS; }
+
+        // starts a frame and returns the time since the start of the last one, the first frame gets 1 / 60
+        double beginFrame();
+        // the input of the frame was just read
+        void markInputSampled();
+        // the frame was handed to the gpu
+        void markSubmitted();
+        // blocks until the next frame should start, returns right away when unlimited
+        void waitForNextFrame();
+
+        const Stats& getStats() const { return mStats; }
+
+        // seconds on a monotonic clock with an arbitrary epoch
+        static double Now();
+
+    private:
+        void sleepUntil(double deadline);
+        void updateStats();
+
+    private:
+        int32_t mTargetFPS = -1;
+        double mPeriod = 0.0;
+
+        double mFrameStart = 0.0;
+        double mNextDeadline = 0.0;
+        double mInputSampled = 0.0;
+
+        // running estimate of how long a 1ms sleep actually takes, mean + stddev is what the wait trusts
+        double mSleepMean = 0.002;
+        double mSleepVariance = 0.0;
+        uint64_t mSleepCount = 1;
+
+        std::array<double, CR_FRAME_PACER_HISTORY> mFrameTimes{};
+        std::array<double, CR_FRAME_PACER_HISTORY> mInputLatencies{};
+        std::array<double, CR_FRAME_PACER_HISTORY> mWakeErrors{};
+        uint32_t mHistoryIndex = 0;
+        uint32_t mHistoryCount = 0;
+
+        Stats mStats;
+    };
+} // namespace Car
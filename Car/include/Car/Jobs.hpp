@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Car/Core/Core.hpp"
+
+#include <functional>
+
+// a work stealing thread pool. every worker has a deque of its own, it pushes and pops the jobs it spawns at the back
+// and steals from the front of the others when it runs out. threads that are not workers (the main thread) hand their
+// jobs to the workers round robin. jobs are grouped by a counter that is done once every job of it finished, a job
+// can depend on a counter and only starts after it is done
+namespace Car::Jobs {
+    struct Counter;
+    using Handle = Ref<Counter>;
+    using Job = std::function<void()>;
+    // [begin, end) of the range given to ParallelFor
+    using RangeJob = std::function<void(uint32_t begin, uint32_t end)>;
+
+    // automatically called by the main application, workerCount 0 is one worker per core besides the main thread
+    void Init(uint32_t workerCount = 0);
+    // finishes every job that was scheduled, continuations that did not run yet are dropped
+    void Shutdown();
+
+    uint32_t GetWorkerCount();
+    // -1 on threads that are not workers
+    int32_t GetWorkerIndex();
+
+    // dependency can be nullptr
+    Handle Schedule(Job job, const Handle& dependency = nullptr);
+    // splits [begin, end) into ranges of about grainSize (0 picks one from the number of workers) and runs job on
+    // each of them, the handle is done when every range is
+    Handle ParallelFor(uint32_t begin, uint32_t end, RangeJob job, uint32_t grainSize = 0,
+                       const Handle& dependency = nullptr);
+    // ParallelFor and Wait
+    void ParallelForAndWait(uint32_t begin, uint32_t end, RangeJob job, uint32_t grainSize = 0);
+
+    // nullptr is always done
+    bool IsDone(const Handle& handle);
+    // runs other jobs on the calling thread until the handle is done, so a job can wait on the jobs it spawned
+    void Wait(const Handle& handle);
+
+    // runs continuation on the main thread once the handle is done, they are run at the start of every frame. meant
+    // for whatever has to happen on the main thread with the result of the jobs (creating gpu resources and such)
+    void OnMainThread(const Handle& handle, Job continuation);
+    // automatically called by the main application
+    void RunMainThreadContinuations();
+} // namespace Car::Jobs
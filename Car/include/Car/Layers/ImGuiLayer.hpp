@@ -7,6 +7,8 @@
 #include "Car/Events/MouseEvent.hpp"
 #include "Car/Events/WindowEvent.hpp"
 
+struct ImDrawData;
+
 namespace Car {
     class ImGuiLayer : public Layer {
     public:
@@ -25,7 +27,12 @@ namespace Car {
         virtual bool onKeyTypedEvent(KeyTypedEvent&) override;
 
         void begin();
+        // endFrame and then draw
         void end();
+        // ends the imgui frame without recording it, the draw data is valid until the next begin
+        ImDrawData* endFrame();
+        // records the draw data into the frame that is being recorded, can be called from the render thread
+        static void draw(ImDrawData* drawData);
 
     private:
         bool mWantCaptureMouse;
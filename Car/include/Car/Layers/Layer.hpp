@@ -16,7 +16,9 @@ namespace Car {
         virtual void onAttach() {}
         virtual void onDetach() {}
         virtual void onUpdate(double deltaTime) { UNUSED(deltaTime); }
-        virtual void onRender() {}
+        // see Application::onFixedUpdate and Application::onRender
+        virtual void onFixedUpdate(double fixedDeltaTime) { UNUSED(fixedDeltaTime); }
+        virtual void onRender(double alpha) { UNUSED(alpha); }
         virtual void onImGuiRender(double deltaTime) { UNUSED(deltaTime); }
 
         virtual bool onMouseButtonPressedEvent(MouseButtonPressedEvent&) { return false; }
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Car/Core/Core.hpp"
+
+#include "Car/Layers/ImGuiLayer.hpp"
+#include "Car/Renderer/Renderer2D.hpp"
+
+#include <imgui.h>
+
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Car {
+    // records and submits the frames on a thread of its own so the main thread can build frame N + 1 while frame N
+    // is recorded, a frame then takes max(update, render) instead of update + render. the main thread draws into the
+    // Renderer2D context of a packet and hands it over, imgui draw data is copied into the packet since imgui reuses
+    // its draw lists every frame. used by Application when Specification::renderThread is set
+    class RenderThread {
+    public:
+        struct FramePacket {
+            Ref<Renderer2DContext> context;
+            // the draw lists are clones owned by the packet, only valid when hasImGui
+            ImDrawData imguiDrawData;
+            bool hasImGui = false;
+        };
+
+    public:
+        RenderThread();
+        // renders whatever was submitted and joins
+        ~RenderThread();
+
+        // the packet for the next frame with its context bound on the calling thread, blocks while the render thread
+        // still needs it. only one packet can be built at a time
+        FramePacket& beginPacket();
+        // unbinds the context, copies the imgui draw data (nullptr without imgui) and hands the packet over
+        void submitPacket(ImDrawData* imguiDrawData);
+        // blocks until every submitted packet was rendered
+        void waitIdle();
+
+    private:
+        void run();
+        void render(FramePacket& packet);
+        static void releaseImGuiDrawLists(FramePacket& packet);
+
+    private:
+        std::array<FramePacket, 2> mPackets;
+        // the packet the main thread builds next
+        uint32_t mWriteIndex = 0;
+        // -1 when there is nothing to render
+        int32_t mPendingIndex = -1;
+        int32_t mRenderingIndex = -1;
+        bool mStop = false;
+
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::thread mThread;
+    };
+} // namespace Car
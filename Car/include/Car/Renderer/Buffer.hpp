@@ -10,6 +10,8 @@ namespace Car {
             None = 0,
             StaticDraw,
             DynamicDraw,
+            // persistently mapped memory with one arena per frame in flight, data is written every frame
+            Stream,
         };
         enum class Type {
             None = 0,
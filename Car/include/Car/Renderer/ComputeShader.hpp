@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Car/Core/Core.hpp"
+#include "Car/Renderer/SSBO.hpp"
+#include "Car/Renderer/Texture2D.hpp"
+#include "Car/Renderer/UniformBuffer.hpp"
+
+namespace Car {
+    // a single .comp shader, it is run with Renderer::Dispatch. the inputs work like the ones of a Shader, the push
+    // constants are kept by the shader and pushed by every dispatch
+    class ComputeShader {
+    public:
+        virtual ~ComputeShader() = default;
+
+        virtual void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<UniformBuffer> ub) = 0;
+        virtual void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<Texture2D> texture) = 0;
+        virtual void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<SSBO> ssbo) = 0;
+
+        // size + offset can not be larger then 128
+        virtual void setPushConstant(const void* data, uint32_t size, uint32_t offset = 0) = 0;
+
+        // local_size_x/y/z of the shader, the number of groups to dispatch for n invocations is
+        // (n + size - 1) / size
+        virtual glm::uvec3 getWorkgroupSize() const = 0;
+
+        static Ref<ComputeShader> Create(const std::string& computeShaderFilepath);
+    };
+} // namespace Car
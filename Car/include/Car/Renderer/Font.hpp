@@ -4,6 +4,8 @@
 #include "Car/Geometry/Rect.hpp"
 #include "Car/Renderer/Texture2D.hpp"
 
+#include <mutex>
+
 #ifndef CR_DEFAULT_CHARS
 #define CR_DEFAULT_CHARS                                                                                               \
     " !\\\"#$%&'()*+,-./"                                                                                              \
@@ -11,27 +13,97 @@
     "abcdefghijklmnopqrstuvwxyz{|}~"
 #endif // CR_DEFAULT_CHARS
 
+// every vulkan device supports at least 4096x4096 images
+#ifndef CR_FONT_MAX_ATLAS_SIZE
+#define CR_FONT_MAX_ATLAS_SIZE 4096
+#endif // CR_FONT_MAX_ATLAS_SIZE
+
+struct FT_FaceRec_;
+
 namespace Car {
     class Renderer2D;
+    class TextLayout;
 
     class Font {
-        struct Character {
+        struct Glyph {
+            // where the glyph is in the atlas
             Rect rect;
-            uint32_t advance;
+            // from the pen position to the top left of the glyph
+            glm::vec2 offset;
+            float advance;
+            // index of the glyph in the face, for kerning
+            uint32_t index;
+            bool loaded = false;
+        };
+
+        struct Shelf {
+            uint32_t y;
+            uint32_t height;
+            uint32_t x;
         };
 
     public:
-        Font(const std::string& path, uint32_t height, const std::string& charsToLoad = CR_DEFAULT_CHARS);
+        // charsToLoad are utf-8 and are rasterized up front, every other codepoint is rasterized the first time it is
+        // used. sdf fonts store distance fields which can be drawn at any size with a single atlas
+        Font(const std::string& path, uint32_t height, const std::string& charsToLoad = CR_DEFAULT_CHARS,
+             bool sdf = false);
         ~Font();
+        // the face is released by the destructor
+        Font(const Font&) = delete;
+        Font& operator=(const Font&) = delete;
+
+        // every function of a font can be called from any thread, the glyphs and the atlas are behind a lock of the
+        // font so text that is new to it is better loaded up front when many threads draw with it
+        glm::ivec2 measureText(const std::string& text, float scale = 1.0f);
+        // rasterizes the glyphs of the text that are missing from the atlas and uploads them
+        void loadGlyphs(const std::string& text);
 
-        glm::ivec2 measureText(const std::string& text);
-        Ref<Texture2D> getTexture() const { return mTexture; }
+        Ref<Texture2D> getTexture() const;
+        uint32_t getHeight() const { return mHeight; }
+        bool isSDF() const { return mSDF; }
+
+        // returns the codepoint starting at text[i] and moves i past it, invalid sequences become U+FFFD
+        static uint32_t DecodeUTF8(const std::string& text, size_t& i);
 
     private:
-        Ref<Texture2D> mTexture;
+        // everything below expects mMutex to be held
+        void loadGlyphsLocked(const std::string& text);
+        const Glyph& getGlyph(uint32_t codepoint);
+        // horizontal adjustment between two glyphs in pixels of the loaded height
+        float getKerning(const Glyph& left, const Glyph& right) const;
+        bool allocateRect(uint32_t width, uint32_t height, uint32_t* pX, uint32_t* pY);
+        bool growAtlas();
+        // uploads whatever glyphs were rasterized since the last upload
+        void uploadAtlas();
+
+    private:
+        mutable std::mutex mMutex;
+
+        FT_FaceRec_* mFace;
         uint32_t mHeight;
-        std::vector<Font::Character> mCharacters;
+        uint32_t mAscender;
+        bool mSDF;
+        bool mHasKerning;
+
+        // the atlas is kept on the cpu as well so new glyphs and resizes only upload what changed
+        Ref<Texture2D> mTexture;
+        std::vector<uint8_t> mPixels;
+        uint32_t mAtlasWidth;
+        uint32_t mAtlasHeight;
+        bool mAtlasResized = false;
+        // bumped whenever the atlas texture is recreated, anything holding normalized glyph rects has to redo them
+        uint32_t mAtlasVersion = 0;
+        uint32_t mDirtyMinY = UINT32_MAX;
+        uint32_t mDirtyMaxY = 0;
+
+        std::vector<Font::Shelf> mShelves;
+        uint32_t mShelvesBottom = 0;
+
+        // ascii is looked up directly, everything else goes through the map
+        std::vector<Font::Glyph> mASCIIGlyphs;
+        std::unordered_map<uint32_t, Font::Glyph> mGlyphs;
 
         friend Renderer2D;
+        friend TextLayout;
     };
 } // namespace Car
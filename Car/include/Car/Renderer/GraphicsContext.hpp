@@ -12,8 +12,13 @@ namespace Car {
         virtual void init() = 0;
         virtual void swapBuffers() = 0;
         virtual void resize(uint32_t width, uint32_t height) = 0;
+        // blocks until the gpu is done with the frame that is about to be recorded, what BeginRecording would
+        // otherwise wait for after the input was already read
+        virtual void waitForFrame() = 0;
 
-        static Ref<GraphicsContext> Create(GLFWwindow* windowHandle);
+        // maxFramesInFlight is how many frames the cpu can record ahead of the gpu, more smooths out spikes and
+        // fewer lowers the latency
+        static Ref<GraphicsContext> Create(GLFWwindow* windowHandle, uint32_t maxFramesInFlight = 2);
 
         static Ref<GraphicsContext> Get();
     };
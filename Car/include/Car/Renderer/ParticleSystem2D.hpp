@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Car/Core/Core.hpp"
+#include "Car/Renderer/SSBO.hpp"
+#include "Car/Renderer/Texture2D.hpp"
+
+namespace Car {
+    // how a ParticleSystem2D spawns and moves its particles
+    struct ParticleEmitter2D {
+        glm::vec2 position = glm::vec2(0.0f);
+        // particles spawn in position +- extent
+        glm::vec2 extent = glm::vec2(0.0f);
+        // particles per second
+        float rate = 100.0f;
+
+        // radians, the direction is picked in angle +- spread / 2
+        float angle = 0.0f;
+        float spread = 6.28318531f;
+        float speedMin = 50.0f;
+        float speedMax = 100.0f;
+
+        // seconds
+        float lifetimeMin = 1.0f;
+        float lifetimeMax = 2.0f;
+
+        // pixels per second squared
+        glm::vec2 gravity = glm::vec2(0.0f);
+        // fraction of the velocity lost per second
+        float drag = 0.0f;
+
+        // size and color are interpolated over the lifetime of a particle
+        float startSize = 4.0f;
+        float endSize = 0.0f;
+        glm::vec4 startColor = glm::vec4(1.0f);
+        glm::vec4 endColor = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+
+        // nullptr for plain quads
+        Ref<Texture2D> texture;
+    };
+
+    // particles that only exist on the gpu, a compute pass spawns and moves them and Renderer2D draws them as
+    // instanced quads straight out of the same storage buffer. the cpu work per frame does not depend on the
+    // number of particles, it only sets up the emission window and the parameters of the pass
+    class ParticleSystem2D {
+    public:
+        using Emitter = ParticleEmitter2D;
+
+    public:
+        // a slot is reused once the emitter comes around to it again, so capacity should be at least
+        // rate * lifetimeMax or particles die early
+        ParticleSystem2D(uint32_t capacity, const Emitter& emitter);
+
+        Emitter& getEmitter() { return mEmitter; }
+        void setEmitter(const Emitter& emitter) { mEmitter = emitter; }
+        uint32_t getCapacity() const { return mCapacity; }
+
+        // advances the emission, can be called any number of times per frame. the simulation itself runs once
+        // when the system is drawn with Renderer2D::DrawParticleSystem with everything that accumulated since
+        void update(float dt);
+        // spawns count particles on the next simulation on top of the rate
+        void burst(uint32_t count);
+
+        static Ref<ParticleSystem2D> Create(uint32_t capacity, const Emitter& emitter = Emitter());
+
+    private:
+        friend class Renderer2D;
+
+        Emitter mEmitter;
+        uint32_t mCapacity;
+        Ref<SSBO> mParticles;
+
+        // the slots [mEmitStart, mEmitStart + mEmitCount) (wrapping around) respawn on the next simulation
+        uint32_t mEmitStart = 0;
+        uint32_t mEmitCount = 0;
+        // fraction of a particle that did not make it into the last update
+        float mEmitRemainder = 0.0f;
+        // time that was not simulated yet
+        float mPendingTime = 0.0f;
+        uint32_t mSeed = 0;
+    };
+} // namespace Car
@@ -2,6 +2,7 @@
 
 #include "Car/Core/Core.hpp"
 
+#include "Car/Renderer/ComputeShader.hpp"
 #include "Car/Renderer/VertexArray.hpp"
 
 namespace Car {
@@ -26,6 +27,17 @@ namespace Car {
         static void DrawCommand(const Ref<VertexArray> va, uint64_t indicesCount) {
             sInstance->DrawCommandImpl(va, indicesCount);
         }
+        // non indexed, the vertex array doesnt need an index buffer
+        static void DrawInstanced(const Ref<VertexArray> va, uint32_t vertexCount, uint32_t instanceCount) {
+            sInstance->DrawInstancedImpl(va, vertexCount, instanceCount);
+        }
+
+        // only while recording (onRender), the dispatches of a frame all run before its draws and each one sees the
+        // writes of the dispatches before it
+        static void Dispatch(const Ref<ComputeShader> shader, uint32_t groupCountX, uint32_t groupCountY = 1,
+                             uint32_t groupCountZ = 1) {
+            sInstance->DispatchImpl(shader, groupCountX, groupCountY, groupCountZ);
+        }
 
         static void SetViewport(float x, float y, float width, float height, float minDepth = 0.0f,
                                 float maxDepth = 1.0f) {
@@ -47,6 +59,9 @@ namespace Car {
         virtual void ShutdownImpl() = 0;
         virtual void ClearColorImpl(float r, float g, float b, float a) = 0;
         virtual void DrawCommandImpl(const Ref<VertexArray> va, uint64_t indicesCount) = 0;
+        virtual void DrawInstancedImpl(const Ref<VertexArray> va, uint32_t vertexCount, uint32_t instanceCount) = 0;
+        virtual void DispatchImpl(const Ref<ComputeShader> shader, uint32_t groupCountX, uint32_t groupCountY,
+                                  uint32_t groupCountZ) = 0;
         virtual void SetViewportImpl(float x, float y, float width, float height, float minDepth, float maxDepth) = 0;
         virtual void SetScissorImpl(int32_t x, int32_t y, int32_t width, int32_t height) = 0;
         virtual void SetPushConstantImpl(Ref<VertexArray> va, bool vert, bool frag, void* data, uint32_t size, uint32_t offset) = 0;
@@ -3,11 +3,26 @@
 #include "Car/Geometry/Rect.hpp"
 #include "Car/Renderer/Texture2D.hpp"
 #include "Car/Renderer/Font.hpp"
+#include "Car/Renderer/ParticleSystem2D.hpp"
+#include "Car/Renderer/TextLayout.hpp"
 #include "Car/Core/Core.hpp"
 
 namespace Car {
+    struct Renderer2DContext;
+    struct Renderer2DStaticBatch;
+
     // it is a class and not a namespace as objects might need to friend this
     class Renderer2D {
+    public:
+        struct Stats {
+            // runs of instances with the same texture in submission order and after sorting, only counted in deferred
+            // mode. batches do not split on textures (they are bindless) so this is about sampling locality
+            uint32_t textureRunsBeforeSort = 0;
+            uint32_t textureRunsAfterSort = 0;
+            uint32_t drawCalls = 0;
+            uint32_t instances = 0;
+        };
+
     public:
         static void DrawTexture(const Ref<Texture2D>& texture, const Rect& dest,
                                 const glm::vec3& tint = glm::vec3(1.0f));
@@ -17,8 +32,11 @@ namespace Car {
                                    const glm::vec3& tint = glm::vec3(1.0f));
         static void DrawSubTexture(const Ref<Texture2D>& texture, const Rect& source, const glm::vec2& pos,
                                    const glm::vec3& tint = glm::vec3(1.0f));
+        // scale is relative to the height the font was loaded with, sdf fonts stay sharp at any scale
         static void DrawText(const Ref<Font>& font, const std::string& text, const glm::vec2& pos,
-                             const glm::vec3& color = glm::vec3(1.0f));
+                             const glm::vec3& color = glm::vec3(1.0f), float scale = 1.0f);
+        // the quads are built once by the layout, this only offsets them into the batch
+        static void DrawText(TextLayout& layout, const glm::vec2& pos, const glm::vec3& color = glm::vec3(1.0f));
 
         static void DrawRect(const Rect& rect, const glm::vec3& color = glm::vec3(1.0f));
         static void DrawLine(glm::vec2 posA, glm::vec2 posB, const glm::vec3& color = glm::vec3(1.0f),
@@ -27,15 +45,50 @@ namespace Car {
         // internal functions that are exposed if you are dealing with a single
         // sprite sheet or only a couple these functions dont validate the
         // textureID that they are getting they flush the textures as needed
-        // getTextureID returns -1 if there are already too many textures and it
-        // invalidates the current batch
-        static int8_t getTextureID(const Ref<Texture2D>& texture);
+        // getTextureID returns the slot of the texture in the bindless texture
+        // table and keeps the texture alive until the end of the frame
+        static uint32_t getTextureID(const Ref<Texture2D>& texture);
         static void DrawSubTextureFromID(const uint32_t textureWidth, const uint32_t textureHeight, const Rect& source,
-                                         const Rect& dest, int8_t textureID, const glm::vec3& tint = glm::vec3(1.0f));
-        static void DrawTextureFromID(const Rect& dest, int8_t textureID, const glm::vec3& tint = glm::vec3(1.0f));
+                                         const Rect& dest, uint32_t textureID, const glm::vec3& tint = glm::vec3(1.0f));
+        static void DrawTextureFromID(const Rect& dest, uint32_t textureID, const glm::vec3& tint = glm::vec3(1.0f));
         // automatically called by End and by DrawTexture as needed
         static void FlushTextures();
 
+        // in deferred mode draws are kept until End and sorted by layer and then texture, the submission order is
+        // only kept between draws with the same layer and texture so use layers where overlapping matters. with a
+        // bound context the change is recorded into it and applied when it is submitted
+        static void SetDeferred(bool deferred);
+        // lower layers are drawn first, only used in deferred mode. recorded like SetDeferred
+        static void SetLayer(int16_t layer);
+        // stats of the last frame
+        static const Stats& GetStats();
+
+        // per thread submission, while a context is bound the draw functions of that thread record into the context
+        // instead of the frame. the main thread submits the contexts (after the worker is done with them) in
+        // whatever order it wants them to be drawn, submitting clears the context so it can be reused. static
+        // batches, particle systems and SetDeferred / SetLayer are recorded too and replayed in order
+        static Ref<Renderer2DContext> CreateContext();
+        // nullptr unbinds, only affects the calling thread
+        static void BindContext(const Ref<Renderer2DContext>& context);
+        // main thread only, between Begin and End
+        static void SubmitContext(const Ref<Renderer2DContext>& context);
+
+        // moves the sprites recorded into the context into a storage buffer that the vertex shader reads them from,
+        // drawing the batch is then a single draw call without any per sprite work on the cpu. meant for sprites that
+        // rarely change like tilemaps and backgrounds, the textures are kept alive by the batch. anything else the
+        // context recorded is dropped
+        static Ref<Renderer2DStaticBatch> CreateStaticBatch(const Ref<Renderer2DContext>& context);
+        // between Begin and End or into a bound context. static batches are not sorted, in deferred mode everything
+        // that was deferred so far is drawn first
+        static void DrawStaticBatch(const Ref<Renderer2DStaticBatch>& batch);
+
+        // between Begin and End or into a bound context. runs the simulation of the system for the time it was
+        // updated by since it was last drawn and draws every slot of it as one instanced draw, in deferred mode
+        // everything that was deferred so far is drawn first. the simulation runs before any draw of the frame. the
+        // parameters are taken when this is called so the system can keep being updated before the context is
+        // submitted
+        static void DrawParticleSystem(const Ref<ParticleSystem2D>& system);
+
         // automatically called by the main application
         static void Init();
         static void Shutdown();
@@ -3,18 +3,20 @@
 #include "Car/Core/Core.hpp"
 #include "Car/Renderer/Buffer.hpp"
 
-// TODO: Not implemented
 namespace Car {
+    // a storage buffer, bound to a shader with Shader::setInput. StaticDraw buffers live in device local memory and
+    // are meant to be written once, DynamicDraw and Stream buffers have a host visible copy per frame in flight and
+    // like a UniformBuffer only the copy of the current frame is written by updateBuffer
     class SSBO {
     public:
         virtual ~SSBO() = default;
 
-        virtual void updateBuffer(void* data, uint64_t size) = 0;
+        virtual void updateBuffer(void* data, uint64_t size, uint64_t offset = 0) = 0;
 
         virtual uint64_t getSize() const = 0;
-        virtual void bind(uint32_t binding) const = 0;
-        virtual void unbind() const = 0;
+        virtual Buffer::Usage getUsage() const = 0;
 
+        // data can be nullptr, the buffer is zeroed then
         static Ref<SSBO> Create(void* data, uint64_t size, Car::Buffer::Usage usage = Car::Buffer::Usage::DynamicDraw);
     };
 } // namespace Car
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Car/Core/Core.hpp"
+#include "Car/Renderer/SSBO.hpp"
 #include "Car/Renderer/Texture2D.hpp"
 #include "Car/Renderer/UniformBuffer.hpp"
 
@@ -10,7 +11,7 @@ namespace Car {
         enum class PolygonMode { FILL, LINE, POINT };
         enum class CullMode { NONE, FRONT, BACK, FRONT_AND_BACK };
         enum class FrontFace { CLOCKWISE, COUNTER_CLOCKWISE };
-        enum class VertexInputRate { VERTEX, /* ,INSTANCE */ };
+        enum class VertexInputRate { VERTEX, INSTANCE };
         enum class PrimitiveTopology {
             POINT_LIST, TRIANGLE_LIST, LINE_LIST, TRIANGLE_LIST_WITH_ADJACENCY, LINE_LIST_WITH_ADJACENCY, PATCH_LIST,
             TRIANGLE_STRIP, LINE_STRIP, TRIANGLE_STRIP_WITH_ADJACENCY, LINE_STRIP_WITH_ADJACENCY,
@@ -59,7 +60,7 @@ namespace Car {
                     case DataType::Float4:
                     case DataType::UInt4:
                     case DataType::Int4:
-                        return 3 * 4;
+                        return 4 * 4;
                     case DataType::NormByte:
                         return 1;
                     case DataType::NormByte2:
@@ -159,6 +160,7 @@ namespace Car {
 
         virtual void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<UniformBuffer> ub) = 0;
         virtual void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<Texture2D> texture) = 0;
+        virtual void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<SSBO> ssbo) = 0;
 
         static Ref<Shader> Create(const std::string& vertexShaderFilepath, const std::string& fragmeantShaderFilepath,
                                   const Specification* pSpec);
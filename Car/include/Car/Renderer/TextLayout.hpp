@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Car/Core/Core.hpp"
+#include "Car/Renderer/Font.hpp"
+
+namespace Car {
+    class Renderer2D;
+
+    // the glyph quads of a string laid out once, for text that is drawn every frame but rarely changes.
+    // it is only rebuilt when the text, font or scale change (or the atlas of the font is resized)
+    class TextLayout {
+    public:
+        struct Quad {
+            // relative to the position the layout is drawn at
+            glm::vec2 offset;
+            glm::vec2 size;
+            // normalized x, y, w, h in the atlas
+            glm::vec4 sourceRect;
+        };
+
+    public:
+        TextLayout() = default;
+        TextLayout(const Ref<Font>& font, const std::string& text, float scale = 1.0f);
+
+        void setFont(const Ref<Font>& font);
+        void setText(const std::string& text);
+        void setScale(float scale);
+
+        const Ref<Font>& getFont() const { return mFont; }
+        const std::string& getText() const { return mText; }
+        float getScale() const { return mScale; }
+
+        const std::vector<TextLayout::Quad>& getQuads();
+        glm::vec2 getSize();
+
+    private:
+        void rebuildIfNeeded();
+
+    private:
+        Ref<Font> mFont;
+        std::string mText;
+        float mScale = 1.0f;
+
+        std::vector<TextLayout::Quad> mQuads;
+        glm::vec2 mSize = glm::vec2(0.0f);
+        uint32_t mAtlasVersion = 0;
+        // the atlas the quads are normalized to
+        Ref<Texture2D> mTexture;
+        bool mDirty = true;
+
+        friend Renderer2D;
+    };
+} // namespace Car
@@ -15,12 +15,23 @@ namespace Car {
     public:
         virtual ~Texture2D() = default;
         virtual void updateData(const std::string& filepath, bool flipped = false) = 0;
+        // pBuffer is tightly packed RGBA8 of width * height
+        virtual void updateRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* pBuffer) = 0;
 
         virtual uint32_t getWidth() const = 0;
         virtual uint32_t getHeight() const = 0;
 
         virtual Rect getRect() const = 0;
 
+        // slot of the texture in the bindless texture table, it does not change for the lifetime of the texture
+        virtual uint32_t getBindlessIndex() const = 0;
+
+        // Create returns before the pixels reach the gpu, drawing the texture is fine either way (the frame waits for
+        // the upload) but isReady can be used to show something else meanwhile
+        virtual bool isReady() const = 0;
+        // blocks until the upload is done
+        virtual void wait() const = 0;
+
         virtual bool operator==(Ref<Texture2D> other) const = 0;
         virtual bool operator!=(Ref<Texture2D> other) const = 0;
 
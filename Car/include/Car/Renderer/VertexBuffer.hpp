@@ -12,6 +12,13 @@ namespace Car {
 
         virtual void updateData(void* data, uint64_t size, uint64_t offset) = 0;
 
+        // only for Buffer::Usage::Stream
+        // returns mapped memory of at least `minSize` bytes in the arena of the current frame that can be written
+        // directly, pCapacity is set to how many bytes can be written. the memory is valid until the frame is done
+        virtual void* reserveStream(uint64_t minSize, uint64_t* pCapacity) = 0;
+        // marks the first `size` bytes of the last reservation as used, bind() will use that region after this
+        virtual void commitStream(uint64_t size) = 0;
+
         virtual uint64_t getSize() const = 0;
         virtual Buffer::Usage getUsage() const = 0;
 
@@ -1,12 +1,92 @@
 #pragma once
 
 #include "Car/Core/Core.hpp"
+#include "Car/Jobs.hpp"
 #include "Car/Renderer/Texture2D.hpp"
 #include "Car/Renderer/Shader.hpp"
 #include "Car/Renderer/Font.hpp"
 
+// 256MB
+#ifndef CR_RESOURCE_MANAGER_DEFAULT_BUDGET
+#define CR_RESOURCE_MANAGER_DEFAULT_BUDGET (256ull * 1024 * 1024)
+#endif // CR_RESOURCE_MANAGER_DEFAULT_BUDGET
+
+// the asset cache. every asset is loaded once per path and shared by everything that asks for it, the files are read
+// and decoded on the Car::Jobs workers and handed over to the main thread at the start of the frame after. the cache
+// keeps the assets alive after the last handle is dropped so loading them again is free, once the assets take more
+// than the budget the ones nothing else holds are evicted, least recently used first
 namespace Car::ResourceManager {
+    struct AssetAccess;
+
+    class AssetBase {
+    public:
+        enum class State {
+            Loading,
+            Ready,
+            Failed,
+        };
+
+    public:
+        AssetBase(const std::string& path) : mPath(path) {}
+        virtual ~AssetBase() = default;
+
+        State getState() const { return mState; }
+        bool isReady() const { return mState == State::Ready; }
+        bool hasFailed() const { return mState == State::Failed; }
+
+        const std::string& getPath() const { return mPath; }
+        // bytes the asset takes on the gpu and cpu, 0 until it is ready
+        size_t getSize() const { return mSize; }
+
+        // blocks until the asset is loaded (or failed to), the calling thread runs other jobs meanwhile
+        void wait();
+
+    protected:
+        // moves the result of the worker into the asset, sets the state and returns the size. only called once the job
+        // is done
+        virtual size_t takeLoaded() = 0;
+
+    protected:
+        std::string mPath;
+        State mState = State::Loading;
+        size_t mSize = 0;
+        Jobs::Handle mJob;
+
+        friend AssetAccess;
+    };
+
+    // handles are only meant to be used from the main thread, the asset itself (get()) can go anywhere
+    template <typename T> class Asset : public AssetBase {
+    public:
+        Asset(const std::string& path, Ref<T> placeholder) : AssetBase(path), mPlaceholder(placeholder) {}
+
+        // the placeholder until the asset is ready, it stays the placeholder if loading failed
+        const Ref<T>& get() const { return mAsset != nullptr ? mAsset : mPlaceholder; }
+
+    protected:
+        virtual size_t takeLoaded() override;
+
+    private:
+        Ref<T> mAsset;
+        Ref<T> mPlaceholder;
+        // written by the worker, nullptr if it failed
+        Ref<T> mLoaded;
+
+        friend AssetAccess;
+    };
+
+    // defined for every type the cache loads
+    template <> size_t Asset<Texture2D>::takeLoaded();
+    template <> size_t Asset<Font>::takeLoaded();
+
+    // fonts have no placeholder, get() is nullptr until they are ready
+    using TextureHandle = Ref<Asset<Texture2D>>;
+    using WeakTextureHandle = std::weak_ptr<Asset<Texture2D>>;
+    using FontHandle = Ref<Asset<Font>>;
+    using WeakFontHandle = std::weak_ptr<Asset<Font>>;
+
     void Init();
+    // drops every cached asset, handles that are still around keep theirs alive
     void Shutdown();
 
     void setResourceDirectory(const std::string& resourceDirectoryName);
@@ -18,4 +98,23 @@ namespace Car::ResourceManager {
     std::string getImagesSubdirectory();
     std::string getShadersSubdirectory();
     std::string getFontsSubdirectory();
+
+    // relative paths are taken from the images subdirectory of the resource directory
+    TextureHandle loadTexture(const std::string& path, bool flipped = false);
+    // relative paths are taken from the fonts subdirectory of the resource directory. charsToLoad is only used by
+    // the load that actually reads the font, the rest share its atlas and rasterize what they miss on use
+    FontHandle loadFont(const std::string& path, uint32_t height, const std::string& charsToLoad = CR_DEFAULT_CHARS,
+                        bool sdf = false);
+
+    // what textures show while they load, by default a single transparent pixel
+    void setPlaceholderTexture(Ref<Texture2D> placeholder);
+    Ref<Texture2D> getPlaceholderTexture();
+
+    // in bytes, evicts right away if the cache is over the new budget
+    void setCacheBudget(size_t budget);
+    size_t getCacheBudget();
+    // bytes taken by the assets that are ready
+    size_t getCacheSize();
+    // evicts every asset nothing else holds
+    void clearCache();
 } // namespace Car::ResourceManager
@@ -20,6 +20,7 @@ namespace Car {
             std::string title;
             bool resizable;
             eventCallbackFn eventCallback;
+            uint32_t framesInFlight = 2;
         };
 
     public:
@@ -30,7 +31,10 @@ namespace Car {
 
         void init();
 
+        // swapBuffers and then pollEvents
         void onUpdate();
+        void swapBuffers();
+        void pollEvents();
 
         uint32_t getWidth() const { return mSpec.width; }
         uint32_t getHeight() const { return mSpec.height; }
@@ -2,95 +2,447 @@
 
 #include "Car/Core/Core.hpp"
 #include "Car/Core/Log.hpp"
+#include "Car/Renderer/Shader.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <set>
 #include <sstream>
+#include <stdexcept>
+
+// "CRSS", the first 4 bytes of every .crss file
+#define CR_CRSS_MAGIC 0x53535243u
+// bumped whenever the layout of a .crss file changes, older files are recompiled
+#define CR_CRSS_VERSION 3u
+// the options every shader is compiled with, they are part of the cache key so changing the options in
+// crVkCompileSingleShader or the shaderCompiler tool means changing this too
+#define CR_SHADER_COMPILE_OPTIONS "glsl;vulkan1.3;performance;includer1"
+
+// "CRSB", the first 4 bytes of a shader bundle
+#define CR_CRSB_MAGIC 0x42535243u
+#define CR_CRSB_VERSION 3u
 
 namespace Car {
     enum class DescriptorType : uint8_t {
         NONE = 0,
         UniformBuffer = 1,
         Sampler2D = 2,
+        // runtime sized `sampler2D[]`, it is backed by the bindless texture table of the graphics context
+        BindlessSampler2D = 3,
+        StorageBuffer = 4,
+        StorageImage = 5,
     };
 
+    // a mask, a descriptor or push constant range can be used by several stages
     enum class DescriptorStage : uint8_t {
+        None = 0,
         VertexShader = BIT(1),
         FragmeantShader = BIT(2),
-        Combined = VertexShader | FragmeantShader
+        Combined = VertexShader | FragmeantShader,
+        // never combined with the graphics stages, a compute shader is a pipeline of its own
+        ComputeShader = BIT(3),
     };
 
+    CR_FORCE_INLINE DescriptorStage operator|(DescriptorStage a, DescriptorStage b) {
+        return (DescriptorStage)((uint8_t)a | (uint8_t)b);
+    }
+
+    // the file extension of the stage, it is also what the stage is called in the cache key
+    inline const char* DescriptorStageExtension(DescriptorStage stage) {
+        switch (stage) {
+        case DescriptorStage::VertexShader:
+            return "vert";
+        case DescriptorStage::FragmeantShader:
+            return "frag";
+        case DescriptorStage::ComputeShader:
+            return "comp";
+        default:
+            throw std::runtime_error("not a single shader stage " + std::to_string((uint32_t)stage));
+        }
+    }
+
     struct Descriptor {
         uint8_t binding;
         Car::DescriptorType descriptorType;
         Car::DescriptorStage stageFlags;
+        // array size, arrays of samplers are one binding with several descriptors
+        uint32_t count = 1;
+    };
+
+    // glsl allows one push constant block per stage, every stage gets its own range
+    struct PushConstantRange {
+        uint32_t offset = 0;
+        // 0 if there are no push constants
+        uint32_t size = 0;
+        Car::DescriptorStage stageFlags = DescriptorStage::None;
+    };
+
+    // the type is what the shader declares, a float input can still be fed with normalized bytes
+    struct VertexInput {
+        uint8_t location;
+        Shader::VertexInputLayout::DataType type;
+    };
+
+    // fnv-1a, enough to notice that a file changed
+    inline uint64_t hashShaderBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    inline std::string readShaderSource(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+
+    // `#include "name"` is looked up next to the including file first and then in the shaders directory, same for
+    // `#include <name>` but in the other order. returns an empty path if it is not found
+    inline std::filesystem::path resolveShaderInclude(const std::filesystem::path& includingFile,
+                                                      const std::string& name, bool relative,
+                                                      const std::filesystem::path& includeRoot) {
+        std::filesystem::path candidates[2] = {includingFile.parent_path() / name, includeRoot / name};
+        if (!relative) {
+            std::swap(candidates[0], candidates[1]);
+        }
+
+        for (const std::filesystem::path& candidate : candidates) {
+            if (std::filesystem::is_regular_file(candidate)) {
+                return candidate.lexically_normal();
+            }
+        }
+        return {};
+    }
+
+    // hashes the includes of source and everything they include, every file is hashed once
+    inline uint64_t hashShaderIncludes(const std::filesystem::path& file, const std::string& source,
+                                       const std::filesystem::path& includeRoot, uint64_t hash,
+                                       std::set<std::filesystem::path>* pVisited) {
+        std::istringstream lines(source);
+        std::string line;
+        while (std::getline(lines, line)) {
+            size_t pos = line.find_first_not_of(" \t");
+            if (pos == std::string::npos || line[pos] != '#') {
+                continue;
+            }
+            pos = line.find_first_not_of(" \t", pos + 1);
+            if (pos == std::string::npos || line.compare(pos, 7, "include") != 0) {
+                continue;
+            }
+            pos = line.find_first_of("\"<", pos + 7);
+            if (pos == std::string::npos) {
+                continue;
+            }
+            const bool relative = line[pos] == '"';
+            const size_t end = line.find(relative ? '"' : '>', pos + 1);
+            if (end == std::string::npos) {
+                continue;
+            }
+
+            const std::string name = line.substr(pos + 1, end - pos - 1);
+            hash = hashShaderBytes(name.data(), name.size(), hash);
+
+            // a missing include only changes the key through its name, the compiler is the one to complain
+            const std::filesystem::path includePath = resolveShaderInclude(file, name, relative, includeRoot);
+            if (includePath.empty() || !pVisited->insert(includePath).second) {
+                continue;
+            }
+
+            const std::string includeSource = readShaderSource(includePath);
+            hash = hashShaderBytes(includeSource.data(), includeSource.size(), hash);
+            hash = hashShaderIncludes(includePath, includeSource, includeRoot, hash, pVisited);
+        }
+
+        return hash;
+    }
+
+    // the cache key of a shader source: its text, the include closure, the stage and the compile options. the
+    // compiler version is stored next to it because it is only known where shaderc is linked in
+    inline uint64_t computeShaderSourceHash(const std::filesystem::path& path, const std::filesystem::path& includeRoot,
+                                            const std::string& stage) {
+        const std::string source = readShaderSource(path);
+
+        uint64_t hash = hashShaderBytes(CR_SHADER_COMPILE_OPTIONS, sizeof(CR_SHADER_COMPILE_OPTIONS) - 1);
+        hash = hashShaderBytes(stage.data(), stage.size(), hash);
+        hash = hashShaderBytes(source.data(), source.size(), hash);
+
+        std::set<std::filesystem::path> visited;
+        return hashShaderIncludes(path, source, includeRoot, hash, &visited);
+    }
+
+    struct CompiledShaderHeader {
+        uint32_t magic = CR_CRSS_MAGIC;
+        uint32_t version = CR_CRSS_VERSION;
+        uint64_t sourceHash = 0;
+        uint64_t compilerVersion = 0;
     };
 
     // .crss format
-    // setCount: u8
-    //     descriptorCount: u8
-    //         binding: u8
-    //         descriptorType: u8
+    // magic: u32
+    // version: u32
+    // sourceHash: u64
+    // compilerVersion: u64
+    // reflection:
+    //     setCount: u8
+    //         descriptorCount: u8
+    //             binding: u8
+    //             descriptorType: u8
+    //             stageFlags: u8
+    //             count: u32
+    //     pushConstantOffset: u32
+    //     pushConstantSize: u32
+    //     pushConstantStageFlags: u8
+    //     vertexInputCount: u8
+    //         location: u8
+    //         type: u8
+    //     workgroupSize: u32[3]
     // shaderLen: u32
     // shaderCode: char[shaderLen]
     struct SingleCompiledShader {
+        CompiledShaderHeader header;
         std::vector<std::vector<Descriptor>> sets;
+        PushConstantRange pushConstant;
+        // only the vertex stage has them, sorted by location
+        std::vector<VertexInput> vertexInputs;
+        // local_size_x/y/z, only the compute stage has one
+        uint32_t workgroupSize[3] = {0, 0, 0};
         std::string shader;
 
-        std::vector<uint8_t> toBytes() {
-            uint32_t totalSize = sizeof(uint8_t);
+        // false for files written before the header existed or by another version of the format
+        static bool readHeader(const std::vector<uint8_t>& bytes, CompiledShaderHeader* pHeader) {
+            if (bytes.size() < sizeof(CompiledShaderHeader)) {
+                return false;
+            }
+            std::memcpy(pHeader, bytes.data(), sizeof(CompiledShaderHeader));
+
+            return pHeader->magic == CR_CRSS_MAGIC && pHeader->version == CR_CRSS_VERSION;
+        }
+
+        // the reflection part is shared by .crss files and shader bundles
+        void writeReflection(std::vector<uint8_t>* pBytes) const {
+            auto writeU32 = [pBytes](uint32_t value) {
+                pBytes->insert(pBytes->end(), (const uint8_t*)&value, (const uint8_t*)&value + sizeof(uint32_t));
+            };
+
+            pBytes->push_back((uint8_t)sets.size());
+
             for (const auto& set : sets) {
-                totalSize += sizeof(uint8_t);
+                pBytes->push_back((uint8_t)set.size());
                 for (const auto& descriptor : set) {
-                    UNUSED(descriptor);
-                    totalSize += sizeof(uint8_t) * 2;
+                    pBytes->push_back((uint8_t)descriptor.binding);
+                    pBytes->push_back((uint8_t)descriptor.descriptorType);
+                    pBytes->push_back((uint8_t)descriptor.stageFlags);
+                    writeU32(descriptor.count);
                 }
             }
 
-            totalSize += sizeof(uint32_t);
-            totalSize += shader.size();
+            writeU32(pushConstant.offset);
+            writeU32(pushConstant.size);
+            pBytes->push_back((uint8_t)pushConstant.stageFlags);
+
+            pBytes->push_back((uint8_t)vertexInputs.size());
+            for (const auto& input : vertexInputs) {
+                pBytes->push_back(input.location);
+                pBytes->push_back((uint8_t)input.type);
+            }
 
-            std::vector<uint8_t> bytes(totalSize);
+            for (uint32_t size : workgroupSize) {
+                writeU32(size);
+            }
+        }
 
-            uint32_t pos = 0;
-            bytes[pos++] = (uint8_t)sets.size();
+        // returns how many bytes were read, 0 if the reflection does not fit in size bytes
+        size_t readReflection(const uint8_t* bytes, size_t size) {
+            size_t pos = 0;
+            // past the end every read is 0 so the counts stop the loops
+            bool truncated = false;
+            auto readU8 = [&]() -> uint8_t {
+                if (pos + sizeof(uint8_t) > size) {
+                    truncated = true;
+                    return 0;
+                }
+                return bytes[pos++];
+            };
+            auto readU32 = [&]() -> uint32_t {
+                if (pos + sizeof(uint32_t) > size) {
+                    truncated = true;
+                    return 0;
+                }
+                uint32_t value;
+                std::memcpy(&value, &bytes[pos], sizeof(uint32_t));
+                pos += sizeof(uint32_t);
+                return value;
+            };
 
-            for (const auto& set : sets) {
-                bytes[pos++] = (uint8_t)set.size();
-                for (const auto& descriptor : set) {
-                    bytes[pos++] = (uint8_t)descriptor.binding;
-                    bytes[pos++] = (uint8_t)descriptor.descriptorType;
+            sets.resize(readU8());
+            for (uint32_t i = 0; i < sets.size(); i++) {
+                sets[i].resize(readU8());
+                for (uint32_t j = 0; j < sets[i].size(); j++) {
+                    sets[i][j].binding = readU8();
+                    sets[i][j].descriptorType = (Car::DescriptorType)readU8();
+                    sets[i][j].stageFlags = (Car::DescriptorStage)readU8();
+                    sets[i][j].count = readU32();
                 }
             }
-            *(uint32_t*)(&bytes.data()[pos]) = shader.size();
-            pos += sizeof(uint32_t);
-            std::memcpy(&bytes[pos], shader.data(), shader.size());
+
+            pushConstant.offset = readU32();
+            pushConstant.size = readU32();
+            pushConstant.stageFlags = (Car::DescriptorStage)readU8();
+
+            vertexInputs.resize(readU8());
+            for (VertexInput& input : vertexInputs) {
+                input.location = readU8();
+                input.type = (Shader::VertexInputLayout::DataType)readU8();
+            }
+
+            for (uint32_t& workgroupDimension : workgroupSize) {
+                workgroupDimension = readU32();
+            }
+
+            return truncated ? 0 : pos;
+        }
+
+        std::vector<uint8_t> toBytes() const {
+            std::vector<uint8_t> bytes(sizeof(CompiledShaderHeader));
+            std::memcpy(bytes.data(), &header, sizeof(CompiledShaderHeader));
+
+            writeReflection(&bytes);
+
+            const uint32_t shaderSize = shader.size();
+            bytes.insert(bytes.end(), (const uint8_t*)&shaderSize, (const uint8_t*)&shaderSize + sizeof(uint32_t));
+            bytes.insert(bytes.end(), shader.begin(), shader.end());
 
             return bytes;
         }
 
-        static SingleCompiledShader fromBytes(std::vector<uint8_t> bytes) {
+        static SingleCompiledShader fromBytes(const std::vector<uint8_t>& bytes) {
             SingleCompiledShader ret;
-            uint32_t pos = 0;
-
-            ret.sets.resize(bytes[pos++]);
-            for (uint32_t i = 0; i < ret.sets.size(); i++) {
-                ret.sets[i].resize(bytes[pos++]);
-                for (uint32_t j = 0; j < ret.sets[i].size(); j++) {
-                    ret.sets[i][j].binding = bytes[pos++];
-                    ret.sets[i][j].descriptorType = (Car::DescriptorType)bytes[pos++];
-                }
+            size_t pos = 0;
+
+            if (bytes.size() < sizeof(CompiledShaderHeader)) {
+                throw std::runtime_error("compiled shader is truncated");
             }
+            std::memcpy(&ret.header, &bytes[pos], sizeof(CompiledShaderHeader));
+            pos += sizeof(CompiledShaderHeader);
 
-            uint32_t codeSize = *(uint32_t*)&bytes[pos];
-            pos += 4;
-            ret.shader.resize(codeSize);
-            std::memcpy(ret.shader.data(), &bytes[pos], codeSize);
+            const size_t reflectionSize = ret.readReflection(&bytes[pos], bytes.size() - pos);
+            if (reflectionSize == 0) {
+                throw std::runtime_error("compiled shader is truncated");
+            }
+            pos += reflectionSize;
+
+            if (bytes.size() - pos < sizeof(uint32_t)) {
+                throw std::runtime_error("compiled shader is truncated");
+            }
+            uint32_t codeSize;
+            std::memcpy(&codeSize, &bytes[pos], sizeof(uint32_t));
+            pos += sizeof(uint32_t);
+            if (bytes.size() - pos < codeSize) {
+                throw std::runtime_error("compiled shader is truncated");
+            }
+            ret.shader.assign((const char*)&bytes[pos], codeSize);
 
             return ret;
         }
     };
 
+    // .crsb format, a whole shaders folder in one file that is mapped instead of read. every offset is from the
+    // start of the file and the spir-v is 4 byte aligned so it can be handed to vulkan where it is
+    // header: CompiledShaderBundleHeader
+    // entries: CompiledShaderBundleEntry[entryCount], sorted by name then stage
+    // data: names, reflection (same as in a .crss) and spir-v the entries point into
+    struct CompiledShaderBundleHeader {
+        uint32_t magic = CR_CRSB_MAGIC;
+        uint32_t version = CR_CRSB_VERSION;
+        uint32_t entryCount = 0;
+        uint32_t reserved = 0;
+    };
+
+    struct CompiledShaderBundleEntry {
+        uint64_t sourceHash;
+        uint64_t compilerVersion;
+        uint32_t stage; // DescriptorStage
+        uint32_t nameOffset;
+        uint32_t nameSize;
+        uint32_t reflectionOffset;
+        uint32_t reflectionSize;
+        uint32_t codeOffset;
+        uint32_t codeSize;
+        uint32_t reserved;
+    };
+
+    struct CompiledShaderBundleInput {
+        // relative to the shaders folder with forward slashes, the same name that is given to Shader::Create
+        std::string name;
+        DescriptorStage stage;
+        const SingleCompiledShader* pShader;
+    };
+
+    inline std::vector<uint8_t> buildShaderBundle(std::vector<CompiledShaderBundleInput> inputs) {
+        std::sort(inputs.begin(), inputs.end(), [](const auto& a, const auto& b) {
+            return a.name != b.name ? a.name < b.name : (uint32_t)a.stage < (uint32_t)b.stage;
+        });
+
+        CompiledShaderBundleHeader header;
+        header.entryCount = inputs.size();
+
+        std::vector<CompiledShaderBundleEntry> entries(inputs.size());
+        std::vector<uint8_t> data;
+        const size_t dataStart =
+            sizeof(CompiledShaderBundleHeader) + sizeof(CompiledShaderBundleEntry) * entries.size();
+
+        auto align = [&]() {
+            data.resize((data.size() + 3) & ~(size_t)3);
+        };
+
+        for (size_t i = 0; i < inputs.size(); i++) {
+            const SingleCompiledShader& shader = *inputs[i].pShader;
+            CompiledShaderBundleEntry& entry = entries[i];
+            entry = {};
+            entry.sourceHash = shader.header.sourceHash;
+            entry.compilerVersion = shader.header.compilerVersion;
+            entry.stage = (uint32_t)inputs[i].stage;
+
+            entry.nameOffset = dataStart + data.size();
+            entry.nameSize = inputs[i].name.size();
+            data.insert(data.end(), inputs[i].name.begin(), inputs[i].name.end());
+
+            entry.reflectionOffset = dataStart + data.size();
+            shader.writeReflection(&data);
+            entry.reflectionSize = dataStart + data.size() - entry.reflectionOffset;
+
+            align();
+            entry.codeOffset = dataStart + data.size();
+            entry.codeSize = shader.shader.size();
+            data.insert(data.end(), shader.shader.begin(), shader.shader.end());
+        }
+
+        std::vector<uint8_t> bytes(dataStart);
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        std::memcpy(bytes.data() + sizeof(header), entries.data(), sizeof(CompiledShaderBundleEntry) * entries.size());
+        bytes.insert(bytes.end(), data.begin(), data.end());
+
+        return bytes;
+    }
+
     struct CompiledShader {
         std::vector<std::vector<Descriptor>> sets;
-        std::string vertexShader;
-        std::string fragmeantShader;
+        // only the stages that have push constants
+        std::vector<PushConstantRange> pushConstants;
+        std::vector<VertexInput> vertexInputs;
+        // the spir-v is not owned, it only has to outlive the creation of the shader. it points either into the
+        // SingleCompiledShaders it was combined from or into a mapped shader bundle
+        const uint32_t* pVertexCode = nullptr;
+        size_t vertexCodeSize = 0;
+        const uint32_t* pFragmeantCode = nullptr;
+        size_t fragmeantCodeSize = 0;
+        // only for compute shaders, which have none of the graphics stages
+        const uint32_t* pComputeCode = nullptr;
+        size_t computeCodeSize = 0;
+        uint32_t workgroupSize[3] = {0, 0, 0};
     };
-} // namespace Car
\ No newline at end of file
+} // namespace Car
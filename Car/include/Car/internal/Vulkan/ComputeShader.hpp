@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Car/Core/Ref.hpp"
+#include "Car/Renderer/ComputeShader.hpp"
+#include "Car/internal/Vulkan/CompiledShader.hpp"
+#include "Car/internal/Vulkan/GraphicsContext.hpp"
+#include "Car/internal/Vulkan/ShaderDescriptors.hpp"
+
+namespace Car {
+    class VulkanComputeShader : public ComputeShader {
+    public:
+        VulkanComputeShader(const CompiledShader& compiledShader);
+        virtual ~VulkanComputeShader() override;
+
+        virtual void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<UniformBuffer> ub) override;
+        virtual void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<Texture2D> texture) override;
+        virtual void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<SSBO> ssbo) override;
+
+        virtual void setPushConstant(const void* data, uint32_t size, uint32_t offset) override;
+
+        virtual glm::uvec3 getWorkgroupSize() const override { return mWorkgroupSize; }
+
+        // records the dispatch into the compute command buffer of the frame, a dispatch sees the writes of the ones
+        // recorded before it
+        void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+
+        VkPipelineLayout getPipelineLayout() const { return mPipelineLayout; }
+        VkPipeline getComputePipeline() const { return mComputePipeline; }
+
+    private:
+        void createPipelineLayout(const CompiledShader& compiledShader);
+        void createComputePipeline(const CompiledShader& compiledShader);
+
+    private:
+        Scope<VulkanShaderDescriptors> mDescriptors;
+
+        // the reflected range, size is 0 without push constants
+        VkPushConstantRange mPushConstantRange{};
+        uint8_t mPushConstantData[128]{};
+
+        glm::uvec3 mWorkgroupSize;
+
+        VkPipelineLayout mPipelineLayout;
+        VkPipeline mComputePipeline;
+
+        Ref<VulkanGraphicsContext> mGraphicsContext;
+    };
+} // namespace Car
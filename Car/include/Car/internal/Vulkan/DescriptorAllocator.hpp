@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Car/Core/Core.hpp"
+#include <glad/vulkan.h>
+
+#include <mutex>
+#include <vector>
+
+// how many sets the first pool can hold, every pool after it doubles up to CR_VULKAN_DESCRIPTOR_POOL_MAX_SETS
+#ifndef CR_VULKAN_DESCRIPTOR_POOL_MIN_SETS
+#define CR_VULKAN_DESCRIPTOR_POOL_MIN_SETS 64
+#endif // CR_VULKAN_DESCRIPTOR_POOL_MIN_SETS
+
+#ifndef CR_VULKAN_DESCRIPTOR_POOL_MAX_SETS
+#define CR_VULKAN_DESCRIPTOR_POOL_MAX_SETS 4096
+#endif // CR_VULKAN_DESCRIPTOR_POOL_MAX_SETS
+
+namespace Car {
+    class VulkanGraphicsContext;
+
+    // a set and the pool it has to be given back to
+    struct VulkanDescriptorSet {
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+    };
+
+    // hands out descriptor sets from a chain of pools, a new (bigger) pool is added when every pool is out of memory
+    // instead of failing. sets that live longer than a frame are freed back to their pool, transient sets are only
+    // valid for the frame they were allocated in and their pools are reset wholesale when that frame index comes
+    // around again
+    class VulkanDescriptorAllocator {
+    public:
+        struct Stats {
+            uint32_t poolCount = 0;
+            uint32_t transientPoolCount = 0;
+            uint32_t allocatedSets = 0;
+            uint32_t transientSets = 0;
+        };
+
+    public:
+        VulkanDescriptorAllocator(VulkanGraphicsContext* pGraphicsContext, uint32_t maxFramesInFlight);
+        ~VulkanDescriptorAllocator();
+
+        VulkanDescriptorSet allocate(VkDescriptorSetLayout layout);
+        // the gpu must be done with the set
+        void free(VulkanDescriptorSet* pSet);
+
+        // valid until the fence of the current frame is waited on again
+        VkDescriptorSet allocateTransient(VkDescriptorSetLayout layout);
+        // has to be called after the fence of the frame was waited on, resets the transient pools of the frame
+        void beginFrame(uint32_t frameIndex);
+
+        Stats getStats() const;
+
+    private:
+        struct Pool {
+            VkDescriptorPool pool = VK_NULL_HANDLE;
+            uint32_t allocatedSets = 0;
+            // the last allocation from it failed and nothing was freed since
+            bool full = false;
+        };
+
+        VkDescriptorPool createPool(uint32_t maxSets, VkDescriptorPoolCreateFlags flags);
+        static VkResult allocateFrom(VkDevice device, VkDescriptorPool pool, VkDescriptorSetLayout layout,
+                                     VkDescriptorSet* pSet);
+
+    private:
+        VkDevice mDevice;
+
+        std::vector<Pool> mPools;
+        uint32_t mNextPoolSize = CR_VULKAN_DESCRIPTOR_POOL_MIN_SETS;
+
+        struct TransientPools {
+            std::vector<VkDescriptorPool> used;
+            uint32_t setCount = 0;
+        };
+        std::vector<TransientPools> mTransientPools;
+        std::vector<VkDescriptorPool> mFreeTransientPools;
+        uint32_t mCurrentFrame = 0;
+
+        mutable std::mutex mMutex;
+    };
+} // namespace Car
@@ -1,8 +1,15 @@
 #pragma once
 
 #include "Car/Renderer/GraphicsContext.hpp"
+#include "Car/internal/Vulkan/DescriptorAllocator.hpp"
+#include "Car/internal/Vulkan/MemoryAllocator.hpp"
+#include "Car/internal/Vulkan/StagingPool.hpp"
+#include "Car/internal/Vulkan/UploadQueue.hpp"
 #include <glad/vulkan.h>
 
+#include <atomic>
+#include <mutex>
+
 struct GLFWwindow;
 
 struct CrQueueFamilyIndices {
@@ -24,12 +31,13 @@ struct CrSwapChainSupportDetails {
 namespace Car {
     class VulkanGraphicsContext : public GraphicsContext {
     public:
-        VulkanGraphicsContext(GLFWwindow* windowHandle);
+        VulkanGraphicsContext(GLFWwindow* windowHandle, uint32_t maxFramesInFlight);
         virtual ~VulkanGraphicsContext() override;
 
         virtual void init() override;
         virtual void swapBuffers() override;
         virtual void resize(uint32_t width, uint32_t height) override;
+        virtual void waitForFrame() override;
 
         VkInstance getInstance() const { return mInstance; }
         VkDebugUtilsMessengerEXT getDebugMessenger() const { return mDebugMessenger; }
@@ -40,6 +48,12 @@ namespace Car {
         VkQueue getGraphicsQueue() const { return mGraphicsQueue; }
         VkQueue getPresentQueue() const { return mPresentQueue; }
         VkQueue getTransferQueue() const { return mTransferQueue; }
+        // the queues can be the same VkQueue and submitting needs external synchronization, every vkQueueSubmit,
+        // vkQueuePresentKHR and wait on a queue has to hold it so a render thread can submit next to uploads from
+        // other threads. recursive so a sequence of submits can hold it throughout
+        std::recursive_mutex& getQueueMutex() { return mQueueMutex; }
+        // vkDeviceWaitIdle while holding the queue mutex
+        void waitIdle();
         VkSwapchainKHR getSwapChain() const { return mSwapChain; }
         VkFormat getSwapChainImageFormat() const { return mSwapChainImageFormat; }
         VkExtent2D getSwapChainExtent() const { return mSwapChainExtent; }
@@ -60,26 +74,68 @@ namespace Car {
         VkSemaphore getCurrentRenderFinishedSemaphore() const { return mRenderFinishedSemaphores[mCurrentFrame]; }
         VkFence getCurrentInFlightFence() const { return mInFlightFences[mCurrentFrame]; }
         uint32_t getCurrentFrameIndex() const { return mCurrentFrame; }
+        // total frames submitted, unlike the frame index it never wraps around
+        uint64_t getFrameCount() const { return mFrameCount; }
         uint32_t aquireNextImageIndex();
         uint32_t getImageIndex() const { return mImageIndex; }
-        VkDescriptorPool getDescriptorPool() const { return mDescriptorPool; }
+        // only for imgui, everything else allocates through the descriptor allocator
+        VkDescriptorPool getImGuiDescriptorPool() const { return mImGuiDescriptorPool; }
         uint32_t getMaxFramesInFlight() const { return mMaxFramesInFlight; }
+        VkDescriptorSetLayout getBindlessTextureSetLayout() const { return mBindlessTextureSetLayout; }
+        VkDescriptorSet getBindlessTextureSet() const { return mBindlessTextureSet; }
+        uint32_t getMaxBindlessTextures() const { return mMaxBindlessTextures; }
+        VulkanMemoryAllocator& getMemoryAllocator() { return *mMemoryAllocator; }
+        VulkanMemoryAllocator::Stats getMemoryStats() const { return mMemoryAllocator->getStats(); }
+        VulkanUploadQueue& getUploadQueue() { return *mUploadQueue; }
+        VulkanStagingPool& getStagingPool() { return *mStagingPool; }
+        VulkanDescriptorAllocator& getDescriptorAllocator() { return *mDescriptorAllocator; }
+
+        // shared by every pipeline, loaded from the shader __CACHE__ directory the first time it is asked for (the
+        // context exists before the ResourceManager so it can not be done in init) and written back on shutdown
+        VkPipelineCache getPipelineCache();
+        void savePipelineCache();
+
+        // what is bound on the render command buffer that is being recorded, shaders use it to skip binds that would
+        // not change anything. it has to be reset when recording starts and after anything that binds behind the
+        // back of the shaders (imgui)
+        struct BoundGraphicsState {
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            VkPipelineLayout layout = VK_NULL_HANDLE;
+            std::vector<VkDescriptorSet> descriptorSets;
+        };
+        BoundGraphicsState& getBoundGraphicsState() { return mBoundGraphicsState; }
+        void resetBoundGraphicsState() { mBoundGraphicsState = BoundGraphicsState{}; }
+
+        // dispatches can not be recorded inside the render pass so they go into a command buffer of their own that
+        // is begun by the first dispatch of the frame and submitted right before the render command buffer. every
+        // dispatch of a frame runs before every draw of it no matter the order they were recorded in. only valid
+        // after the fence of the frame was waited on
+        VkCommandBuffer getCurrentComputeCommandBuffer();
+
+        // the bindless texture table is a single `sampler2D[]` shared by every shader, a texture keeps its slot until
+        // it is released
+        uint32_t registerBindlessTexture(const VkDescriptorImageInfo& imageInfo);
+        void updateBindlessTexture(uint32_t slot, const VkDescriptorImageInfo& imageInfo);
+        void releaseBindlessTexture(uint32_t slot);
 
         // functions meant to be used by vulkan objects
         VkImageView createImageView(VkImage* pImage, VkFormat format);
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+        // host visible allocations are persistently mapped, write through pAllocation->mapped
         void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-                          VkBuffer* pBuffer, VkDeviceMemory* pBufferMemory);
-        void freeBuffer(VkBuffer* pBuffer, VkDeviceMemory* pBufferMemory);
+                          VkBuffer* pBuffer, VulkanAllocation* pAllocation);
+        void freeBuffer(VkBuffer* pBuffer, VulkanAllocation* pAllocation);
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0,
                         VkDeviceSize dstOffset = 0);
         void copyBufferToImage2D(VkBuffer* pBuffer, VkImage* pImage, uint32_t width, uint32_t height,
                                  uint64_t srcOffset = 0, uint64_t dstOffsetX = 0, uint64_t dstOffsetY = 0);
         void createImage2D(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
                            VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage* pImage,
-                           VkDeviceMemory* pImageMemory);
+                           VulkanAllocation* pAllocation);
+        void freeImage2D(VkImage* pImage, VulkanAllocation* pAllocation);
         void transitionImageLayout(VkImage* pImage, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
 
+        // the caller holds the queue mutex (scoped) from begin to end, the pool is shared between threads
         VkCommandBuffer beginSingleTimeCommands(VkCommandPool cmdPool);
         void endSingleTimeCommands(VkQueue targetQueue, VkCommandBuffer cmdBuffer, VkCommandPool cmdPool);
 
@@ -101,7 +157,13 @@ namespace Car {
         void createCommandPool();
         void createCommandBuffers();
         void createSyncObjects();
+        // makes the writes of the dispatches visible to the draws and ends the compute command buffer
+        void endComputeCommands();
+        void createUploadQueue();
         void createDescriptorPool();
+        void createBindlessTextureTable();
+        // without locking mBindlessMutex
+        void writeBindlessTexture(uint32_t slot, const VkDescriptorImageInfo& imageInfo);
 
         void cleanupSwapChain();
         void recreateSwapchain();
@@ -140,14 +202,41 @@ namespace Car {
         std::vector<VkCommandBuffer> mRenderCommandBuffers;
         VkCommandPool mTransferCommandPool;
         std::vector<VkCommandBuffer> mTransferCommandBuffers;
+        std::vector<VkCommandBuffer> mComputeCommandBuffers;
+        // the compute command buffer of the current frame was begun
+        bool mComputeRecording = false;
 
         std::vector<VkSemaphore> mImageAvailableSemaphores;
         std::vector<VkSemaphore> mRenderFinishedSemaphores;
         std::vector<VkFence> mInFlightFences;
 
-        VkDescriptorPool mDescriptorPool;
+        VkDescriptorPool mImGuiDescriptorPool;
+        Scope<VulkanDescriptorAllocator> mDescriptorAllocator;
+
+        VkDescriptorPool mBindlessDescriptorPool;
+        VkDescriptorSetLayout mBindlessTextureSetLayout;
+        VkDescriptorSet mBindlessTextureSet;
+        uint32_t mMaxBindlessTextures = 0;
+        uint32_t mBindlessTextureCount = 0;
+        std::vector<uint32_t> mFreeBindlessTextureSlots;
+        // textures can be created and destroyed on any thread
+        std::mutex mBindlessMutex;
+
+        std::recursive_mutex mQueueMutex;
+        // resize only marks the swapchain, it is recreated by the thread that acquires the next image
+        std::atomic<bool> mSwapchainOutdated = false;
+
+        std::mutex mPipelineCacheMutex;
+        VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+        std::filesystem::path mPipelineCachePath;
+
+        Scope<VulkanMemoryAllocator> mMemoryAllocator;
+        Scope<VulkanStagingPool> mStagingPool;
+        Scope<VulkanUploadQueue> mUploadQueue;
 
         uint32_t mCurrentFrame = 0;
+        uint64_t mFrameCount = 0;
+        BoundGraphicsState mBoundGraphicsState;
         uint32_t mImageIndex = 0;
         uint32_t mMaxFramesInFlight = 2;
     };
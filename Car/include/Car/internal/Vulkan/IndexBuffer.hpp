@@ -28,7 +28,7 @@ namespace Car {
 
         Ref<VulkanGraphicsContext> mGraphicsContext;
         VkBuffer mBuffer;
-        VkDeviceMemory mBufferMemory;
+        VulkanAllocation mAllocation;
         VkIndexType mVkIndexType;
     };
 } // namespace Car
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Car/Core/Core.hpp"
+#include <glad/vulkan.h>
+
+#include <mutex>
+
+// size of the device memory blocks that allocations are carved out of, smaller heaps use smaller blocks
+#ifndef CR_VULKAN_MEMORY_BLOCK_SIZE
+#define CR_VULKAN_MEMORY_BLOCK_SIZE (64ull * 1024 * 1024)
+#endif // CR_VULKAN_MEMORY_BLOCK_SIZE
+
+namespace Car {
+    struct VulkanMemoryBlock;
+
+    struct VulkanAllocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        // only set for host visible memory, already points to the start of the allocation. the blocks stay mapped
+        // so vkMapMemory must not be used on the memory of an allocation
+        uint8_t* mapped = nullptr;
+
+        // nullptr for allocations that got their own VkDeviceMemory
+        VulkanMemoryBlock* pBlock = nullptr;
+        uint32_t order = 0;
+    };
+
+    // every allocation of a memory type (buffers and optimal images apart so bufferImageGranularity never matters)
+    // comes out of large blocks with a buddy allocator, allocations larger than half a block get their own memory
+    class VulkanMemoryAllocator {
+    public:
+        struct Stats {
+            // what the allocations asked for
+            VkDeviceSize usedBytes = 0;
+            // blocks and dedicated allocations, everything that was allocated from the device
+            VkDeviceSize reservedBytes = 0;
+            uint32_t blockCount = 0;
+            uint32_t allocationCount = 0;
+            uint32_t dedicatedAllocationCount = 0;
+        };
+
+        // called by defragment for every allocation of a sparse block, owners that can move their resource recreate
+        // it (which does not land in the block being drained) and free the old allocation
+        using DefragmentationCallback = std::function<void(const VulkanAllocation& allocation)>;
+
+    public:
+        VulkanMemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+        ~VulkanMemoryAllocator();
+
+        VulkanAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+                                  bool linear);
+        void free(VulkanAllocation* pAllocation);
+
+        // releases the blocks that have no allocations left
+        void trim();
+
+        void setDefragmentationCallback(const DefragmentationCallback& callback) { mDefragmentationCallback = callback; }
+        // asks the callback to move everything out of the blocks that are used less than maxBlockUsage (0 to 1) and
+        // releases the blocks that end up empty, returns how many allocations were handed to the callback
+        uint32_t defragment(float maxBlockUsage = 0.25f);
+
+        Stats getStats() const;
+
+    private:
+        struct Pool {
+            std::vector<Scope<VulkanMemoryBlock>> blocks;
+            VkDeviceSize blockSize = 0;
+        };
+
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+        VulkanMemoryBlock* createBlock(uint32_t poolIndex);
+        void destroyBlock(VulkanMemoryBlock* pBlock);
+        VulkanAllocation allocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size);
+
+    private:
+        VkDevice mDevice;
+        VkPhysicalDeviceMemoryProperties mMemoryProperties;
+
+        // memoryTypeCount * 2, linear resources on the even indices
+        std::vector<Pool> mPools;
+
+        VkDeviceSize mUsedBytes = 0;
+        VkDeviceSize mDedicatedBytes = 0;
+        uint32_t mAllocationCount = 0;
+        uint32_t mDedicatedAllocationCount = 0;
+
+        DefragmentationCallback mDefragmentationCallback;
+
+        mutable std::mutex mMutex;
+    };
+} // namespace Car
@@ -12,6 +12,10 @@ namespace Car {
         virtual void ShutdownImpl() override;
         virtual void ClearColorImpl(float r, float g, float b, float a) override;
         virtual void DrawCommandImpl(const Ref<VertexArray> va, uint64_t indicesCount) override;
+        virtual void DrawInstancedImpl(const Ref<VertexArray> va, uint32_t vertexCount,
+                                       uint32_t instanceCount) override;
+        virtual void DispatchImpl(const Ref<ComputeShader> shader, uint32_t groupCountX, uint32_t groupCountY,
+                                  uint32_t groupCountZ) override;
         virtual void SetViewportImpl(float x, float y, float width, float height, float minDepth,
                                      float maxDepth) override;
         virtual void SetScissorImpl(int32_t x, int32_t y, int32_t width, int32_t height) override;
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Car/Renderer/SSBO.hpp"
+#include "Car/internal/Vulkan/GraphicsContext.hpp"
+
+#include <glad/vulkan.h>
 
 namespace Car {
     class VulkanSSBO : public SSBO {
@@ -8,13 +11,21 @@ namespace Car {
         VulkanSSBO(void* data, uint64_t size, Buffer::Usage usage);
         virtual ~VulkanSSBO() override;
 
-        virtual void updateBuffer(void* data, uint64_t size) override;
+        virtual void updateBuffer(void* data, uint64_t size, uint64_t offset) override;
 
         virtual uint64_t getSize() const override { return mSize; }
-        virtual void bind(uint32_t binding) const override;
-        virtual void unbind() const override;
+        virtual Buffer::Usage getUsage() const override { return mUsage; }
+
+        // for which frame in flight to retrieve the VkDescriptorBufferInfo, a static buffer has one for all of them
+        VkDescriptorBufferInfo getDescriptorBufferInfo(uint32_t i);
 
     private:
         uint64_t mSize;
+        Buffer::Usage mUsage;
+
+        std::vector<VkBuffer> mBuffers;
+        std::vector<VulkanAllocation> mAllocations;
+
+        Ref<VulkanGraphicsContext> mGraphicsContext;
     };
 } // namespace Car
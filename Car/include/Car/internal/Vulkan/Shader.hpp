@@ -4,10 +4,25 @@
 #include "Car/Renderer/Shader.hpp"
 #include "Car/internal/Vulkan/GraphicsContext.hpp"
 #include "Car/internal/Vulkan/CompiledShader.hpp"
+#include "Car/internal/Vulkan/ShaderDescriptors.hpp"
 #include "Car/internal/Vulkan/UniformBuffer.hpp"
 #include "Car/internal/Vulkan/VertexBuffer.hpp"
 
 namespace Car {
+    // one stage of a shader, the reflection always ends up in shader.sets but the spir-v is only in shader.shader if
+    // it did not come from the shader bundle
+    struct LoadedShaderStage {
+        SingleCompiledShader shader;
+        const uint32_t* pCode = nullptr;
+        size_t codeSize = 0;
+    };
+
+    // takes the stage from the shader bundle or the .crss of the shader if it matches the source (and the compiler
+    // when there is one to compare against) and recompiles it otherwise
+    void loadShaderStage(const std::filesystem::path& shadersPath, const std::string& name, DescriptorStage stage,
+                         LoadedShaderStage* pStage);
+
+    // the descriptor sets are managed by VulkanShaderDescriptors, bind() only binds what changed since the last bind
     class VulkanShader : public Shader {
     public:
         VulkanShader(const CompiledShader& compiledShader, const Specification* pSpec);
@@ -17,11 +32,14 @@ namespace Car {
 
         VkPipelineLayout getPipelineLayout() const { return mPipelineLayout; }
         VkPipeline getGraphicsPipeline() const { return mGraphicsPipeline; }
+        // the stages of the push constant ranges that overlap [offset, offset + size), 0 if there are none
+        VkShaderStageFlags getPushConstantStages(uint32_t offset, uint32_t size) const;
 
         virtual void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<UniformBuffer> ub) override;
         virtual void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<Texture2D> texture) override;
+        virtual void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<SSBO> ssbo) override;
 
-        VkShaderModule createShaderModule(const std::string& code);
+        VkShaderModule createShaderModule(const uint32_t* pCode, size_t codeSize);
 
         void createDescriptors();
         void createPipelineLayout();
@@ -30,9 +48,9 @@ namespace Car {
     private:
         CompiledShader mCompiledShader;
 
-        std::vector<VkDescriptorSetLayout> mDescriptorSetLayouts;
-        std::vector<std::vector<VkDescriptorSet>> mDescriptorSets;
+        Scope<VulkanShaderDescriptors> mDescriptors;
 
+        std::vector<VkPushConstantRange> mPushConstantRanges;
         VkPipelineLayout mPipelineLayout;
         VkPipeline mGraphicsPipeline;
 
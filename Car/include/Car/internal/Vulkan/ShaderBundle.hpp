@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Car/Core/Core.hpp"
+#include "Car/internal/Vulkan/CompiledShader.hpp"
+
+namespace Car {
+    // a .crsb made by `shaderCompiler -b` mapped into memory, shaders are created from the spir-v in it in place
+    class VulkanShaderBundle {
+    public:
+        VulkanShaderBundle(const std::filesystem::path& path);
+        ~VulkanShaderBundle();
+
+        VulkanShaderBundle(const VulkanShaderBundle&) = delete;
+        VulkanShaderBundle& operator=(const VulkanShaderBundle&) = delete;
+
+        // false if the file does not exist or is not a bundle of this version
+        bool isValid() const { return mData != nullptr; }
+
+        const CompiledShaderBundleEntry* find(const std::string& name, DescriptorStage stage) const;
+
+        const uint32_t* getCode(const CompiledShaderBundleEntry& entry) const {
+            return reinterpret_cast<const uint32_t*>(mData + entry.codeOffset);
+        }
+        // fills everything but the spir-v of pShader, false if the reflection of the entry is corrupt
+        bool readReflection(const CompiledShaderBundleEntry& entry, SingleCompiledShader* pShader) const {
+            return pShader->readReflection(mData + entry.reflectionOffset, entry.reflectionSize) != 0;
+        }
+
+    private:
+        bool validate() const;
+        void unmap();
+
+    private:
+        const uint8_t* mData = nullptr;
+        size_t mSize = 0;
+
+        const CompiledShaderBundleEntry* mEntries = nullptr;
+        uint32_t mEntryCount = 0;
+
+#ifdef _WIN32
+        void* mFile = nullptr;
+        void* mMapping = nullptr;
+#endif // _WIN32
+    };
+} // namespace Car
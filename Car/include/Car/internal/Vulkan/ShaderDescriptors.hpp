@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Car/Core/Ref.hpp"
+#include "Car/Renderer/SSBO.hpp"
+#include "Car/Renderer/Texture2D.hpp"
+#include "Car/Renderer/UniformBuffer.hpp"
+#include "Car/internal/Vulkan/CompiledShader.hpp"
+#include "Car/internal/Vulkan/DescriptorAllocator.hpp"
+#include <glad/vulkan.h>
+
+#include <unordered_map>
+
+// how many descriptor sets with different contents are kept per set of a shader before the least recently used one
+// that no frame in flight uses gets rewritten
+#ifndef CR_VULKAN_DESCRIPTOR_SET_CACHE_SIZE
+#define CR_VULKAN_DESCRIPTOR_SET_CACHE_SIZE 64
+#endif // CR_VULKAN_DESCRIPTOR_SET_CACHE_SIZE
+
+namespace Car {
+    class VulkanGraphicsContext;
+
+    CR_FORCE_INLINE VkShaderStageFlags DescriptorStageToVulkanStage(DescriptorStage stage) {
+        VkShaderStageFlags flags = 0;
+        if ((uint8_t)stage & (uint8_t)DescriptorStage::VertexShader) {
+            flags |= VK_SHADER_STAGE_VERTEX_BIT;
+        }
+        if ((uint8_t)stage & (uint8_t)DescriptorStage::FragmeantShader) {
+            flags |= VK_SHADER_STAGE_FRAGMENT_BIT;
+        }
+        if ((uint8_t)stage & (uint8_t)DescriptorStage::ComputeShader) {
+            flags |= VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+        return flags;
+    }
+
+    CR_FORCE_INLINE VkDescriptorType DescriptorTypeToVulkanType(DescriptorType type) {
+        switch (type) {
+        case DescriptorType::UniformBuffer:
+            return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        case DescriptorType::Sampler2D:
+        case DescriptorType::BindlessSampler2D:
+            return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        case DescriptorType::StorageBuffer:
+            return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        case DescriptorType::StorageImage:
+            return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        default:
+            throw std::runtime_error("unrecognized DescriptorType " + std::to_string((uint32_t)type));
+        }
+    }
+
+    // the descriptor sets of a graphics or compute shader. setInput only records what a binding should point to,
+    // getDescriptorSets looks the resulting contents of every changed set up in a per set cache and writes the ones
+    // it has not seen before with a single vkUpdateDescriptorSets. a written set is never modified while a frame can
+    // still use it so the same set can be shared by every frame in flight
+    class VulkanShaderDescriptors {
+    public:
+        VulkanShaderDescriptors(VulkanGraphicsContext* pGraphicsContext,
+                                const std::vector<std::vector<Descriptor>>& sets);
+        ~VulkanShaderDescriptors();
+
+        const std::vector<VkDescriptorSetLayout>& getSetLayouts() const { return mDescriptorSetLayouts; }
+        // the sets to bind for the frame, resolves whatever changed since the last call
+        const std::vector<VkDescriptorSet>& getDescriptorSets(uint32_t frame);
+
+        void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<UniformBuffer> ub);
+        void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<Texture2D> texture);
+        void setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<SSBO> ssbo);
+
+        const Descriptor* findDescriptor(uint32_t set, uint32_t binding) const;
+
+    private:
+        // what one descriptor of a set is written with
+        struct BoundResource {
+            VkDescriptorBufferInfo bufferInfo{};
+            VkDescriptorImageInfo imageInfo{};
+            // a set that was written with a destroyed resource is not reused even if a new one got the same handles
+            std::weak_ptr<void> owner;
+            bool isSet = false;
+
+            bool operator==(const BoundResource& other) const;
+        };
+        // one entry per descriptor of the set, in binding order
+        using SetResources = std::vector<BoundResource>;
+
+        struct CachedSet {
+            VulkanDescriptorSet set;
+            SetResources resources;
+            uint64_t hash = 0;
+            uint64_t lastUsedFrame = 0;
+        };
+
+        struct SetCache {
+            std::vector<CachedSet> entries;
+            // hash of the resources -> index into entries
+            std::unordered_map<uint64_t, uint32_t> lookup;
+        };
+
+        // logs and returns false if the binding does not exist or is not of the type
+        bool validateInput(uint32_t set, uint32_t binding, DescriptorType type, const char* typeName) const;
+        BoundResource* getPendingResource(uint32_t frame, uint32_t set, uint32_t binding);
+        // resolves the changed sets of the frame and writes the new ones
+        void flushDescriptorWrites(uint32_t frame);
+        uint32_t acquireCachedSet(uint32_t set, uint64_t hash, const SetResources& resources, bool* pNeedsWrite);
+
+    private:
+        VulkanGraphicsContext* mGraphicsContext;
+        std::vector<std::vector<Descriptor>> mSets;
+
+        std::vector<VkDescriptorSetLayout> mDescriptorSetLayouts;
+        // [frame][set], what is bound for that frame
+        std::vector<std::vector<VkDescriptorSet>> mDescriptorSets;
+        // [frame][set], what setInput asked for
+        std::vector<std::vector<SetResources>> mPendingResources;
+        // [frame], a bit per set that has to be resolved again
+        std::vector<uint32_t> mDirtySets;
+        // [set], empty for the bindless set
+        std::vector<SetCache> mSetCaches;
+    };
+} // namespace Car
@@ -0,0 +1,52 @@
+#pragma once
+
+// used by the runtime compiler and by the shaderCompiler tool so both resolve includes the same way
+// computeShaderSourceHash follows them, needs shaderc
+
+#include "Car/Core/Core.hpp"
+#include "Car/internal/Vulkan/CompiledShader.hpp"
+
+#include <shaderc/shaderc.hpp>
+
+namespace Car {
+    class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface {
+    public:
+        ShaderIncluder(const std::filesystem::path& includeRoot) : mIncludeRoot(includeRoot) {}
+
+        virtual shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type,
+                                                   const char* requestingSource, size_t) override {
+            IncludeData* pData = new IncludeData();
+
+            std::filesystem::path path = resolveShaderInclude(requestingSource, requestedSource,
+                                                              type == shaderc_include_type_relative, mIncludeRoot);
+            if (path.empty()) {
+                // an empty source name is how shaderc is told that the include failed, the content is the error
+                pData->content = std::string("can not find include ") + requestedSource;
+            } else {
+                pData->name = path.string();
+                pData->content = readShaderSource(path);
+            }
+
+            pData->result.source_name = pData->name.c_str();
+            pData->result.source_name_length = pData->name.size();
+            pData->result.content = pData->content.c_str();
+            pData->result.content_length = pData->content.size();
+            pData->result.user_data = pData;
+
+            return &pData->result;
+        }
+
+        virtual void ReleaseInclude(shaderc_include_result* data) override {
+            delete static_cast<IncludeData*>(data->user_data);
+        }
+
+    private:
+        struct IncludeData {
+            shaderc_include_result result;
+            std::string name;
+            std::string content;
+        };
+
+        std::filesystem::path mIncludeRoot;
+    };
+} // namespace Car
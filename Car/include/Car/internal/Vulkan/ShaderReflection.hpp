@@ -0,0 +1,148 @@
+#pragma once
+
+// used by the runtime compiler and by the shaderCompiler tool so both produce the same reflection, needs spirv-cross
+
+#include "Car/Core/Core.hpp"
+#include "Car/internal/Vulkan/CompiledShader.hpp"
+
+#include <spirv_cross/spirv_cross.hpp>
+#include <stdexcept>
+
+namespace Car {
+    namespace ShaderReflection {
+        // the sets are 0..3 per the vulkan spec
+        inline std::vector<Descriptor>& getSet(SingleCompiledShader* pSCS, uint32_t set) {
+            if (set >= 4) {
+                throw std::runtime_error("A shader can have max of 4 sets per the vulkan spec");
+            }
+            if (set >= pSCS->sets.size()) {
+                pSCS->sets.resize(set + 1);
+            }
+            return pSCS->sets[set];
+        }
+
+        inline void addDescriptor(const spirv_cross::Compiler& compiler, const spirv_cross::Resource& resource,
+                                  DescriptorType descriptorType, DescriptorStage stage, SingleCompiledShader* pSCS) {
+            uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+            uint8_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
+            const spirv_cross::SPIRType& type = compiler.get_type(resource.type_id);
+
+            uint32_t count = 1;
+            if (type.array.size() > 1) {
+                throw std::runtime_error("arrays of arrays of descriptors are not supported (" + resource.name + ")");
+            } else if (type.array.size() == 1) {
+                // a runtime sized array has a single dimension of size 0
+                if (type.array[0] == 0) {
+                    if (descriptorType != DescriptorType::Sampler2D) {
+                        throw std::runtime_error("only sampler2D can be runtime sized (" + resource.name + ")");
+                    }
+                    descriptorType = DescriptorType::BindlessSampler2D;
+                } else if (!type.array_size_literal[0]) {
+                    throw std::runtime_error("descriptor arrays sized by specialization constants are not supported (" +
+                                             resource.name + ")");
+                }
+                count = type.array[0];
+            }
+
+            getSet(pSCS, set).push_back({binding, descriptorType, stage, count});
+        }
+
+        inline Shader::VertexInputLayout::DataType vertexInputType(const spirv_cross::SPIRType& type) {
+            using DataType = Shader::VertexInputLayout::DataType;
+            if (type.width != 32 || type.vecsize < 1 || type.vecsize > 4) {
+                return DataType::None;
+            }
+
+            const uint32_t n = type.vecsize - 1;
+            switch (type.basetype) {
+                case spirv_cross::SPIRType::Float:
+                    return (DataType)((uint32_t)DataType::Float + n);
+                case spirv_cross::SPIRType::Int:
+                    return (DataType)((uint32_t)DataType::Int + n);
+                case spirv_cross::SPIRType::UInt:
+                    return (DataType)((uint32_t)DataType::UInt + n);
+                default:
+                    return DataType::None;
+            }
+        }
+
+        // fills the sets, the push constant range, for the vertex stage the vertex inputs and for the compute stage
+        // the workgroup size of pSCS from its spir-v
+        inline void reflect(SingleCompiledShader* pSCS, DescriptorStage stage) {
+            pSCS->sets.clear();
+            pSCS->pushConstant = {};
+            pSCS->vertexInputs.clear();
+            std::fill(std::begin(pSCS->workgroupSize), std::end(pSCS->workgroupSize), 0u);
+
+            spirv_cross::Compiler compiler((uint32_t*)pSCS->shader.data(), pSCS->shader.size() / 4);
+            spirv_cross::ShaderResources resources(compiler.get_shader_resources());
+
+            if (!resources.separate_images.empty() || !resources.separate_samplers.empty()) {
+                throw std::runtime_error("separate images and samplers are not supported, use combined image samplers");
+            }
+
+            for (const auto& resource : resources.uniform_buffers) {
+                addDescriptor(compiler, resource, DescriptorType::UniformBuffer, stage, pSCS);
+            }
+            for (const auto& resource : resources.storage_buffers) {
+                addDescriptor(compiler, resource, DescriptorType::StorageBuffer, stage, pSCS);
+            }
+            for (const auto& resource : resources.sampled_images) {
+                addDescriptor(compiler, resource, DescriptorType::Sampler2D, stage, pSCS);
+            }
+            for (const auto& resource : resources.storage_images) {
+                addDescriptor(compiler, resource, DescriptorType::StorageImage, stage, pSCS);
+            }
+
+            for (auto& set : pSCS->sets) {
+                std::sort(set.begin(), set.end(),
+                          [](const Descriptor& a, const Descriptor& b) { return a.binding < b.binding; });
+            }
+
+            // glsl allows one push_constant block per stage
+            if (!resources.push_constant_buffers.empty()) {
+                const spirv_cross::SPIRType& type = compiler.get_type(resources.push_constant_buffers[0].base_type_id);
+                const uint32_t size = (uint32_t)compiler.get_declared_struct_size(type);
+
+                // blocks of several stages usually share the offsets and only use their own members, the range
+                // starts at the first member
+                uint32_t offset = size;
+                for (uint32_t i = 0; i < type.member_types.size(); i++) {
+                    offset = MIN(offset, compiler.type_struct_member_offset(type, i));
+                }
+
+                if (size > offset) {
+                    pSCS->pushConstant = {offset, size - offset, stage};
+                }
+            }
+
+            if (stage == DescriptorStage::VertexShader) {
+                for (const auto& resource : resources.stage_inputs) {
+                    const spirv_cross::SPIRType& type = compiler.get_type(resource.type_id);
+                    uint32_t location = compiler.get_decoration(resource.id, spv::DecorationLocation);
+
+                    Shader::VertexInputLayout::DataType dataType = vertexInputType(type);
+                    if (dataType == Shader::VertexInputLayout::DataType::None || !type.array.empty()) {
+                        throw std::runtime_error("unsupported vertex input type (" + resource.name + ")");
+                    }
+
+                    // a matrix takes one location per column
+                    for (uint32_t column = 0; column < type.columns; column++) {
+                        pSCS->vertexInputs.push_back({(uint8_t)(location + column), dataType});
+                    }
+                }
+
+                std::sort(pSCS->vertexInputs.begin(), pSCS->vertexInputs.end(),
+                          [](const VertexInput& a, const VertexInput& b) { return a.location < b.location; });
+            }
+
+            if (stage == DescriptorStage::ComputeShader) {
+                // a size given by specialization constants reads as 1, it is only used to pick the group count
+                for (uint32_t i = 0; i < 3; i++) {
+                    const uint32_t size = compiler.get_execution_mode_argument(spv::ExecutionModeLocalSize, i);
+                    pSCS->workgroupSize[i] = MAX(size, 1u);
+                }
+            }
+        }
+    } // namespace ShaderReflection
+} // namespace Car
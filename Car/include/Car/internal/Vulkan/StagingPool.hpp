@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Car/Core/Core.hpp"
+#include "Car/internal/Vulkan/MemoryAllocator.hpp"
+#include <glad/vulkan.h>
+
+#include <mutex>
+
+// smallest staging buffer, everything is rounded up to a power of two from here
+#ifndef CR_VULKAN_STAGING_MIN_SIZE
+#define CR_VULKAN_STAGING_MIN_SIZE (64ull * 1024)
+#endif // CR_VULKAN_STAGING_MIN_SIZE
+
+// how many bytes of unused staging buffers are kept around, the rest is destroyed when it is released
+#ifndef CR_VULKAN_STAGING_POOL_BUDGET
+#define CR_VULKAN_STAGING_POOL_BUDGET (64ull * 1024 * 1024)
+#endif // CR_VULKAN_STAGING_POOL_BUDGET
+
+namespace Car {
+    class VulkanGraphicsContext;
+
+    struct VulkanStagingBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VulkanAllocation allocation;
+        // the size of the buffer, not what was asked for
+        VkDeviceSize size = 0;
+        uint32_t bucket = 0;
+
+        uint8_t* data() const { return allocation.mapped; }
+    };
+
+    // host visible and persistently mapped transfer source buffers in power of two buckets. a buffer goes back into
+    // its bucket when the copy that reads it is done, for the upload queue that is when the timeline of its batch
+    // is reached and for the synchronous copies right after them
+    class VulkanStagingPool {
+    public:
+        struct Stats {
+            uint32_t bufferCount = 0;
+            uint32_t freeBufferCount = 0;
+            VkDeviceSize freeBytes = 0;
+            // acquires that were served by a recycled buffer
+            uint64_t reuseCount = 0;
+            uint64_t createCount = 0;
+        };
+
+    public:
+        VulkanStagingPool(VulkanGraphicsContext* pGraphicsContext);
+        ~VulkanStagingPool();
+
+        VulkanStagingBuffer acquire(VkDeviceSize size);
+        // the gpu must be done with the buffer
+        void release(VulkanStagingBuffer* pBuffer);
+
+        // destroys every buffer that is not in use
+        void trim();
+
+        Stats getStats() const;
+
+    private:
+        void destroy(VulkanStagingBuffer* pBuffer);
+
+    private:
+        VulkanGraphicsContext* mGraphicsContext;
+
+        std::vector<std::vector<VulkanStagingBuffer>> mFreeBuffers;
+        VkDeviceSize mFreeBytes = 0;
+        uint32_t mBufferCount = 0;
+
+        uint64_t mReuseCount = 0;
+        uint64_t mCreateCount = 0;
+
+        mutable std::mutex mMutex;
+    };
+} // namespace Car
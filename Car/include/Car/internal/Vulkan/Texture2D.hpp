@@ -16,12 +16,19 @@ namespace Car {
         virtual ~VulkanTexture2D() override;
 
         virtual void updateData(const std::string& filepath, bool flipped = false) override;
+        virtual void updateRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                                  const void* pBuffer) override;
 
         virtual uint32_t getWidth() const override { return mWidth; }
         virtual uint32_t getHeight() const override { return mHeight; }
 
         virtual Rect getRect() const override { return {0.0f, 0.0f, (float)mWidth, (float)mHeight}; }
 
+        virtual uint32_t getBindlessIndex() const override { return mBindlessIndex; }
+
+        virtual bool isReady() const override;
+        virtual void wait() const override;
+
         virtual bool operator==(Ref<Texture2D> other) const override {
             return static_cast<const void*>(this) == static_cast<const void*>(other.get());
         }
@@ -44,12 +51,16 @@ namespace Car {
     private:
         uint32_t mWidth;
         uint32_t mHeight;
+        uint32_t mBindlessIndex;
 
         Ref<VulkanGraphicsContext> mGraphicsContext;
 
         VkImage mImage;
-        VkDeviceMemory mImageMemory;
+        VulkanAllocation mImageAllocation;
         VkImageView mImageView;
         VkSampler mSampler;
+
+        // timeline value of the upload queue the pixels are in the image at
+        uint64_t mUploadValue = 0;
     };
 } // namespace Car
@@ -24,8 +24,7 @@ namespace Car {
         Buffer::Usage mUsage;
 
         std::vector<VkBuffer> mBuffers;
-        std::vector<VkDeviceMemory> mBuffersMemory;
-        std::vector<void*> mBuffersMapped;
+        std::vector<VulkanAllocation> mAllocations;
 
         Ref<VulkanGraphicsContext> mGraphicsContext;
     };
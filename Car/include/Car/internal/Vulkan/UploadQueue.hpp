@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Car/Core/Core.hpp"
+#include "Car/internal/Vulkan/StagingPool.hpp"
+#include <glad/vulkan.h>
+
+#include <deque>
+#include <mutex>
+
+namespace Car {
+    class VulkanGraphicsContext;
+
+    // uploads are recorded into a batch on the transfer queue that is submitted once per frame (or as soon as
+    // something waits on it) instead of a submit and vkQueueWaitIdle per copy. every upload returns the value of a
+    // timeline semaphore its data is ready at, the frame submit waits on it so a resource can be drawn right after
+    // it is created. if the transfer queue is from another family the ownership is released to the graphics family
+    // and acquired there by a small graphics submit before the value is signaled. images that are already in use are
+    // handed from the graphics queue to the transfer queue by another small graphics submit before the transfer one,
+    // submitted after every frame that might still sample them
+    class VulkanUploadQueue {
+    public:
+        VulkanUploadQueue(VulkanGraphicsContext* pGraphicsContext, uint32_t transferFamily, uint32_t graphicsFamily);
+        ~VulkanUploadQueue();
+
+        uint64_t uploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+        // the image has to be new (VK_IMAGE_LAYOUT_UNDEFINED), it ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        uint64_t uploadImage2D(VkImage image, const void* data, uint32_t width, uint32_t height);
+        // the image has to be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL and owned by the graphics family (anything
+        // that went through uploadImage2D), imageValue is the value returned by its last upload
+        uint64_t uploadImage2DRegion(VkImage image, const void* data, uint32_t x, uint32_t y, uint32_t width,
+                                     uint32_t height, uint64_t imageValue);
+
+        // submits the batch that is being recorded, returns the value everything uploaded so far is ready at
+        uint64_t flush();
+        bool isComplete(uint64_t value) const;
+        void wait(uint64_t value);
+        void waitIdle();
+        // hands the staging buffers back to the staging pool and recycles the command buffers of the batches that are done
+        void collect();
+
+        VkSemaphore getTimelineSemaphore() const { return mTimelineSemaphore; }
+
+    private:
+        struct Batch {
+            VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE;
+            VkCommandBuffer graphicsCommandBuffer = VK_NULL_HANDLE;
+            VkCommandBuffer releaseCommandBuffer = VK_NULL_HANDLE;
+            std::vector<VulkanStagingBuffer> stagingBuffers;
+            // recorded on the graphics queue before the transfer submit for the images that are already in use
+            std::vector<VkImageMemoryBarrier> imageReleases;
+            // recorded on the graphics queue when the families differ
+            std::vector<VkBufferMemoryBarrier> bufferAcquires;
+            std::vector<VkImageMemoryBarrier> imageAcquires;
+            uint64_t value = 0;
+        };
+
+        void beginBatch();
+        uint64_t flushLocked();
+        VulkanStagingBuffer& createStagingBuffer(const void* data, VkDeviceSize size);
+        VkCommandBuffer getCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList);
+        void submit(VkQueue queue, VkCommandBuffer commandBuffer, uint64_t waitValue, uint64_t signalValue);
+
+    private:
+        VulkanGraphicsContext* mGraphicsContext;
+        VkDevice mDevice;
+
+        uint32_t mTransferFamily;
+        uint32_t mGraphicsFamily;
+        bool mOwnershipTransfer;
+
+        VkSemaphore mTimelineSemaphore;
+        // the value the last batch will signal and the value of the last submitted batch
+        uint64_t mNextValue = 0;
+        uint64_t mSubmittedValue = 0;
+
+        VkCommandPool mTransferCommandPool;
+        VkCommandPool mGraphicsCommandPool;
+        std::vector<VkCommandBuffer> mFreeTransferCommandBuffers;
+        std::vector<VkCommandBuffer> mFreeGraphicsCommandBuffers;
+
+        Batch mBatch;
+        bool mRecording = false;
+        std::deque<Batch> mInFlightBatches;
+
+        mutable std::mutex mMutex;
+    };
+} // namespace Car
@@ -19,12 +19,37 @@ namespace Car {
 
         virtual void updateData(void* data, uint64_t size, uint64_t offset) override;
 
+        virtual void* reserveStream(uint64_t minSize, uint64_t* pCapacity) override;
+        virtual void commitStream(uint64_t size) override;
+
+    private:
+        struct StreamBlock {
+            VkBuffer buffer;
+            VulkanAllocation allocation;
+            uint8_t* mapped;
+            uint64_t size;
+        };
+        // blocks are only reused once the frame that wrote to them has finished so the gpu never reads memory that is
+        // being overwritten
+        struct StreamArena {
+            std::vector<StreamBlock> blocks;
+            uint32_t currentBlock = 0;
+            uint64_t head = 0;
+            uint64_t frameCount = UINT64_MAX;
+        };
+
+        void createStreamBlock(StreamArena& arena, uint64_t size);
+        StreamArena& getCurrentStreamArena();
+
     private:
         uint64_t mSize;
         Buffer::Usage mUsage;
 
         Ref<VulkanGraphicsContext> mGraphicsContext;
-        VkBuffer mBuffer;
-        VkDeviceMemory mBufferMemory;
+        VkBuffer mBuffer = VK_NULL_HANDLE;
+        VulkanAllocation mAllocation;
+        VkDeviceSize mBindOffset = 0;
+
+        std::vector<StreamArena> mStreamArenas;
     };
 } // namespace Car
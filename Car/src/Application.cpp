@@ -1,11 +1,11 @@
 #include "Car/Application.hpp"
+#include "Car/Jobs.hpp"
 #include "Car/Core/Log.hpp"
 #include "Car/ResourceManager.hpp"
 #include "Car/Renderer/Renderer2D.hpp"
 #include "Car/Random.hpp"
+#include "Car/RenderThread.hpp"
 #include "Car/Renderer/Renderer.hpp"
-#include "Car/Time.hpp"
-#include <chrono>
 
 namespace Car {
     Application* sInstance = nullptr;
@@ -18,7 +18,15 @@ namespace Car {
         if (spec.targetFPS <= 0 && spec.targetFPS != -1) {
             CR_CORE_ERROR("targetFPS can either be a positive integer or -1");
         }
+        if (spec.fixedUpdateRate <= 0 && spec.fixedUpdateRate != -1) {
+            CR_CORE_ERROR("fixedUpdateRate can either be a positive integer or -1");
+        }
+        if (spec.framesInFlight == 0) {
+            CR_CORE_ERROR("framesInFlight has to be at least 1");
+        }
         sSpec = spec;
+        sSpec.framesInFlight = MAX(sSpec.framesInFlight, 1u);
+        sSpec.maxFixedUpdatesPerFrame = MAX(sSpec.maxFixedUpdatesPerFrame, 1u);
     }
 
     Application::Application() {
@@ -27,12 +35,18 @@ namespace Car {
         sInstance = this;
 
         Window::Specification windowSpec = {sSpec.width, sSpec.height, sSpec.title, sSpec.resizable,
-                                            CR_BIND_FN1(Car::Application::onEvent)};
+                                            CR_BIND_FN1(Car::Application::onEvent), sSpec.framesInFlight};
 
         mWindow = createRef<Car::Window>(windowSpec);
         mWindow->init();
 
+        mFramePacer.setTargetFPS(sSpec.targetFPS);
+        if (sSpec.fixedUpdateRate > 0) {
+            mFixedDeltaTime = 1.0 / (double)sSpec.fixedUpdateRate;
+        }
+
         Random::Init();
+        Jobs::Init(sSpec.jobWorkers);
         ResourceManager::Init();
         Renderer::Init();
         Renderer2D::Init();
@@ -43,6 +57,8 @@ namespace Car {
             (*--it)->onDetach();
             CR_CORE_DEBUG("Layer destroyed");
         }
+        // the jobs might still hold on to resources
+        Jobs::Shutdown();
         Renderer2D::Shutdown();
         Renderer::Shutdown();
         ResourceManager::Shutdown();
@@ -55,58 +71,103 @@ namespace Car {
         if (sSpec.useImGui) {
             mImGuiLayer.onAttach();
         }
-        double lastFrameTime = 0.0;
+        if (sSpec.renderThread) {
+            mRenderThread = createScope<RenderThread>();
+        }
         while (isRunning) {
-            double dt;
-            if (lastFrameTime == 0) {
-                dt = 1.0 / 60.0;
-                lastFrameTime = (double)Time::GetMicro() / 1000.0;
-            } else {
-                double time = (double)Time::GetMicro() / 1000.0;
-                dt = (time - lastFrameTime) / 1000.0;
-                lastFrameTime = time;
+            double dt = mFramePacer.beginFrame();
+
+            if (sSpec.lowLatency) {
+                if (mRenderThread) {
+                    mRenderThread->waitIdle();
+                } else {
+                    mWindow->getGraphicsContext()->waitForFrame();
+                }
+            }
+            mWindow->pollEvents();
+            mFramePacer.markInputSampled();
+            // a close request from the events of this frame
+            if (!isRunning) {
+                break;
             }
 
+            Jobs::RunMainThreadContinuations();
+
+            double alpha = runFixedUpdates(dt);
+
             onUpdate(dt);
 
             for (Layer* layer : mLayerStack) {
                 layer->onUpdate(dt);
             }
 
-            Renderer::BeginRecording();
-            Car::Renderer2D::Begin();
-            onRender();
+            if (mRenderThread) {
+                mRenderThread->beginPacket();
+            } else {
+                Renderer::BeginRecording();
+                Car::Renderer2D::Begin();
+            }
+            onRender(alpha);
             for (Layer* layer : mLayerStack) {
-                layer->onRender();
+                layer->onRender(alpha);
             }
 
+            ImDrawData* imguiDrawData = nullptr;
             if (sSpec.useImGui) {
                 mImGuiLayer.begin();
                 for (Layer* layer : mLayerStack) {
                     layer->onImGuiRender(dt);
                 }
                 onImGuiRender(dt);
-                mImGuiLayer.end();
+                if (mRenderThread) {
+                    imguiDrawData = mImGuiLayer.endFrame();
+                } else {
+                    mImGuiLayer.end();
+                }
             }
-            Car::Renderer2D::End();
-            Renderer::EndRecording();
 
-            mWindow->onUpdate();
+            if (mRenderThread) {
+                mRenderThread->submitPacket(imguiDrawData);
+            } else {
+                Car::Renderer2D::End();
+                Renderer::EndRecording();
+                mWindow->swapBuffers();
+            }
+            // with a render thread this is when the packet was handed over
+            mFramePacer.markSubmitted();
 
-            // TODO: This
-            // if (sSpec.targetFPS != -1) {
-            //     int64_t timeToSleep = int64_t(1000.0 / (double)sSpec.targetFPS - dt * 1000);
-            //     CR_CORE_INFO("sleeping for {} {}", timeToSleep, dt * 1000);
-            //     if (timeToSleep > 0) {
-            //         std::this_thread::sleep_for(std::chrono::microseconds(timeToSleep * 1000));
-            //     }
-            // }
+            mFramePacer.waitForNextFrame();
         }
+        mRenderThread.reset();
         if (sSpec.useImGui) {
             mImGuiLayer.onDetach();
         }
     }
 
+    double Application::runFixedUpdates(double dt) {
+        if (mFixedDeltaTime == 0.0) {
+            return 1.0;
+        }
+
+        mFixedAccumulator += dt;
+
+        // spiral of death, if a frame can not keep up with its ticks the next one would have even more of them
+        const double maxAccumulated = mFixedDeltaTime * (double)sSpec.maxFixedUpdatesPerFrame;
+        if (mFixedAccumulator > maxAccumulated) {
+            mFixedAccumulator = maxAccumulated;
+        }
+
+        while (mFixedAccumulator >= mFixedDeltaTime) {
+            onFixedUpdate(mFixedDeltaTime);
+            for (Layer* layer : mLayerStack) {
+                layer->onFixedUpdate(mFixedDeltaTime);
+            }
+            mFixedAccumulator -= mFixedDeltaTime;
+        }
+
+        return mFixedAccumulator / mFixedDeltaTime;
+    }
+
     void Application::onEvent(Event& event) {
         EventDispatcher dispatcher(event);
 
@@ -0,0 +1,121 @@
+#include "Car/FramePacer.hpp"
+#include "Car/Core/Log.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace Car {
+    FramePacer::FramePacer(int32_t targetFPS) { setTargetFPS(targetFPS); }
+
+    void FramePacer::setTargetFPS(int32_t targetFPS) {
+        CR_IF (targetFPS <= 0 && targetFPS != -1) {
+            CR_CORE_ERROR("Car::FramePacer::setTargetFPS(targetFPS), targetFPS can either be a positive integer or -1");
+            targetFPS = -1;
+        }
+
+        mTargetFPS = targetFPS;
+        mPeriod = targetFPS == -1 ? 0.0 : 1.0 / (double)targetFPS;
+        // the next wait starts the schedule over
+        mNextDeadline = 0.0;
+    }
+
+    double FramePacer::Now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    double FramePacer::beginFrame() {
+        const double now = Now();
+        const double dt = mFrameStart == 0.0 ? 1.0 / 60.0 : now - mFrameStart;
+        mFrameStart = now;
+        // no input reading this frame unless it is marked
+        mInputSampled = 0.0;
+
+        mFrameTimes[mHistoryIndex] = dt;
+
+        return dt;
+    }
+
+    void FramePacer::markInputSampled() { mInputSampled = Now(); }
+
+    void FramePacer::markSubmitted() {
+        mInputLatencies[mHistoryIndex] = mInputSampled == 0.0 ? 0.0 : Now() - mInputSampled;
+    }
+
+    void FramePacer::waitForNextFrame() {
+        double wakeError = 0.0;
+
+        if (mPeriod > 0.0) {
+            const double now = Now();
+            mNextDeadline += mPeriod;
+            // too far behind (or the first frame), catching up would only make a burst of short frames
+            if (mNextDeadline < now - mPeriod) {
+                mNextDeadline = now;
+            }
+
+            if (mNextDeadline > now) {
+                sleepUntil(mNextDeadline);
+                wakeError = Now() - mNextDeadline;
+            }
+        }
+
+        mWakeErrors[mHistoryIndex] = wakeError;
+        mHistoryIndex = (mHistoryIndex + 1) % CR_FRAME_PACER_HISTORY;
+        mHistoryCount = MIN(mHistoryCount + 1, (uint32_t)CR_FRAME_PACER_HISTORY);
+        updateStats();
+    }
+
+    void FramePacer::sleepUntil(double deadline) {
+        // sleep in small steps while the remaining time is longer than a sleep is expected to take, the estimate
+        // follows the scheduler of the os so it works without raising the timer resolution
+        while (true) {
+            const double remaining = deadline - Now();
+            const double estimate = mSleepMean + std::sqrt(mSleepVariance);
+            if (remaining <= estimate) {
+                break;
+            }
+
+            const double start = Now();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            const double observed = Now() - start;
+
+            // a plain running mean and variance until the count is capped, from then on an exponentially weighted one
+            // so the estimate keeps following the os instead of settling forever
+            mSleepCount = MIN(mSleepCount + 1, (uint64_t)1000);
+            const double weight = 1.0 / (double)mSleepCount;
+            const double delta = observed - mSleepMean;
+            mSleepMean += weight * delta;
+            mSleepVariance = (1.0 - weight) * (mSleepVariance + weight * delta * delta);
+        }
+
+        // the rest is shorter than a sleep can be trusted with
+        while (Now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+
+    void FramePacer::updateStats() {
+        Stats stats;
+        stats.minFrameTime = mFrameTimes[0];
+
+        for (uint32_t i = 0; i < mHistoryCount; i++) {
+            stats.averageFrameTime += mFrameTimes[i];
+            stats.minFrameTime = MIN(stats.minFrameTime, mFrameTimes[i]);
+            stats.maxFrameTime = MAX(stats.maxFrameTime, mFrameTimes[i]);
+            stats.averageInputLatency += mInputLatencies[i];
+            stats.maxInputLatency = MAX(stats.maxInputLatency, mInputLatencies[i]);
+            stats.averageWakeError += mWakeErrors[i];
+        }
+        stats.averageFrameTime /= (double)mHistoryCount;
+        stats.averageInputLatency /= (double)mHistoryCount;
+        stats.averageWakeError /= (double)mHistoryCount;
+
+        for (uint32_t i = 0; i < mHistoryCount; i++) {
+            const double delta = mFrameTimes[i] - stats.averageFrameTime;
+            stats.frameTimeVariance += delta * delta;
+        }
+        stats.frameTimeVariance /= (double)mHistoryCount;
+
+        mStats = stats;
+    }
+} // namespace Car
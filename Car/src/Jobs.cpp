@@ -0,0 +1,288 @@
+#include "Car/Jobs.hpp"
+#include "Car/Core/Log.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace Car::Jobs {
+    struct Task {
+        Job job;
+        Handle counter;
+    };
+
+    struct Counter {
+        // jobs of the group that did not finish
+        std::atomic<uint32_t> pending;
+
+        std::mutex mutex;
+        // under the mutex, set once pending hits zero so nothing can be added after the waiting list was taken
+        bool done = false;
+        // tasks that depend on this counter
+        std::vector<Task> dependents;
+        std::vector<Job> continuations;
+
+        Counter(uint32_t count) : pending(count), done(count == 0) {}
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    struct JobsData {
+        std::vector<Scope<Worker>> workers;
+        // where the next job of a thread that is not a worker goes
+        std::atomic<uint32_t> nextWorker = 0;
+
+        // tasks sitting in any of the deques, the workers sleep while it is zero
+        std::atomic<uint32_t> queued = 0;
+        std::mutex sleepMutex;
+        std::condition_variable wakeCondition;
+        bool stop = false;
+
+        std::mutex continuationsMutex;
+        std::vector<Job> continuations;
+    };
+
+    static JobsData* sData = nullptr;
+    static thread_local int32_t tWorkerIndex = -1;
+
+    static void push(Task task) {
+        uint32_t index = tWorkerIndex != -1 ? (uint32_t)tWorkerIndex
+                                            : sData->nextWorker.fetch_add(1) % sData->workers.size();
+        Worker& worker = *sData->workers[index];
+
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.tasks.push_back(std::move(task));
+        }
+
+        {
+            // taken so a worker between checking queued and going to sleep can not miss the notification
+            std::lock_guard<std::mutex> lock(sData->sleepMutex);
+            sData->queued++;
+        }
+        sData->wakeCondition.notify_one();
+    }
+
+    // the own deque from the back first, then the others from the front
+    static bool pop(Task* pTask) {
+        const uint32_t workerCount = sData->workers.size();
+        const uint32_t first = tWorkerIndex != -1 ? (uint32_t)tWorkerIndex : sData->nextWorker.load() % workerCount;
+
+        for (uint32_t i = 0; i < workerCount; i++) {
+            Worker& worker = *sData->workers[(first + i) % workerCount];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (worker.tasks.empty()) {
+                continue;
+            }
+
+            if (i == 0 && tWorkerIndex != -1) {
+                *pTask = std::move(worker.tasks.back());
+                worker.tasks.pop_back();
+            } else {
+                *pTask = std::move(worker.tasks.front());
+                worker.tasks.pop_front();
+            }
+            sData->queued--;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    // the task waits on the dependency if it is not done yet
+    static void pushAfter(Task task, const Handle& dependency) {
+        if (dependency != nullptr) {
+            std::lock_guard<std::mutex> lock(dependency->mutex);
+            if (!dependency->done) {
+                dependency->dependents.push_back(std::move(task));
+                return;
+            }
+        }
+
+        push(std::move(task));
+    }
+
+    static void finish(const Handle& counter) {
+        if (counter->pending.fetch_sub(1) != 1) {
+            return;
+        }
+
+        std::vector<Task> dependents;
+        std::vector<Job> continuations;
+        {
+            std::lock_guard<std::mutex> lock(counter->mutex);
+            counter->done = true;
+            dependents.swap(counter->dependents);
+            continuations.swap(counter->continuations);
+        }
+
+        for (Task& task : dependents) {
+            push(std::move(task));
+        }
+
+        if (!continuations.empty()) {
+            std::lock_guard<std::mutex> lock(sData->continuationsMutex);
+            for (Job& continuation : continuations) {
+                sData->continuations.push_back(std::move(continuation));
+            }
+        }
+    }
+
+    static void execute(Task& task) {
+        task.job();
+        finish(task.counter);
+    }
+
+    static void workerMain(int32_t index) {
+        tWorkerIndex = index;
+
+        while (true) {
+            Task task;
+            if (pop(&task)) {
+                execute(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sData->sleepMutex);
+            // everything scheduled before Shutdown still runs
+            if (sData->stop && sData->queued == 0) {
+                break;
+            }
+            sData->wakeCondition.wait(lock, [] { return sData->stop || sData->queued > 0; });
+        }
+    }
+
+    void Init(uint32_t workerCount) {
+        CR_IF (sData != nullptr) {
+            CR_CORE_ERROR("Car::Jobs already initialized");
+            return;
+        }
+
+        if (workerCount == 0) {
+            uint32_t cores = std::thread::hardware_concurrency();
+            workerCount = cores > 1 ? cores - 1 : 1;
+        }
+
+        sData = new JobsData();
+        sData->workers.resize(workerCount);
+        for (Scope<Worker>& worker : sData->workers) {
+            worker = createScope<Worker>();
+        }
+        // started after every deque exists since they steal from each other
+        for (uint32_t i = 0; i < workerCount; i++) {
+            sData->workers[i]->thread = std::thread(workerMain, (int32_t)i);
+        }
+
+        CR_CORE_DEBUG("Car::Jobs initialized with {} workers", workerCount);
+    }
+
+    void Shutdown() {
+        CR_IF (sData == nullptr) {
+            CR_CORE_ERROR("Car::Jobs not initialized");
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(sData->sleepMutex);
+            sData->stop = true;
+        }
+        sData->wakeCondition.notify_all();
+
+        for (Scope<Worker>& worker : sData->workers) {
+            worker->thread.join();
+        }
+
+        delete sData;
+        sData = nullptr;
+
+        CR_CORE_DEBUG("Car::Jobs shutdown");
+    }
+
+    uint32_t GetWorkerCount() { return sData != nullptr ? sData->workers.size() : 0; }
+
+    int32_t GetWorkerIndex() { return tWorkerIndex; }
+
+    Handle Schedule(Job job, const Handle& dependency) {
+        Handle counter = createRef<Counter>(1);
+        pushAfter({std::move(job), counter}, dependency);
+
+        return counter;
+    }
+
+    Handle ParallelFor(uint32_t begin, uint32_t end, RangeJob job, uint32_t grainSize, const Handle& dependency) {
+        if (end <= begin) {
+            return createRef<Counter>(0);
+        }
+
+        const uint32_t count = end - begin;
+        if (grainSize == 0) {
+            // a few ranges per worker so the ones that finish early have something to steal
+            grainSize = MAX(count / (GetWorkerCount() * 4), 1u);
+        }
+
+        const uint32_t rangeCount = (count + grainSize - 1) / grainSize;
+        Handle counter = createRef<Counter>(rangeCount);
+
+        // shared between the ranges instead of copied into each of them
+        Ref<RangeJob> sharedJob = createRef<RangeJob>(std::move(job));
+        for (uint32_t i = 0; i < rangeCount; i++) {
+            uint32_t rangeBegin = begin + i * grainSize;
+            uint32_t rangeEnd = MIN(rangeBegin + grainSize, end);
+            pushAfter({[sharedJob, rangeBegin, rangeEnd]() { (*sharedJob)(rangeBegin, rangeEnd); }, counter},
+                      dependency);
+        }
+
+        return counter;
+    }
+
+    void ParallelForAndWait(uint32_t begin, uint32_t end, RangeJob job, uint32_t grainSize) {
+        Wait(ParallelFor(begin, end, std::move(job), grainSize));
+    }
+
+    bool IsDone(const Handle& handle) { return handle == nullptr || handle->pending.load() == 0; }
+
+    void Wait(const Handle& handle) {
+        while (!IsDone(handle)) {
+            Task task;
+            if (pop(&task)) {
+                execute(task);
+            } else {
+                // the rest is already running on other threads
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void OnMainThread(const Handle& handle, Job continuation) {
+        if (handle != nullptr) {
+            std::lock_guard<std::mutex> lock(handle->mutex);
+            if (!handle->done) {
+                handle->continuations.push_back(std::move(continuation));
+                return;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(sData->continuationsMutex);
+        sData->continuations.push_back(std::move(continuation));
+    }
+
+    void RunMainThreadContinuations() {
+        std::vector<Job> continuations;
+        {
+            std::lock_guard<std::mutex> lock(sData->continuationsMutex);
+            continuations.swap(sData->continuations);
+        }
+
+        // continuations can schedule more of them, those run next frame
+        for (Job& continuation : continuations) {
+            continuation();
+        }
+    }
+} // namespace Car::Jobs
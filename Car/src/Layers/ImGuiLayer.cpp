@@ -66,16 +66,19 @@ namespace Car {
         info.QueueFamily =
             graphicsContext->findQueueFamilies(graphicsContext->getPhysicalDevice()).graphicsFamily.value();
         info.Queue = graphicsContext->getGraphicsQueue();
-        info.DescriptorPool = graphicsContext->getDescriptorPool();
+        info.PipelineCache = graphicsContext->getPipelineCache();
+        info.DescriptorPool = graphicsContext->getImGuiDescriptorPool();
         info.RenderPass = graphicsContext->getRenderPass();
         info.MinImageCount = 3;
         info.ImageCount = 3;
         info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
         ImGui_ImplVulkan_Init(&info);
+        // NewFrame would otherwise upload it from whichever thread gets there first
+        ImGui_ImplVulkan_CreateFontsTexture();
     }
 
     void ImGuiLayer::onDetach() {
-        vkDeviceWaitIdle(reinterpretCastRef<VulkanGraphicsContext>(GraphicsContext::Get())->getDevice());
+        reinterpretCastRef<VulkanGraphicsContext>(GraphicsContext::Get())->waitIdle();
         ImGui_ImplVulkan_Shutdown();
         ImGui_ImplGlfw_Shutdown();
         ImGui::DestroyContext();
@@ -110,16 +113,24 @@ namespace Car {
     void ImGuiLayer::end() {
         ImGuiIO& io = ImGui::GetIO();
 
-        // Rendering
-        ImGui::Render();
-        ImGui_ImplVulkan_RenderDrawData(
-            ImGui::GetDrawData(),
-            reinterpretCastRef<VulkanGraphicsContext>(GraphicsContext::Get())->getCurrentRenderCommandBuffer(),
-            nullptr);
+        draw(endFrame());
 
         if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
             ImGui::UpdatePlatformWindows();
             ImGui::RenderPlatformWindowsDefault();
         }
     }
+
+    ImDrawData* ImGuiLayer::endFrame() {
+        ImGui::Render();
+
+        return ImGui::GetDrawData();
+    }
+
+    void ImGuiLayer::draw(ImDrawData* drawData) {
+        Ref<VulkanGraphicsContext> graphicsContext = reinterpretCastRef<VulkanGraphicsContext>(GraphicsContext::Get());
+        ImGui_ImplVulkan_RenderDrawData(drawData, graphicsContext->getCurrentRenderCommandBuffer(), nullptr);
+        // imgui binds its own pipeline and descriptor sets
+        graphicsContext->resetBoundGraphicsState();
+    }
 } // namespace Car
@@ -0,0 +1,121 @@
+#include "Car/RenderThread.hpp"
+#include "Car/Renderer/GraphicsContext.hpp"
+#include "Car/Renderer/Renderer.hpp"
+
+namespace Car {
+    RenderThread::RenderThread() {
+        for (FramePacket& packet : mPackets) {
+            packet.context = Renderer2D::CreateContext();
+        }
+
+        mThread = std::thread(&RenderThread::run, this);
+    }
+
+    RenderThread::~RenderThread() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mCondition.notify_all();
+        mThread.join();
+
+        // imgui allocations are only touched from the main thread
+        for (FramePacket& packet : mPackets) {
+            releaseImGuiDrawLists(packet);
+        }
+    }
+
+    RenderThread::FramePacket& RenderThread::beginPacket() {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] {
+                return mRenderingIndex != (int32_t)mWriteIndex && mPendingIndex != (int32_t)mWriteIndex;
+            });
+        }
+
+        FramePacket& packet = mPackets[mWriteIndex];
+        releaseImGuiDrawLists(packet);
+        Renderer2D::BindContext(packet.context);
+
+        return packet;
+    }
+
+    void RenderThread::submitPacket(ImDrawData* imguiDrawData) {
+        Renderer2D::BindContext(nullptr);
+
+        FramePacket& packet = mPackets[mWriteIndex];
+        packet.hasImGui = imguiDrawData != nullptr;
+        if (packet.hasImGui) {
+            packet.imguiDrawData = *imguiDrawData;
+            for (int i = 0; i < imguiDrawData->CmdLists.Size; i++) {
+                packet.imguiDrawData.CmdLists[i] = imguiDrawData->CmdLists[i]->CloneOutput();
+            }
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mPendingIndex == -1; });
+            mPendingIndex = mWriteIndex;
+        }
+        mCondition.notify_all();
+
+        mWriteIndex = (mWriteIndex + 1) % mPackets.size();
+    }
+
+    void RenderThread::waitIdle() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] { return mPendingIndex == -1 && mRenderingIndex == -1; });
+    }
+
+    void RenderThread::run() {
+        while (true) {
+            int32_t index;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this] { return mStop || mPendingIndex != -1; });
+                // whatever was submitted before stopping is still rendered
+                if (mPendingIndex == -1) {
+                    break;
+                }
+                index = mPendingIndex;
+                mPendingIndex = -1;
+                mRenderingIndex = index;
+            }
+            mCondition.notify_all();
+
+            render(mPackets[index]);
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mRenderingIndex = -1;
+            }
+            mCondition.notify_all();
+        }
+    }
+
+    void RenderThread::render(FramePacket& packet) {
+        Renderer::BeginRecording();
+        Renderer2D::Begin();
+        Renderer2D::SubmitContext(packet.context);
+        Renderer2D::End();
+
+        if (packet.hasImGui) {
+            ImGuiLayer::draw(&packet.imguiDrawData);
+        }
+
+        Renderer::EndRecording();
+        GraphicsContext::Get()->swapBuffers();
+    }
+
+    void RenderThread::releaseImGuiDrawLists(FramePacket& packet) {
+        if (!packet.hasImGui) {
+            return;
+        }
+
+        for (ImDrawList* drawList : packet.imguiDrawData.CmdLists) {
+            IM_DELETE(drawList);
+        }
+        packet.imguiDrawData.Clear();
+        packet.hasImGui = false;
+    }
+} // namespace Car
@@ -3,105 +3,310 @@
 
 #include <cstdint>
 #include <cstring>
+#include <mutex>
 
 #include <ft2build.h>
 #include <freetype/freetype.h>
 
-// no questions asked
-#define heightPadding 20
+// space between glyphs so linear filtering doesnt bleed into the neighbours
+#define glyphPadding 1
+
+#define CR_FONT_HAS_SDF (FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 11))
 
 namespace Car {
     static bool sFreeTypeInitialized = false;
     static FT_Library sFt;
+    // fonts can be loaded on worker threads, creating and destroying faces of the library has to be serialized.
+    // everything else only touches the face of the font
+    static std::mutex sFreeTypeMutex;
 
-    Font::Font(const std::string& path, uint32_t height, const std::string& charsToLoad) {
-        mHeight = height;
-        mCharacters.resize(255);
-        if (!sFreeTypeInitialized) {
-            CR_VERIFYN(FT_Init_FreeType(&sFt), "ERROR::FREETYPE: Could not init FreeType Library");
-            sFreeTypeInitialized = true;
+    static uint32_t nextPowerOfTwo(uint32_t v) {
+        uint32_t p = 1;
+        while (p < v) {
+            p <<= 1;
         }
+        return p;
+    }
+
+    Font::Font(const std::string& path, uint32_t height, const std::string& charsToLoad, bool sdf) {
+        mHeight = height;
+        mSDF = sdf;
+        mASCIIGlyphs.resize(128);
 
         if (!std::filesystem::exists(path)) {
             throw std::runtime_error("`" + path + "` doesnt exist");
         }
 
-        FT_Face face;
-        CR_VERIFYN(FT_New_Face(sFt, path.c_str(), 0, &face), "ERROR::FREETYPE: Failed to load font");
+#if !CR_FONT_HAS_SDF
+        if (mSDF) {
+            throw std::runtime_error("sdf fonts need FreeType 2.11 or newer");
+        }
+#endif
+
+        {
+            std::lock_guard<std::mutex> lock(sFreeTypeMutex);
+            if (!sFreeTypeInitialized) {
+                CR_VERIFYN(FT_Init_FreeType(&sFt), "ERROR::FREETYPE: Could not init FreeType Library");
+                sFreeTypeInitialized = true;
+            }
+
+            CR_VERIFYN(FT_New_Face(sFt, path.c_str(), 0, &mFace), "ERROR::FREETYPE: Failed to load font");
+        }
+
+        FT_Set_Pixel_Sizes(mFace, 0, height);
+        mAscender = (uint32_t)(mFace->size->metrics.ascender >> 6);
+        mHasKerning = FT_HAS_KERNING(mFace);
+
+        // roughly 16 glyphs per row, the atlas grows downwards when it runs out of space
+        mAtlasWidth = CLAMP(nextPowerOfTwo(height * 16), 256u, (uint32_t)CR_FONT_MAX_ATLAS_SIZE);
+        mAtlasHeight = MIN(nextPowerOfTwo(height * 4), (uint32_t)CR_FONT_MAX_ATLAS_SIZE);
+        mPixels.resize(mAtlasWidth * mAtlasHeight * 4);
+        // white with the coverage (or distance) in the alpha
+        for (size_t i = 0; i < mPixels.size(); i += 4) {
+            mPixels[i + 0] = 255;
+            mPixels[i + 1] = 255;
+            mPixels[i + 2] = 255;
+            mPixels[i + 3] = 0;
+        }
+
+        for (size_t i = 0; i < charsToLoad.size();) {
+            getGlyph(DecodeUTF8(charsToLoad, i));
+        }
+
+        mTexture = Texture2D::Create(mAtlasWidth, mAtlasHeight, mPixels.data());
+        mAtlasResized = false;
+        mDirtyMinY = UINT32_MAX;
+        mDirtyMaxY = 0;
+    }
+
+    Font::~Font() {
+        std::lock_guard<std::mutex> lock(sFreeTypeMutex);
+        FT_Done_Face(mFace);
+    }
+
+    uint32_t Font::DecodeUTF8(const std::string& text, size_t& i) {
+        const uint8_t lead = text[i++];
+        if (lead < 0x80) {
+            return lead;
+        }
+
+        uint32_t codepoint;
+        uint32_t continuation;
+        if ((lead & 0xE0) == 0xC0) {
+            codepoint = lead & 0x1F;
+            continuation = 1;
+        } else if ((lead & 0xF0) == 0xE0) {
+            codepoint = lead & 0x0F;
+            continuation = 2;
+        } else if ((lead & 0xF8) == 0xF0) {
+            codepoint = lead & 0x07;
+            continuation = 3;
+        } else {
+            return 0xFFFD;
+        }
+
+        for (uint32_t j = 0; j < continuation; j++) {
+            if (i >= text.size() || ((uint8_t)text[i] & 0xC0) != 0x80) {
+                return 0xFFFD;
+            }
+            codepoint = (codepoint << 6) | ((uint8_t)text[i++] & 0x3F);
+        }
+
+        return codepoint;
+    }
+
+    const Font::Glyph& Font::getGlyph(uint32_t codepoint) {
+        Font::Glyph& glyph = codepoint < 128 ? mASCIIGlyphs[codepoint] : mGlyphs[codepoint];
+        if (glyph.loaded) {
+            return glyph;
+        }
+
+        // missing codepoints load the .notdef glyph of the font, it is cached like any other glyph
+#if CR_FONT_HAS_SDF
+        if (mSDF) {
+            CR_VERIFYN(FT_Load_Char(mFace, codepoint, FT_LOAD_DEFAULT), "ERROR::FREETYTPE: Failed to load Glyp");
+            CR_VERIFYN(FT_Render_Glyph(mFace->glyph, FT_RENDER_MODE_SDF), "ERROR::FREETYTPE: Failed to render Glyp");
+        } else
+#endif
+        {
+            CR_VERIFYN(FT_Load_Char(mFace, codepoint, FT_LOAD_RENDER), "ERROR::FREETYTPE: Failed to load Glyp");
+        }
+
+        const FT_GlyphSlot slot = mFace->glyph;
+        const FT_Bitmap& bitmap = slot->bitmap;
+
+        glyph.loaded = true;
+        glyph.advance = (float)slot->advance.x / 64.0f;
+        glyph.index = slot->glyph_index;
+        glyph.offset = {(float)slot->bitmap_left, (float)mAscender - (float)slot->bitmap_top};
+        glyph.rect = {0.0f, 0.0f, (float)bitmap.width, (float)bitmap.rows};
+
+        // whitespace
+        if (bitmap.width == 0 || bitmap.rows == 0) {
+            return glyph;
+        }
+
+        uint32_t atlasX, atlasY;
+        if (!allocateRect(bitmap.width, bitmap.rows, &atlasX, &atlasY)) {
+            CR_CORE_ERROR("Car::Font, the glyph atlas is full, codepoint U+{0:04X} is not going to be drawn",
+                          codepoint);
+            glyph.rect.w = 0.0f;
+            glyph.rect.h = 0.0f;
+            return glyph;
+        }
+
+        for (uint32_t y = 0; y < bitmap.rows; y++) {
+            const uint8_t* src = bitmap.buffer + y * bitmap.pitch;
+            uint8_t* dst = mPixels.data() + ((atlasY + y) * mAtlasWidth + atlasX) * 4;
+            for (uint32_t x = 0; x < bitmap.width; x++) {
+                dst[x * 4 + 3] = src[x];
+            }
+        }
+
+        glyph.rect.x = (float)atlasX;
+        glyph.rect.y = (float)atlasY;
 
-        FT_Set_Pixel_Sizes(face, 0, height);
+        mDirtyMinY = MIN(mDirtyMinY, atlasY);
+        mDirtyMaxY = MAX(mDirtyMaxY, atlasY + bitmap.rows);
 
-        uint32_t textureWidth = 0;
-        uint32_t textureHeight = 0;
-        uint32_t highestYBearing = 0;
+        return glyph;
+    }
 
-        // first pass to figure out the texture's width
-        for (uint32_t i = 0; i < charsToLoad.size(); i++) {
-            char chr = charsToLoad[i];
-            CR_VERIFYN(FT_Load_Char(face, chr, FT_LOAD_RENDER), "ERROR::FREETYTPE: Failed to load Glyp");
+    float Font::getKerning(const Font::Glyph& left, const Font::Glyph& right) const {
+        if (!mHasKerning) {
+            return 0.0f;
+        }
 
-            textureWidth += face->glyph->bitmap.width;
-            textureHeight = MAX(textureHeight, face->glyph->bitmap.rows);
-            highestYBearing = MAX(highestYBearing, (uint32_t)face->glyph->bitmap_top);
+        FT_Vector delta;
+        if (FT_Get_Kerning(mFace, left.index, right.index, FT_KERNING_DEFAULT, &delta) != 0) {
+            return 0.0f;
         }
 
-        uint8_t* pixelBuffer = (uint8_t*)malloc(textureWidth * (textureHeight + heightPadding) * sizeof(uint8_t) * 4);
-        memset(pixelBuffer, 0, textureWidth * (textureHeight + heightPadding) * sizeof(uint8_t) * 4);
+        return (float)delta.x / 64.0f;
+    }
 
-        // second pass to get the bitmap data
-        uint32_t curAdvance = 0;
-        for (uint32_t i = 0; i < charsToLoad.size(); i++) {
-            const char chr = charsToLoad[i];
-            CR_VERIFYN(FT_Load_Char(face, chr, FT_LOAD_RENDER), "ERROR::FREETYTPE: Failed to load Glyp");
+    // shelf packing, a glyph goes on the first shelf that is tall enough without wasting too much of it
+    bool Font::allocateRect(uint32_t width, uint32_t height, uint32_t* pX, uint32_t* pY) {
+        width += glyphPadding;
+        height += glyphPadding;
 
-            uint32_t ystart = highestYBearing - face->glyph->bitmap_top;
+        if (width > mAtlasWidth) {
+            return false;
+        }
 
-            for (uint32_t x = 0; x < face->glyph->bitmap.width; x++) {
-                for (uint32_t y = 0; y < face->glyph->bitmap.rows; y++) {
-                    int cond = face->glyph->bitmap.buffer[x + y * face->glyph->bitmap.width] != 0;
-                    uint32_t posInBuf = ((x + curAdvance) + ((ystart + y) * textureWidth)) * 4;
-                    pixelBuffer[posInBuf + 0] = 255;
-                    pixelBuffer[posInBuf + 1] = 255;
-                    pixelBuffer[posInBuf + 2] = 255;
-                    pixelBuffer[posInBuf + 3] = 255 * cond;
-                }
+        for (Font::Shelf& shelf : mShelves) {
+            if (shelf.height >= height && shelf.height <= height + height / 4 && shelf.x + width <= mAtlasWidth) {
+                *pX = shelf.x;
+                *pY = shelf.y;
+                shelf.x += width;
+                return true;
             }
-            mCharacters[chr].rect = {(float)curAdvance, (float)0, (float)face->glyph->bitmap.width, (float)mHeight};
-            mCharacters[chr].advance = (uint32_t)face->glyph->advance.x >> 6;
+        }
 
-            curAdvance += face->glyph->bitmap.width;
+        while (mShelvesBottom + height > mAtlasHeight) {
+            if (!growAtlas()) {
+                return false;
+            }
         }
 
-        mTexture = Texture2D::Create(textureWidth, textureHeight + heightPadding, pixelBuffer);
+        mShelves.push_back({mShelvesBottom, height, width});
+        *pX = 0;
+        *pY = mShelvesBottom;
+        mShelvesBottom += height;
 
-        free(pixelBuffer);
+        return true;
     }
 
-    glm::ivec2 Font::measureText(const std::string& text) {
-        uint32_t width = 0;
-        uint32_t maxWidth = 0;
-        uint32_t height = mHeight;
+    // doubles the height, the existing glyphs keep their position so only the texture has to be recreated
+    bool Font::growAtlas() {
+        if (mAtlasHeight >= CR_FONT_MAX_ATLAS_SIZE) {
+            return false;
+        }
+
+        const size_t oldSize = mPixels.size();
+        mAtlasHeight = MIN(mAtlasHeight * 2, (uint32_t)CR_FONT_MAX_ATLAS_SIZE);
+        mPixels.resize(mAtlasWidth * mAtlasHeight * 4);
+        for (size_t i = oldSize; i < mPixels.size(); i += 4) {
+            mPixels[i + 0] = 255;
+            mPixels[i + 1] = 255;
+            mPixels[i + 2] = 255;
+            mPixels[i + 3] = 0;
+        }
+
+        mAtlasResized = true;
+
+        return true;
+    }
+
+    void Font::uploadAtlas() {
+        if (mTexture == nullptr) {
+            return;
+        }
 
-        for (size_t i = 0; i < text.size(); i++) {
-            const uint8_t chr = text[i];
-            if (chr == '\n') {
+        // draws that were already recorded keep the old texture alive and it still has their glyphs
+        if (mAtlasResized) {
+            mTexture = Texture2D::Create(mAtlasWidth, mAtlasHeight, mPixels.data());
+            mAtlasVersion++;
+        } else if (mDirtyMinY < mDirtyMaxY) {
+            mTexture->updateRegion(0, mDirtyMinY, mAtlasWidth, mDirtyMaxY - mDirtyMinY,
+                                   mPixels.data() + mDirtyMinY * mAtlasWidth * 4);
+        }
+
+        mAtlasResized = false;
+        mDirtyMinY = UINT32_MAX;
+        mDirtyMaxY = 0;
+    }
+
+    void Font::loadGlyphs(const std::string& text) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        loadGlyphsLocked(text);
+    }
+
+    void Font::loadGlyphsLocked(const std::string& text) {
+        for (size_t i = 0; i < text.size();) {
+            getGlyph(DecodeUTF8(text, i));
+        }
+
+        uploadAtlas();
+    }
+
+    Ref<Texture2D> Font::getTexture() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mTexture;
+    }
+
+    glm::ivec2 Font::measureText(const std::string& text, float scale) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        float width = 0;
+        float maxWidth = 0;
+        float height = mHeight * scale;
+        const Font::Glyph* previous = nullptr;
+
+        for (size_t i = 0; i < text.size();) {
+            const uint32_t codepoint = DecodeUTF8(text, i);
+            if (codepoint == '\n') {
                 // slight padding to stop the font looking weird
                 // incase a glyph has the same height as the font height
-                height += mHeight + 1;
+                height += (mHeight + 1) * scale;
                 maxWidth = MAX(maxWidth, width);
                 width = 0;
+                previous = nullptr;
                 continue;
             }
 
-            const Font::Character& character = mCharacters[chr];
-
-            width += character.advance;
+            const Font::Glyph& glyph = getGlyph(codepoint);
+            if (previous != nullptr) {
+                width += getKerning(*previous, glyph) * scale;
+            }
+            width += glyph.advance * scale;
+            previous = &glyph;
         }
 
         maxWidth = MAX(maxWidth, width);
 
+        uploadAtlas();
+
         return glm::ivec2(maxWidth, height);
     }
-
-    Font::~Font() {}
 } // namespace Car
@@ -0,0 +1,47 @@
+#include "Car/Renderer/ParticleSystem2D.hpp"
+#include "Car/Core/Log.hpp"
+#include "Car/Renderer/Buffer.hpp"
+
+// one per slot, has to match the Particle struct of ParticleSystem2D.comp and ParticleSystem2D.vert
+struct ParticleSystem2DParticle {
+    glm::vec2 pos;
+    glm::vec2 velocity;
+    // a particle is dead once age >= lifetime, the zeroed buffer starts out with every slot dead
+    float age;
+    float lifetime;
+    float padding[2];
+};
+
+namespace Car {
+    ParticleSystem2D::ParticleSystem2D(uint32_t capacity, const Emitter& emitter)
+        : mEmitter(emitter), mCapacity(capacity) {
+        // only ever touched by the gpu so it can live in device local memory
+        mParticles = SSBO::Create(nullptr, (uint64_t)mCapacity * sizeof(ParticleSystem2DParticle),
+                                  Buffer::Usage::StaticDraw);
+    }
+
+    void ParticleSystem2D::update(float dt) {
+        mPendingTime += dt;
+
+        const float toEmit = mEmitter.rate * dt + mEmitRemainder;
+        const uint32_t count = (uint32_t)MAX(toEmit, 0.0f);
+        mEmitRemainder = toEmit - (float)count;
+
+        burst(count);
+    }
+
+    void ParticleSystem2D::burst(uint32_t count) {
+        // the window can not wrap over itself, whatever does not fit is dropped
+        mEmitCount += MIN(count, mCapacity - mEmitCount);
+    }
+
+    Ref<ParticleSystem2D> ParticleSystem2D::Create(uint32_t capacity, const Emitter& emitter) {
+        CR_IF (capacity == 0) {
+            CR_CORE_ERROR("Car::ParticleSystem2D::Create(capacity, emitter), capacity can not be 0");
+            CR_DEBUGBREAK();
+            return nullptr;
+        }
+
+        return createRef<ParticleSystem2D>(capacity, emitter);
+    }
+} // namespace Car
@@ -3,33 +3,114 @@
 #include "Car/Application.hpp"
 #include "Car/Core/Core.hpp"
 #include "Car/Renderer/Buffer.hpp"
-#include "Car/Renderer/IndexBuffer.hpp"
+#include "Car/Renderer/ComputeShader.hpp"
+#include "Car/Renderer/ParticleSystem2D.hpp"
+#include "Car/Renderer/SSBO.hpp"
 #include "Car/Renderer/Shader.hpp"
 #include "Car/Renderer/Texture2D.hpp"
 #include "Car/Renderer/UniformBuffer.hpp"
 #include "Car/Renderer/VertexArray.hpp"
 #include "Car/Renderer/VertexBuffer.hpp"
 
-struct Renderer2DVertex {
+// set on the textureID of glyphs from sdf fonts, has to match Renderer2D.frag
+#define CR_R2_SDF_BIT 0x80000000u
+
+// one per sprite, the vertex shader expands it to a quad from gl_VertexIndex. has to match the Sprite struct of
+// Renderer2DStatic.vert too
+struct Renderer2DInstance {
     glm::vec2 pos;
-    glm::vec2 uv;
-    glm::vec3 tint;
+    glm::vec2 size;
+    // normalized x, y, w, h
+    glm::vec4 sourceRect;
+    // RGBA8
+    uint32_t tint;
     uint32_t textureID;
+    // radians around the center of the quad
+    float rotation;
+};
+
+// has to match the push constants of ParticleSystem2D.comp
+struct Renderer2DParticleSimulation {
+    glm::vec2 emitterPos;
+    glm::vec2 emitterExtent;
+    glm::vec2 gravity;
+    float drag;
+    float deltaTime;
+    float angle;
+    float spread;
+    float speedMin;
+    float speedMax;
+    float lifetimeMin;
+    float lifetimeMax;
+    uint32_t emitStart;
+    uint32_t emitCount;
+    uint32_t capacity;
+    uint32_t seed;
+};
+
+// has to match the push constants of ParticleSystem2D.vert
+struct Renderer2DParticleDraw {
+    glm::mat4 proj;
+    glm::vec4 startColor;
+    glm::vec4 endColor;
+    float startSize;
+    float endSize;
+    uint32_t textureID;
+};
+
+// everything a particle system draw needs, taken from the system when the draw is recorded so it can keep being
+// updated while a context with the draw waits to be submitted
+struct Renderer2DParticleFrame {
+    // kept alive until the frame is recorded
+    Car::Ref<Car::ParticleSystem2D> system;
+    Car::Ref<Car::SSBO> particles;
+    uint32_t capacity = 0;
+    // nothing to simulate when the system was already drawn since its last update
+    bool simulate = false;
+    Renderer2DParticleSimulation simulation;
+    // proj and textureID are filled in when the draw is recorded into the frame
+    Renderer2DParticleDraw draw;
+    Car::Ref<Car::Texture2D> texture;
 };
 
 struct Renderer2DData {
     Car::Ref<Car::Shader> shader;
-    Car::Ref<Car::IndexBuffer> ib;
     Car::Ref<Car::VertexBuffer> vb;
     Car::Ref<Car::VertexArray> va;
+    // pulls the sprites of static batches from a storage buffer
+    Car::Ref<Car::Shader> staticShader;
+    Car::Ref<Car::VertexArray> staticVa;
+    // static batches drawn this frame, they cant be destroyed while the frame is recorded
+    std::vector<Car::Ref<Car::Renderer2DStaticBatch>> frameStaticBatches;
+    // particle systems are simulated by one compute shader and drawn straight from their storage buffer
+    Car::Ref<Car::ComputeShader> particleSimulationShader;
+    Car::Ref<Car::Shader> particleShader;
+    Car::Ref<Car::VertexArray> particleVa;
+    std::vector<Car::Ref<Car::ParticleSystem2D>> frameParticleSystems;
     Car::Ref<Car::Texture2D> nullTexture;
-    uint32_t whiteTextureID = 8;
+    uint32_t whiteTextureID;
 
     uint32_t maxBatchSize;
     uint32_t currentBatchSize;
-    Renderer2DVertex* vertices;
-
-    std::vector<Car::Ref<Car::Texture2D>> textureTextures;
+    // how many instances fit in the current reservation of the vertex buffer
+    uint32_t batchCapacity;
+    // points straight into the mapped memory of the vertex buffer
+    Renderer2DInstance* instances;
+
+    // keeps the textures of the frame alive until the frame is recorded so their slot in the bindless texture table
+    // cant be reused, only pushed when the texture changes between draws so it can have duplicates
+    std::vector<Car::Ref<Car::Texture2D>> frameTextures;
+
+    // deferred mode, the instances are kept on the cpu and sorted at End
+    bool deferred = false;
+    int16_t layer = 0;
+    // layer: 16 | texture: 16 | submission index: 32
+    std::vector<uint64_t> sortKeys;
+    std::vector<uint64_t> sortScratch;
+    std::vector<Renderer2DInstance> deferredInstances;
+
+    Car::Renderer2D::Stats stats;
+    Car::Renderer2D::Stats lastFrameStats;
 };
 
 #define _CR_R2_REQ_INIT_OR_RET(__ret_v)                                                                                \
@@ -46,26 +127,214 @@ struct Renderer2DData {
     }
 
 namespace Car {
+    // what a context records in between its instances, replayed in order when the context is submitted
+    struct Renderer2DContextCommand {
+        enum class Type : uint8_t { StaticBatch, ParticleSystem, SetDeferred, SetLayer };
+
+        Type type;
+        // how many instances of the context were recorded before the command
+        size_t instanceOffset;
+
+        Ref<Renderer2DStaticBatch> batch;
+        Renderer2DParticleFrame particles;
+        bool deferred;
+        int16_t layer;
+    };
+
+    // draws of a worker thread end up here instead of the vertex buffer, they are copied in when submitted
+    struct Renderer2DContext {
+        std::vector<Renderer2DInstance> instances;
+        std::vector<Ref<Texture2D>> textures;
+        std::vector<Renderer2DContextCommand> commands;
+    };
+
+    struct Renderer2DStaticBatch {
+        Ref<SSBO> sprites;
+        uint32_t count = 0;
+        std::vector<Ref<Texture2D>> textures;
+    };
+
     static Renderer2DData* sData = nullptr;
+    // context bound on the calling thread, nullptr means draws go straight to the frame (main thread only)
+    static thread_local Renderer2DContext* tContext = nullptr;
+
+    static Renderer2DContextCommand& recordCommand(Renderer2DContextCommand::Type type) {
+        Renderer2DContextCommand& command = tContext->commands.emplace_back();
+        command.type = type;
+        command.instanceOffset = tContext->instances.size();
+
+        return command;
+    }
+
+    // flushes and reserves more of the vertex buffer if the current batch is full
+    static void reserveBatch() {
+        if (sData->currentBatchSize >= sData->batchCapacity) {
+            Renderer2D::FlushTextures();
+
+            uint64_t capacity;
+            sData->instances = (Renderer2DInstance*)sData->vb->reserveStream(sizeof(Renderer2DInstance), &capacity);
+            sData->batchCapacity = MIN(sData->maxBatchSize, capacity / sizeof(Renderer2DInstance));
+        }
+    }
+
+    // returns the next instance of the batch
+    static Renderer2DInstance* streamInstance() {
+        reserveBatch();
+
+        return &sData->instances[sData->currentBatchSize++];
+    }
+
+    static Renderer2DInstance* allocateInstance() {
+        if (tContext != nullptr) {
+            return &tContext->instances.emplace_back();
+        }
+
+        if (sData->deferred) {
+            // the texture is filled in at End since the instance is written after this returns
+            uint64_t layerKey = (uint64_t)(uint16_t)(sData->layer + 32768) << 48;
+            sData->sortKeys.push_back(layerKey | (uint64_t)sData->deferredInstances.size());
+            return &sData->deferredInstances.emplace_back();
+        }
+
+        return streamInstance();
+    }
+
+    // up to count contiguous instances, pAllocated is how many were given which is less than count only when the
+    // current batch runs out
+    static Renderer2DInstance* allocateInstances(uint32_t count, uint32_t* pAllocated) {
+        if (tContext != nullptr) {
+            size_t first = tContext->instances.size();
+            tContext->instances.resize(first + count);
+            *pAllocated = count;
+            return &tContext->instances[first];
+        }
+
+        if (sData->deferred) {
+            uint64_t layerKey = (uint64_t)(uint16_t)(sData->layer + 32768) << 48;
+            size_t first = sData->deferredInstances.size();
+            for (uint32_t i = 0; i < count; i++) {
+                sData->sortKeys.push_back(layerKey | (uint64_t)(first + i));
+            }
+            sData->deferredInstances.resize(first + count);
+            *pAllocated = count;
+            return &sData->deferredInstances[first];
+        }
+
+        reserveBatch();
+
+        *pAllocated = MIN(count, sData->batchCapacity - sData->currentBatchSize);
+        Renderer2DInstance* instances = &sData->instances[sData->currentBatchSize];
+        sData->currentBatchSize += *pAllocated;
+
+        return instances;
+    }
+
+    // number of texture changes + 1, which is how many batches a non bindless renderer would need
+    static uint32_t countTextureRuns(const Renderer2DInstance* instances, const uint64_t* keys, size_t count) {
+        uint32_t runs = 0;
+        uint32_t lastTextureID = UINT32_MAX;
+
+        for (size_t i = 0; i < count; i++) {
+            uint32_t textureID = instances[keys[i] & 0xFFFFFFFF].textureID;
+            if (textureID != lastTextureID) {
+                runs++;
+                lastTextureID = textureID;
+            }
+        }
+
+        return runs;
+    }
+
+    // LSD radix sort on the layer and texture bytes, the keys start out ordered by the submission index so every
+    // stable pass keeps that order between equal layers and textures
+    static void radixSortKeys(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch) {
+        scratch.resize(keys.size());
+
+        for (uint32_t shift = 32; shift < 64; shift += 8) {
+            uint32_t counts[256] = {};
+            for (uint64_t key : keys) {
+                counts[(key >> shift) & 0xFF]++;
+            }
+
+            // every key has the same byte, nothing would move
+            if (counts[(keys[0] >> shift) & 0xFF] == keys.size()) {
+                continue;
+            }
+
+            uint32_t offset = 0;
+            for (uint32_t& count : counts) {
+                uint32_t c = count;
+                count = offset;
+                offset += c;
+            }
+
+            for (uint64_t key : keys) {
+                scratch[counts[(key >> shift) & 0xFF]++] = key;
+            }
+
+            keys.swap(scratch);
+        }
+    }
+
+    static void flushDeferred() {
+        if (sData->sortKeys.empty()) {
+            return;
+        }
+
+        for (uint64_t& key : sData->sortKeys) {
+            key |= (uint64_t)(sData->deferredInstances[key & 0xFFFFFFFF].textureID & 0xFFFF) << 32;
+        }
+
+        sData->stats.textureRunsBeforeSort +=
+            countTextureRuns(sData->deferredInstances.data(), sData->sortKeys.data(), sData->sortKeys.size());
+
+        radixSortKeys(sData->sortKeys, sData->sortScratch);
+
+        sData->stats.textureRunsAfterSort +=
+            countTextureRuns(sData->deferredInstances.data(), sData->sortKeys.data(), sData->sortKeys.size());
+
+        for (uint64_t key : sData->sortKeys) {
+            *streamInstance() = sData->deferredInstances[key & 0xFFFFFFFF];
+        }
+
+        sData->sortKeys.clear();
+        sData->deferredInstances.clear();
+    }
+
+    static uint32_t packTint(const glm::vec3& tint) {
+        uint32_t r = (uint32_t)(glm::clamp(tint.r, 0.0f, 1.0f) * 255.0f + 0.5f);
+        uint32_t g = (uint32_t)(glm::clamp(tint.g, 0.0f, 1.0f) * 255.0f + 0.5f);
+        uint32_t b = (uint32_t)(glm::clamp(tint.b, 0.0f, 1.0f) * 255.0f + 0.5f);
+
+        return r | (g << 8) | (b << 16) | (0xFFu << 24);
+    }
+
+    static glm::mat4 getProjection() {
+        auto window = Car::Application::Get()->getWindow();
+
+        return glm::ortho(0.0f, (float)window->getWidth(), 0.0f, (float)window->getHeight(), 1.0f, -1.0f);
+    }
 
     void Renderer2D::Init() {
         sData = new Renderer2DData();
 
         Shader::VertexInputLayout layout = {
             {"iPos", Shader::VertexInputLayout::DataType::Float2},
-            {"iSourceUV", Shader::VertexInputLayout::DataType::Float2},
-            {"iTint", Shader::VertexInputLayout::DataType::Float3},
+            {"iSize", Shader::VertexInputLayout::DataType::Float2},
+            {"iSourceRect", Shader::VertexInputLayout::DataType::Float4},
+            {"iTint", Shader::VertexInputLayout::DataType::NormByte4},
             {"iTextureID", Shader::VertexInputLayout::DataType::UInt},
+            {"iRotation", Shader::VertexInputLayout::DataType::Float},
         };
 
-        assert(sizeof(Renderer2DVertex) == layout.getTotalSize());
+        assert(sizeof(Renderer2DInstance) == layout.getTotalSize());
 
         Shader::Specification spec{};
         spec.pushConstantLayout.useInVertexShader = true;
         spec.pushConstantLayout.useInFragmentShader = false;
         spec.pushConstantLayout.size = sizeof(glm::mat4);
         spec.vertexInputLayout = layout;
-        spec.vertexInputRate = Shader::VertexInputRate::VERTEX;
+        spec.vertexInputRate = Shader::VertexInputRate::INSTANCE;
         spec.polygonMode = Shader::PolygonMode::FILL;
         spec.cullMode = Shader::CullMode::BACK;
         spec.frontFace = Shader::FrontFace::CLOCKWISE;
@@ -78,45 +347,35 @@ namespace Car {
 
         uint32_t nullTextureData = 0xFFFFFFFF;
         sData->nullTexture = Car::Texture2D::Create(1, 1, &nullTextureData);
+        sData->whiteTextureID = sData->nullTexture->getBindlessIndex();
 
-        for (uint32_t i = 0; i < 8; i++) {
-            sData->shader->setInput(0, i, true, sData->nullTexture);
-        }
-
-        // TODO: change the batch size so the index buffer can use uint16_t
-        // TODO: investigate of uint16_t is better
         sData->maxBatchSize = 20000;
-        // sData->texturesMaxBatchSize = 10800;
         sData->currentBatchSize = 0;
+        sData->batchCapacity = 0;
+        sData->instances = nullptr;
 
-        sData->vertices = new Renderer2DVertex[sData->maxBatchSize * 4];
-        uint32_t* indexBufferData = new uint32_t[sData->maxBatchSize * 6];
-
-        // initialize the index buffer since that will be the same always
-        for (size_t i = 0; i < sData->maxBatchSize; i++) {
-            indexBufferData[i * 6 + 0] = i * 4 + 0;
-            indexBufferData[i * 6 + 1] = i * 4 + 1;
-            indexBufferData[i * 6 + 2] = i * 4 + 2;
-            indexBufferData[i * 6 + 3] = i * 4 + 2;
-            indexBufferData[i * 6 + 4] = i * 4 + 3;
-            indexBufferData[i * 6 + 5] = i * 4 + 0;
-        }
-        // 0b1_00111000_01111111
-        sData->ib = IndexBuffer::Create(indexBufferData, sData->maxBatchSize * 6 * sizeof(uint32_t),
-                                        Buffer::Usage::StaticDraw, Buffer::Type::UnsignedInt);
+        // every flush gets its own region of the per frame arena so multiple flushes per frame dont overwrite each other
+        sData->vb = VertexBuffer::Create(nullptr, sData->maxBatchSize * sizeof(Renderer2DInstance),
+                                         Buffer::Usage::Stream);
 
-        delete[] indexBufferData;
+        // no index buffer, the quads are expanded in the vertex shader
+        sData->va = VertexArray::Create(sData->vb, nullptr, sData->shader);
 
-        sData->vb = VertexBuffer::Create(sData->vertices, sData->maxBatchSize * 4 * sizeof(Renderer2DVertex),
-                                         Buffer::Usage::DynamicDraw);
+        // no vertex input at all, the sprites are read from the storage buffer with gl_InstanceIndex
+        spec.vertexInputLayout = Shader::VertexInputLayout();
+        spec.vertexInputRate = Shader::VertexInputRate::VERTEX;
+        sData->staticShader = Shader::Create("builtin/Renderer2DStatic.vert", "builtin/Renderer2D.frag", &spec);
+        sData->staticVa = VertexArray::Create(nullptr, nullptr, sData->staticShader);
 
-        sData->va = VertexArray::Create(sData->vb, sData->ib, sData->shader);
+        spec.pushConstantLayout.size = sizeof(Renderer2DParticleDraw);
+        sData->particleShader = Shader::Create("builtin/ParticleSystem2D.vert", "builtin/Renderer2D.frag", &spec);
+        sData->particleVa = VertexArray::Create(nullptr, nullptr, sData->particleShader);
+        sData->particleSimulationShader = ComputeShader::Create("builtin/ParticleSystem2D.comp");
     }
 
     void Renderer2D::Shutdown() {
         _CR_R2_REQ_INIT_OR_RET_VOID();
 
-        delete[] sData->vertices;
         delete sData;
     }
 
@@ -127,87 +386,302 @@ namespace Car {
             CR_CORE_ERROR("Called Car::Renderer2D::Begin() without closing the last begin");
         }
 
-        sData->textureTextures.clear();
+        sData->frameTextures.clear();
+        sData->frameStaticBatches.clear();
+        sData->frameParticleSystems.clear();
+        sData->stats = {};
+        // the reservation from the last frame belongs to another arena
+        sData->instances = nullptr;
+        sData->batchCapacity = 0;
     }
 
     void Renderer2D::End() {
         _CR_R2_REQ_INIT_OR_RET_VOID();
 
+        flushDeferred();
         Renderer2D::FlushTextures();
+
+        sData->lastFrameStats = sData->stats;
+    }
+
+    void Renderer2D::SetDeferred(bool deferred) {
+        _CR_R2_REQ_INIT_OR_RET_VOID();
+
+        if (tContext != nullptr) {
+            recordCommand(Renderer2DContextCommand::Type::SetDeferred).deferred = deferred;
+            return;
+        }
+
+        // whatever was recorded so far keeps its place
+        if (sData->deferred && !deferred) {
+            flushDeferred();
+        }
+        sData->deferred = deferred;
+    }
+
+    void Renderer2D::SetLayer(int16_t layer) {
+        _CR_R2_REQ_INIT_OR_RET_VOID();
+
+        if (tContext != nullptr) {
+            recordCommand(Renderer2DContextCommand::Type::SetLayer).layer = layer;
+            return;
+        }
+
+        sData->layer = layer;
+    }
+
+    const Renderer2D::Stats& Renderer2D::GetStats() {
+        static const Renderer2D::Stats sEmptyStats;
+        _CR_R2_REQ_INIT_OR_RET(sEmptyStats);
+
+        return sData->lastFrameStats;
     }
 
     void Renderer2D::FlushTextures() {
         _CR_R2_REQ_INIT_OR_RET_VOID();
 
         // no work to be done, early return
-        if (sData->currentBatchSize == 0) {
+        // contexts dont record any gpu commands until they are submitted
+        if (sData->currentBatchSize == 0 || tContext != nullptr) {
             return;
         }
 
-        auto window = Car::Application::Get()->getWindow();
-
-        glm::mat4 proj = glm::ortho(0.0f, (float)window->getWidth(), 0.0f, (float)window->getHeight(), 1.0f, -1.0f);
+        glm::mat4 proj = getProjection();
 
         Renderer::SetPushConstant(sData->va, true, false, glm::value_ptr(proj), sizeof(glm::mat4), 0);
 
-        for (size_t i = 0; i < sData->textureTextures.size(); i++) {
-            // sData->textureTextures[i]->bind(i);
-            sData->shader->setInput(0, i, false, sData->textureTextures[i]);
+        // the instances are already in the mapped memory, only the used region needs to be committed
+        sData->vb->commitStream(sData->currentBatchSize * sizeof(Renderer2DInstance));
+
+        Renderer::DrawInstanced(sData->va, 6, sData->currentBatchSize);
+        sData->stats.drawCalls++;
+        sData->stats.instances += sData->currentBatchSize;
+        sData->currentBatchSize = 0;
+        sData->batchCapacity = 0;
+        sData->instances = nullptr;
+    }
+
+    Ref<Renderer2DContext> Renderer2D::CreateContext() { return createRef<Renderer2DContext>(); }
+
+    void Renderer2D::BindContext(const Ref<Renderer2DContext>& context) { tContext = context.get(); }
+
+    static void drawParticleFrame(const Renderer2DParticleFrame& frame);
+
+    // copies instances of a context into the frame
+    static void submitInstances(const Renderer2DInstance* src, size_t count) {
+        if (sData->deferred) {
+            for (size_t i = 0; i < count; i++) {
+                *allocateInstance() = src[i];
+            }
+            return;
         }
 
-        sData->vb->updateData((void*)sData->vertices, sData->currentBatchSize * 4 * sizeof(Renderer2DVertex), 0);
+        // whatever was drawn before needs to stay below the context
+        Renderer2D::FlushTextures();
 
-        Renderer::DrawCommand(sData->va, sData->currentBatchSize * 2 * 3);
-        sData->currentBatchSize = 0;
+        while (count > 0) {
+            uint64_t capacity;
+            sData->instances = (Renderer2DInstance*)sData->vb->reserveStream(sizeof(Renderer2DInstance), &capacity);
+
+            uint32_t batchSize = MIN(MIN(count, capacity / sizeof(Renderer2DInstance)), sData->maxBatchSize);
+            std::memcpy(sData->instances, src, batchSize * sizeof(Renderer2DInstance));
+            sData->currentBatchSize = batchSize;
+            sData->batchCapacity = batchSize;
+
+            Renderer2D::FlushTextures();
+
+            src += batchSize;
+            count -= batchSize;
+        }
     }
 
-    // TODO: This is weirdly slow
-    int8_t Renderer2D::getTextureID(const Ref<Texture2D>& texture) {
-        _CR_R2_REQ_INIT_OR_RET(-1);
+    void Renderer2D::SubmitContext(const Ref<Renderer2DContext>& context) {
+        _CR_R2_REQ_INIT_OR_RET_VOID();
 
-        for (size_t i = 0; i < sData->textureTextures.size(); i++) {
-            // small trick to save some performace here and there for the vtable
-            // lookup
-            if ((void*)sData->textureTextures[i].get() == (void*)texture.get()) {
-                return i;
+        CR_IF (tContext != nullptr) {
+            CR_CORE_ERROR("Car::Renderer2D::SubmitContext(context), can not be called from a thread with a bound "
+                          "context");
+            CR_DEBUGBREAK();
+            return;
+        }
+
+        sData->frameTextures.insert(sData->frameTextures.end(), context->textures.begin(), context->textures.end());
+
+        size_t submitted = 0;
+        for (const Renderer2DContextCommand& command : context->commands) {
+            submitInstances(context->instances.data() + submitted, command.instanceOffset - submitted);
+            submitted = command.instanceOffset;
+
+            switch (command.type) {
+            case Renderer2DContextCommand::Type::StaticBatch:
+                Renderer2D::DrawStaticBatch(command.batch);
+                break;
+            case Renderer2DContextCommand::Type::ParticleSystem:
+                drawParticleFrame(command.particles);
+                break;
+            case Renderer2DContextCommand::Type::SetDeferred:
+                Renderer2D::SetDeferred(command.deferred);
+                break;
+            case Renderer2DContextCommand::Type::SetLayer:
+                Renderer2D::SetLayer(command.layer);
+                break;
             }
         }
-        if (sData->textureTextures.size() >= 8) {
-            // invalidate the data to make sure this is resolved
-            sData->currentBatchSize = 0;
-            return -1;
+        submitInstances(context->instances.data() + submitted, context->instances.size() - submitted);
+
+        context->instances.clear();
+        context->textures.clear();
+        context->commands.clear();
+    }
+
+    Ref<Renderer2DStaticBatch> Renderer2D::CreateStaticBatch(const Ref<Renderer2DContext>& context) {
+        _CR_R2_REQ_INIT_OR_RET(nullptr);
+
+        Ref<Renderer2DStaticBatch> batch = createRef<Renderer2DStaticBatch>();
+        batch->count = context->instances.size();
+        batch->textures = std::move(context->textures);
+        if (batch->count > 0) {
+            batch->sprites = SSBO::Create(context->instances.data(), batch->count * sizeof(Renderer2DInstance),
+                                          Buffer::Usage::StaticDraw);
         }
-        sData->textureTextures.push_back(texture);
-        return sData->textureTextures.size() - 1;
+
+        context->instances.clear();
+        context->textures.clear();
+        context->commands.clear();
+
+        return batch;
     }
 
-    void Renderer2D::DrawTexture(const Ref<Texture2D>& texture, const Rect& dest, const glm::vec3& tint) {
+    void Renderer2D::DrawStaticBatch(const Ref<Renderer2DStaticBatch>& batch) {
         _CR_R2_REQ_INIT_OR_RET_VOID();
 
-        int8_t textureID = getTextureID(texture);
+        if (batch->count == 0) {
+            return;
+        }
 
-        if (textureID == -1) {
-            CR_CORE_ERROR("Car::Renderer2D::DrawTexture too many textures sent, maximum as "
-                          "8, call Car::Renderer2D::FlushTextures if you plan on using "
-                          "more than 8 textures");
+        if (tContext != nullptr) {
+            recordCommand(Renderer2DContextCommand::Type::StaticBatch).batch = batch;
             return;
         }
 
-        Renderer2D::DrawTextureFromID(dest, textureID, tint);
+        // whatever was drawn before needs to stay below the batch
+        flushDeferred();
+        Renderer2D::FlushTextures();
+
+        sData->frameStaticBatches.push_back(batch);
+
+        glm::mat4 proj = getProjection();
+
+        sData->staticShader->setInput(1, 0, false, batch->sprites);
+        Renderer::SetPushConstant(sData->staticVa, true, false, glm::value_ptr(proj), sizeof(glm::mat4), 0);
+
+        Renderer::DrawInstanced(sData->staticVa, 6, batch->count);
+        sData->stats.drawCalls++;
+        sData->stats.instances += batch->count;
     }
 
-    void Renderer2D::DrawTexture(const Ref<Texture2D>& texture, const glm::vec2& pos, const glm::vec3& tint) {
+    static void drawParticleFrame(const Renderer2DParticleFrame& frame) {
+        // whatever was drawn before needs to stay below the particles
+        flushDeferred();
+        Renderer2D::FlushTextures();
+
+        sData->frameParticleSystems.push_back(frame.system);
+
+        if (frame.simulate) {
+            sData->particleSimulationShader->setInput(0, 0, false, frame.particles);
+            sData->particleSimulationShader->setPushConstant(&frame.simulation, sizeof(frame.simulation));
+
+            const uint32_t groupSize = sData->particleSimulationShader->getWorkgroupSize().x;
+            Renderer::Dispatch(sData->particleSimulationShader, (frame.capacity + groupSize - 1) / groupSize);
+        }
+
+        Renderer2DParticleDraw draw = frame.draw;
+        draw.proj = getProjection();
+        draw.textureID = frame.texture != nullptr ? Renderer2D::getTextureID(frame.texture) : sData->whiteTextureID;
+
+        sData->particleShader->setInput(1, 0, false, frame.particles);
+        Renderer::SetPushConstant(sData->particleVa, true, false, &draw, sizeof(draw), 0);
+
+        Renderer::DrawInstanced(sData->particleVa, 6, frame.capacity);
+        sData->stats.drawCalls++;
+        sData->stats.instances += frame.capacity;
+    }
+
+    void Renderer2D::DrawParticleSystem(const Ref<ParticleSystem2D>& system) {
         _CR_R2_REQ_INIT_OR_RET_VOID();
 
-        int8_t textureID = getTextureID(texture);
+        const ParticleSystem2D::Emitter& emitter = system->mEmitter;
+
+        // everything is taken from the system now so it can keep being updated while a context with the draw waits
+        // to be submitted
+        Renderer2DParticleFrame frame;
+        frame.system = system;
+        frame.particles = system->mParticles;
+        frame.capacity = system->mCapacity;
+
+        // a second draw in the same frame has nothing left to simulate
+        if (system->mPendingTime > 0.0f || system->mEmitCount > 0) {
+            Renderer2DParticleSimulation& simulation = frame.simulation;
+            simulation.emitterPos = emitter.position;
+            simulation.emitterExtent = emitter.extent;
+            simulation.gravity = emitter.gravity;
+            simulation.drag = emitter.drag;
+            simulation.deltaTime = system->mPendingTime;
+            simulation.angle = emitter.angle;
+            simulation.spread = emitter.spread;
+            simulation.speedMin = emitter.speedMin;
+            simulation.speedMax = emitter.speedMax;
+            simulation.lifetimeMin = emitter.lifetimeMin;
+            simulation.lifetimeMax = emitter.lifetimeMax;
+            simulation.emitStart = system->mEmitStart;
+            simulation.emitCount = system->mEmitCount;
+            simulation.capacity = system->mCapacity;
+            simulation.seed = system->mSeed++;
+            frame.simulate = true;
+
+            system->mEmitStart = (system->mEmitStart + system->mEmitCount) % system->mCapacity;
+            system->mEmitCount = 0;
+            system->mPendingTime = 0.0f;
+        }
+
+        frame.draw.startColor = emitter.startColor;
+        frame.draw.endColor = emitter.endColor;
+        frame.draw.startSize = emitter.startSize;
+        frame.draw.endSize = emitter.endSize;
+        frame.texture = emitter.texture;
 
-        if (textureID == -1) {
-            CR_CORE_ERROR("Car::Renderer2D::DrawTexture too many textures sent, maximum as "
-                          "8, call Car::Renderer2D::FlushTextures if you plan on using "
-                          "more than 8 textures");
+        if (tContext != nullptr) {
+            recordCommand(Renderer2DContextCommand::Type::ParticleSystem).particles = std::move(frame);
             return;
         }
 
+        drawParticleFrame(frame);
+    }
+
+    uint32_t Renderer2D::getTextureID(const Ref<Texture2D>& texture) {
+        _CR_R2_REQ_INIT_OR_RET(0);
+
+        std::vector<Ref<Texture2D>>& textures = tContext != nullptr ? tContext->textures : sData->frameTextures;
+        if (textures.empty() || textures.back() != texture) {
+            textures.push_back(texture);
+        }
+
+        return texture->getBindlessIndex();
+    }
+
+    void Renderer2D::DrawTexture(const Ref<Texture2D>& texture, const Rect& dest, const glm::vec3& tint) {
+        _CR_R2_REQ_INIT_OR_RET_VOID();
+
+        uint32_t textureID = getTextureID(texture);
+
+        Renderer2D::DrawTextureFromID(dest, textureID, tint);
+    }
+
+    void Renderer2D::DrawTexture(const Ref<Texture2D>& texture, const glm::vec2& pos, const glm::vec3& tint) {
+        _CR_R2_REQ_INIT_OR_RET_VOID();
+
+        uint32_t textureID = getTextureID(texture);
+
         Renderer2D::DrawTextureFromID({pos.x, pos.y, (float)texture->getWidth(), (float)texture->getHeight()},
                                       textureID, tint);
     }
@@ -216,14 +690,7 @@ namespace Car {
                                     const glm::vec3& tint) {
         _CR_R2_REQ_INIT_OR_RET_VOID();
 
-        int8_t textureID = getTextureID(texture);
-
-        if (textureID == -1) {
-            CR_CORE_ERROR("Car::Renderer2D::DrawSubTexture too many textures sent, maximum "
-                          "as 8, call Car::Renderer2D::FlushTextures if you plan on using "
-                          "more than 8 textures");
-            return;
-        }
+        uint32_t textureID = getTextureID(texture);
 
         Renderer2D::DrawSubTextureFromID(texture->getWidth(), texture->getHeight(), source, dest, textureID, tint);
     }
@@ -232,14 +699,7 @@ namespace Car {
                                     const glm::vec3& tint) {
         _CR_R2_REQ_INIT_OR_RET_VOID();
 
-        int8_t textureID = getTextureID(texture);
-
-        if (textureID == -1) {
-            CR_CORE_ERROR("Car::Renderer2D::DrawSubTexture too many textures sent, maximum "
-                          "as 8, call Car::Renderer2D::FlushTextures if you plan on using "
-                          "more than 8 textures");
-            return;
-        }
+        uint32_t textureID = getTextureID(texture);
 
         Renderer2D::DrawSubTextureFromID(texture->getWidth(), texture->getHeight(), source,
                                          {pos.x, pos.y, source.w - source.x, source.h - source.w}, textureID, tint);
@@ -251,207 +711,141 @@ namespace Car {
         Renderer2D::DrawTextureFromID(rect, sData->whiteTextureID, color);
     }
 
-    void Renderer2D::DrawLine(glm::vec2 start_, glm::vec2 end_, const glm::vec3& color, float lineWidth) {
+    void Renderer2D::DrawLine(glm::vec2 start, glm::vec2 end, const glm::vec3& color, float lineWidth) {
         _CR_R2_REQ_INIT_OR_RET_VOID();
 
-        int8_t textureID = sData->whiteTextureID;
-
-        glm::ivec2 start = start_;
-        glm::ivec2 end = end_;
-
-        if (start.x == end.x) { // vertical line
-            Renderer2D::DrawTextureFromID(
-                {start.x - lineWidth / 2, MIN(start_.y, end_.y), lineWidth / 2, ABS(start_.y - end_.y)}, textureID,
-                color);
-            return;
-        } else if (start.y == end.y) { // horizontal line
-            Renderer2D::DrawTextureFromID(
-                {MIN(start_.x, end_.x), start.y - lineWidth / 2, ABS(start_.x - end_.x), lineWidth / 2}, textureID,
-                color);
-            return;
-        }
-
-        uint32_t i = sData->currentBatchSize * 4;
-
-        float slope = (float)(end.y - (float)start.y) / ((float)end.x - (float)start.x);
-        // TODO: better name
-        slope = glm::atan(glm::degrees(slope));
-
-        // Questionable code but works ish for now
-        if (start.y > end.y) { // drawing upwards
-
-            sData->vertices[i].pos = {glm::floor(start.x - glm::cos(slope) * lineWidth / 2),
-                                      glm::floor(start.y + glm::sin(slope) * lineWidth / 2)};
-
-            sData->vertices[i].tint = color;
-            sData->vertices[i].textureID = textureID;
-            i++;
-
-            sData->vertices[i].pos = {glm::floor(end.x - glm::cos(slope) * lineWidth / 2),
-                                      glm::floor(end.y + glm::sin(slope) * lineWidth / 2)};
-
-            sData->vertices[i].tint = color;
-            sData->vertices[i].textureID = textureID;
-            i++;
-
-            sData->vertices[i].pos = {glm::floor(end.x + glm::cos(slope) * lineWidth / 2),
-                                      glm::floor(end.y - glm::sin(slope) * lineWidth / 2)};
-
-            sData->vertices[i].tint = color;
-            sData->vertices[i].textureID = textureID;
-            i++;
-
-            sData->vertices[i].pos = {glm::floor(start.x + glm::cos(slope) * lineWidth / 2),
-                                      glm::floor(start.y - glm::sin(slope) * lineWidth / 2)};
-
-            sData->vertices[i].tint = color;
-            sData->vertices[i].textureID = textureID;
-            i++;
-        } else { // drawing downwards
-            sData->vertices[i].pos = {glm::ceil(start.x + glm::cos(slope) * lineWidth / 2),
-                                      glm::floor(start.y - glm::sin(slope) * lineWidth / 2)};
-            sData->vertices[i].tint = color;
-            sData->vertices[i].textureID = textureID;
-            i++;
-
-            sData->vertices[i].pos = {glm::ceil(end.x + glm::cos(slope) * lineWidth / 2),
-                                      glm::floor(end.y - glm::sin(slope) * lineWidth / 2)};
-            sData->vertices[i].tint = color;
-            sData->vertices[i].textureID = textureID;
-            i++;
-
-            sData->vertices[i].pos = {glm::ceil(end.x - glm::cos(slope) * lineWidth / 2),
-                                      glm::floor(end.y + glm::sin(slope) * lineWidth / 2)};
-            sData->vertices[i].tint = color;
-            sData->vertices[i].textureID = textureID;
-            i++;
-
-            sData->vertices[i].pos = {glm::ceil(start.x - glm::cos(slope) * lineWidth / 2),
-                                      glm::floor(start.y + glm::sin(slope) * lineWidth / 2)};
-            sData->vertices[i].tint = color;
-            sData->vertices[i].textureID = textureID;
-            i++;
-        }
-
-        sData->currentBatchSize++;
-
-        if (sData->currentBatchSize >= sData->maxBatchSize) {
-            Renderer2D::FlushTextures();
-        }
+        glm::vec2 delta = end - start;
+        float length = glm::length(delta);
+
+        // a quad centered between the two points rotated to face along the line
+        Renderer2DInstance* instance = allocateInstance();
+        instance->pos = (start + end) * 0.5f - glm::vec2(length, lineWidth) * 0.5f;
+        instance->size = {length, lineWidth};
+        instance->sourceRect = {0.0f, 0.0f, 1.0f, 1.0f};
+        instance->tint = packTint(color);
+        instance->textureID = sData->whiteTextureID;
+        instance->rotation = glm::atan(delta.y, delta.x);
     }
 
     void Renderer2D::DrawText(const Ref<Font>& font, const std::string& text, const glm::vec2& pos,
-                              const glm::vec3& color) {
+                              const glm::vec3& color, float scale) {
         _CR_R2_REQ_INIT_OR_RET_VOID();
 
-        Ref<Texture2D> texture = font->getTexture();
+        // held for the whole text, other threads might be adding glyphs to the same font
+        std::lock_guard<std::mutex> lock(font->mMutex);
 
-        int8_t textureID = getTextureID(texture);
+        // rasterize whatever is missing first so the atlas is uploaded once
+        font->loadGlyphsLocked(text);
 
-        if (textureID == -1) {
-            CR_CORE_ERROR("Car::Renderer2D::DrawText too many textures sent, maximum as 8, "
-                          "call Car::Renderer2D::FlushTextures if you plan on using more "
-                          "than 8 textures");
-            return;
+        Ref<Texture2D> texture = font->mTexture;
+
+        uint32_t textureID = getTextureID(texture);
+        if (font->isSDF()) {
+            textureID |= CR_R2_SDF_BIT;
         }
 
-        float fontHeight = font->mHeight;
+        const float lineHeight = (font->getHeight() + 1) * scale;
 
-        const uint32_t textureWidth = texture->getWidth();
-        const uint32_t textureHeight = texture->getHeight();
+        const float textureWidth = texture->getWidth();
+        const float textureHeight = texture->getHeight();
+
+        const uint32_t tint = packTint(color);
 
         float x = pos.x;
         float y = pos.y;
+        const Font::Glyph* previous = nullptr;
 
-        for (size_t i = 0; i < text.size(); i++) {
-            const uint8_t chr = text[i];
-            if (chr == '\n') {
+        for (size_t i = 0; i < text.size();) {
+            const uint32_t codepoint = Font::DecodeUTF8(text, i);
+            if (codepoint == '\n') {
                 // slight padding to stop the font looking weird
                 // incase a glyph has the same height as the font height
-                y += fontHeight + 1;
+                y += lineHeight;
                 x = pos.x;
+                previous = nullptr;
                 continue;
             }
 
-            const Font::Character& character = font->mCharacters[chr];
+            const Font::Glyph& glyph = font->getGlyph(codepoint);
+            if (previous != nullptr) {
+                x += font->getKerning(*previous, glyph) * scale;
+            }
 
-            Renderer2D::DrawSubTextureFromID(textureWidth, textureHeight, character.rect,
-                                             {x, y, character.rect.w, fontHeight}, textureID, color);
+            if (glyph.rect.w > 0.0f) {
+                Renderer2DInstance* instance = allocateInstance();
+                instance->pos = glm::vec2(x, y) + glyph.offset * scale;
+                instance->size = glm::vec2(glyph.rect.w, glyph.rect.h) * scale;
+                instance->sourceRect = {glyph.rect.x / textureWidth, glyph.rect.y / textureHeight,
+                                        glyph.rect.w / textureWidth, glyph.rect.h / textureHeight};
+                instance->tint = tint;
+                instance->textureID = textureID;
+                instance->rotation = 0.0f;
+            }
 
-            x += character.advance;
+            x += glyph.advance * scale;
+            previous = &glyph;
         }
     }
 
-    void Renderer2D::DrawSubTextureFromID(const uint32_t textureWidth, const uint32_t textureHeight, const Rect& source,
-                                          const Rect& dest, int8_t textureID, const glm::vec3& tint) {
+    void Renderer2D::DrawText(TextLayout& layout, const glm::vec2& pos, const glm::vec3& color) {
         _CR_R2_REQ_INIT_OR_RET_VOID();
 
-        uint32_t i = sData->currentBatchSize * 4;
+        const std::vector<TextLayout::Quad>& quads = layout.getQuads();
+        if (quads.empty()) {
+            return;
+        }
 
-        sData->vertices[i].pos = {dest.x, dest.y};
-        sData->vertices[i].uv = {source.x / textureWidth, source.y / textureHeight};
-        sData->vertices[i].tint = tint;
-        sData->vertices[i].textureID = textureID;
-        i++;
+        // the atlas the quads were built against, the font might have grown it since on another thread
+        uint32_t textureID = getTextureID(layout.mTexture);
+        if (layout.getFont()->isSDF()) {
+            textureID |= CR_R2_SDF_BIT;
+        }
 
-        sData->vertices[i].pos = {dest.x + dest.w, dest.y};
-        sData->vertices[i].uv = {(source.x + source.w) / textureWidth, source.y / textureHeight};
-        sData->vertices[i].tint = tint;
-        sData->vertices[i].textureID = textureID;
-        i++;
+        const uint32_t tint = packTint(color);
 
-        sData->vertices[i].pos = {dest.x + dest.w, dest.y + dest.h};
-        sData->vertices[i].uv = {(source.x + source.w) / textureWidth, (source.y + source.h) / textureHeight};
-        sData->vertices[i].tint = tint;
-        sData->vertices[i].textureID = textureID;
-        i++;
+        const TextLayout::Quad* quad = quads.data();
+        uint32_t remaining = quads.size();
 
-        sData->vertices[i].pos = {dest.x, dest.y + dest.h};
-        sData->vertices[i].uv = {source.x / textureWidth, (source.y + source.h) / textureHeight};
-        sData->vertices[i].tint = tint;
-        sData->vertices[i].textureID = textureID;
-        i++;
+        while (remaining > 0) {
+            uint32_t count;
+            Renderer2DInstance* instances = allocateInstances(remaining, &count);
 
-        sData->currentBatchSize++;
+            for (uint32_t i = 0; i < count; i++, quad++) {
+                instances[i].pos = pos + quad->offset;
+                instances[i].size = quad->size;
+                instances[i].sourceRect = quad->sourceRect;
+                instances[i].tint = tint;
+                instances[i].textureID = textureID;
+                instances[i].rotation = 0.0f;
+            }
 
-        if (sData->currentBatchSize >= sData->maxBatchSize) {
-            Renderer2D::FlushTextures();
+            remaining -= count;
         }
     }
 
-    void Renderer2D::DrawTextureFromID(const Rect& dest, int8_t textureID, const glm::vec3& tint) {
+    void Renderer2D::DrawSubTextureFromID(const uint32_t textureWidth, const uint32_t textureHeight, const Rect& source,
+                                          const Rect& dest, uint32_t textureID, const glm::vec3& tint) {
         _CR_R2_REQ_INIT_OR_RET_VOID();
 
-        uint32_t i = sData->currentBatchSize * 4;
-
-        sData->vertices[i].pos = {dest.x, dest.y};
-        sData->vertices[i].uv = {0, 0};
-        sData->vertices[i].tint = tint;
-        sData->vertices[i].textureID = textureID;
-        i++;
-
-        sData->vertices[i].pos = {dest.x + dest.w, dest.y};
-        sData->vertices[i].uv = {1, 0};
-        sData->vertices[i].tint = tint;
-        sData->vertices[i].textureID = textureID;
-        i++;
-
-        sData->vertices[i].pos = {dest.x + dest.w, dest.y + dest.h};
-        sData->vertices[i].uv = {1, 1};
-        sData->vertices[i].tint = tint;
-        sData->vertices[i].textureID = textureID;
-        i++;
-
-        sData->vertices[i].pos = {dest.x, dest.y + dest.h};
-        sData->vertices[i].uv = {0, 1};
-        sData->vertices[i].tint = tint;
-        sData->vertices[i].textureID = textureID;
-        i++;
+        Renderer2DInstance* instance = allocateInstance();
+        instance->pos = {dest.x, dest.y};
+        instance->size = {dest.w, dest.h};
+        instance->sourceRect = {source.x / textureWidth, source.y / textureHeight, source.w / textureWidth,
+                                source.h / textureHeight};
+        instance->tint = packTint(tint);
+        instance->textureID = textureID;
+        instance->rotation = 0.0f;
+    }
 
-        sData->currentBatchSize++;
+    void Renderer2D::DrawTextureFromID(const Rect& dest, uint32_t textureID, const glm::vec3& tint) {
+        _CR_R2_REQ_INIT_OR_RET_VOID();
 
-        if (sData->currentBatchSize >= sData->maxBatchSize) {
-            Renderer2D::FlushTextures();
-        }
+        Renderer2DInstance* instance = allocateInstance();
+        instance->pos = {dest.x, dest.y};
+        instance->size = {dest.w, dest.h};
+        instance->sourceRect = {0.0f, 0.0f, 1.0f, 1.0f};
+        instance->tint = packTint(tint);
+        instance->textureID = textureID;
+        instance->rotation = 0.0f;
     }
 } // namespace Car
@@ -0,0 +1,100 @@
+#include "Car/Renderer/TextLayout.hpp"
+
+namespace Car {
+    TextLayout::TextLayout(const Ref<Font>& font, const std::string& text, float scale)
+        : mFont(font), mText(text), mScale(scale) {}
+
+    void TextLayout::setFont(const Ref<Font>& font) {
+        if (mFont != font) {
+            mFont = font;
+            mDirty = true;
+        }
+    }
+
+    void TextLayout::setText(const std::string& text) {
+        if (mText != text) {
+            mText = text;
+            mDirty = true;
+        }
+    }
+
+    void TextLayout::setScale(float scale) {
+        if (mScale != scale) {
+            mScale = scale;
+            mDirty = true;
+        }
+    }
+
+    const std::vector<TextLayout::Quad>& TextLayout::getQuads() {
+        rebuildIfNeeded();
+
+        return mQuads;
+    }
+
+    glm::vec2 TextLayout::getSize() {
+        rebuildIfNeeded();
+
+        return mSize;
+    }
+
+    void TextLayout::rebuildIfNeeded() {
+        if (mFont == nullptr) {
+            mQuads.clear();
+            mSize = glm::vec2(0.0f);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mFont->mMutex);
+
+        if (!mDirty && mAtlasVersion == mFont->mAtlasVersion) {
+            return;
+        }
+
+        mFont->loadGlyphsLocked(mText);
+
+        const float textureWidth = mFont->mAtlasWidth;
+        const float textureHeight = mFont->mAtlasHeight;
+        const float lineHeight = (mFont->mHeight + 1) * mScale;
+
+        mQuads.clear();
+
+        glm::vec2 pen = glm::vec2(0.0f);
+        float maxWidth = 0.0f;
+        const Font::Glyph* previous = nullptr;
+
+        for (size_t i = 0; i < mText.size();) {
+            const uint32_t codepoint = Font::DecodeUTF8(mText, i);
+            if (codepoint == '\n') {
+                // slight padding to stop the font looking weird
+                // incase a glyph has the same height as the font height
+                maxWidth = MAX(maxWidth, pen.x);
+                pen.x = 0.0f;
+                pen.y += lineHeight;
+                previous = nullptr;
+                continue;
+            }
+
+            const Font::Glyph& glyph = mFont->getGlyph(codepoint);
+            if (previous != nullptr) {
+                pen.x += mFont->getKerning(*previous, glyph) * mScale;
+            }
+
+            if (glyph.rect.w > 0.0f) {
+                mQuads.push_back({
+                    pen + glyph.offset * mScale,
+                    glm::vec2(glyph.rect.w, glyph.rect.h) * mScale,
+                    {glyph.rect.x / textureWidth, glyph.rect.y / textureHeight, glyph.rect.w / textureWidth,
+                     glyph.rect.h / textureHeight},
+                });
+            }
+
+            pen.x += glyph.advance * mScale;
+            previous = &glyph;
+        }
+
+        mSize = {MAX(maxWidth, pen.x), pen.y + mFont->mHeight * mScale};
+        mAtlasVersion = mFont->mAtlasVersion;
+        mTexture = mFont->mTexture;
+        mDirty = false;
+    }
+} // namespace Car
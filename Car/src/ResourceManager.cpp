@@ -1,12 +1,30 @@
 #include "Car/ResourceManager.hpp"
 #include "Car/Core/Log.hpp"
+
+#include <stb/stb_image.h>
+
+#include <list>
 #include <unordered_map>
 
+struct ResourceManagerCacheEntry {
+    std::string key;
+    Car::Ref<Car::ResourceManager::AssetBase> asset;
+};
+
 struct ResourceManagerData {
     std::filesystem::path resourceDirectory = "./resources";
     std::filesystem::path imagesSubdirectory = "images";
     std::filesystem::path shadersSubdirectory = "shaders";
     std::filesystem::path fontsSubdirectory = "fonts";
+
+    // created the first time it is needed since the graphics context comes after Init
+    Car::Ref<Car::Texture2D> placeholderTexture;
+
+    // most recently used at the front
+    std::list<ResourceManagerCacheEntry> cache;
+    std::unordered_map<std::string, std::list<ResourceManagerCacheEntry>::iterator> cacheLookup;
+    size_t cacheBudget = CR_RESOURCE_MANAGER_DEFAULT_BUDGET;
+    size_t cacheSize = 0;
 };
 
 #define CR_RM_NEED_INITIALIZATION_RET_SPECIAL(ret)                                                                     \
@@ -25,6 +43,130 @@ struct ResourceManagerData {
 namespace Car::ResourceManager {
     static ResourceManagerData* sData = nullptr;
 
+    // assets nothing else holds from the back until the cache fits the budget, every one of them if all is set
+    static void trimCache(size_t budget, bool all) {
+        for (auto it = sData->cache.end(); it != sData->cache.begin();) {
+            if (!all && sData->cacheSize <= budget) {
+                break;
+            }
+
+            --it;
+            const Ref<AssetBase>& asset = it->asset;
+            // evicting assets that are in use would not free anything
+            if (asset.use_count() > 1 || asset->getState() == AssetBase::State::Loading) {
+                continue;
+            }
+
+            sData->cacheSize -= asset->getSize();
+            sData->cacheLookup.erase(it->key);
+            it = sData->cache.erase(it);
+        }
+    }
+
+    struct AssetAccess {
+        static void finishLoading(AssetBase& asset) {
+            // wait() might have gotten to it first
+            if (asset.mState != AssetBase::State::Loading) {
+                return;
+            }
+
+            asset.mSize = asset.takeLoaded();
+            asset.mJob = nullptr;
+
+            if (sData == nullptr) {
+                return;
+            }
+
+            // dropped so the next load tries again, the file might show up later or the error might not repeat.
+            // handles that are still around keep the failed asset
+            if (asset.hasFailed()) {
+                for (auto it = sData->cache.begin(); it != sData->cache.end(); it++) {
+                    if (it->asset.get() == &asset) {
+                        sData->cacheLookup.erase(it->key);
+                        sData->cache.erase(it);
+                        break;
+                    }
+                }
+                return;
+            }
+
+            sData->cacheSize += asset.mSize;
+            trimCache(sData->cacheBudget, false);
+        }
+
+        template <typename T> static void load(const Ref<Asset<T>>& asset, std::function<Ref<T>()> loader) {
+            auto job = [asset, loader]() {
+                try {
+                    asset->mLoaded = loader();
+                } catch (const std::exception& e) {
+                    CR_CORE_ERROR("ResourceManager failed to load `{}`: {}", asset->getPath(), e.what());
+                    UNUSED(e);
+                }
+            };
+
+            // without workers the asset is loaded right away
+            if (Jobs::GetWorkerCount() == 0) {
+                job();
+                finishLoading(*asset);
+                return;
+            }
+
+            asset->mJob = Jobs::Schedule(job);
+            Jobs::OnMainThread(asset->mJob, [asset]() { finishLoading(*asset); });
+        }
+    };
+
+    template <> size_t Asset<Texture2D>::takeLoaded() {
+        mAsset = std::move(mLoaded);
+        mState = mAsset != nullptr ? State::Ready : State::Failed;
+
+        return mAsset != nullptr ? (size_t)mAsset->getWidth() * mAsset->getHeight() * 4 : 0;
+    }
+
+    template <> size_t Asset<Font>::takeLoaded() {
+        mAsset = std::move(mLoaded);
+        mState = mAsset != nullptr ? State::Ready : State::Failed;
+
+        // the atlas is kept on the cpu as well
+        return mAsset != nullptr ? (size_t)mAsset->getTexture()->getWidth() * mAsset->getTexture()->getHeight() * 4 * 2
+                                 : 0;
+    }
+
+    void AssetBase::wait() {
+        Jobs::Wait(mJob);
+        AssetAccess::finishLoading(*this);
+    }
+
+    static std::string resolvePath(const std::filesystem::path& subdirectory, const std::string& path) {
+        // an absolute path replaces the directories before it
+        return (sData->resourceDirectory / subdirectory / path).lexically_normal().string();
+    }
+
+    // nullptr when the key is not cached, otherwise the entry becomes the most recently used one
+    static Ref<AssetBase> findCached(const std::string& key) {
+        auto it = sData->cacheLookup.find(key);
+        if (it == sData->cacheLookup.end()) {
+            return nullptr;
+        }
+
+        sData->cache.splice(sData->cache.begin(), sData->cache, it->second);
+        return it->second->asset;
+    }
+
+    static void insertCached(const std::string& key, Ref<AssetBase> asset) {
+        sData->cache.push_front({key, asset});
+        sData->cacheLookup[key] = sData->cache.begin();
+    }
+
+    static const Ref<Texture2D>& placeholderTexture() {
+        if (sData->placeholderTexture == nullptr) {
+            uint32_t pixel = 0x00000000;
+            sData->placeholderTexture = Texture2D::Create(1, 1, &pixel);
+        }
+
+        return sData->placeholderTexture;
+    }
+
     void Init() {
         CR_IF (sData != nullptr) {
             CR_CORE_ERROR("ResourceManager already initialized");
@@ -39,6 +181,7 @@ namespace Car::ResourceManager {
     void Shutdown() {
         CR_RM_NEED_INITIALIZATION_RET_VOID();
 
+        // the jobs are done by now, anything still loading would have been finished by Jobs::Shutdown
         delete sData;
         sData = nullptr;
 
@@ -84,4 +227,93 @@ namespace Car::ResourceManager {
         CR_RM_NEED_INITIALIZATION_RET_SPECIAL(nullptr);
         return sData->fontsSubdirectory;
     }
+
+    TextureHandle loadTexture(const std::string& path, bool flipped) {
+        CR_RM_NEED_INITIALIZATION_RET_SPECIAL(nullptr);
+
+        const std::string fullPath = resolvePath(sData->imagesSubdirectory, path);
+        const std::string key = "texture|" + fullPath + (flipped ? "|flipped" : "");
+        if (Ref<AssetBase> cached = findCached(key)) {
+            return staticCastRef<Asset<Texture2D>>(cached);
+        }
+
+        TextureHandle asset = createRef<Asset<Texture2D>>(fullPath, placeholderTexture());
+        insertCached(key, asset);
+
+        AssetAccess::load<Texture2D>(asset, [fullPath, flipped]() -> Ref<Texture2D> {
+            // the flag of stb is global otherwise
+            stbi_set_flip_vertically_on_load_thread(flipped);
+
+            int width, height;
+            stbi_uc* pixels = stbi_load(fullPath.c_str(), &width, &height, nullptr, STBI_rgb_alpha);
+            if (pixels == nullptr) {
+                throw std::runtime_error(stbi_failure_reason());
+            }
+
+            // the upload queue can be used from any thread, the pixels are only copied into a staging buffer here
+            Ref<Texture2D> texture = Texture2D::Create((uint32_t)width, (uint32_t)height, pixels);
+            stbi_image_free(pixels);
+
+            return texture;
+        });
+
+        return asset;
+    }
+
+    FontHandle loadFont(const std::string& path, uint32_t height, const std::string& charsToLoad, bool sdf) {
+        CR_RM_NEED_INITIALIZATION_RET_SPECIAL(nullptr);
+
+        const std::string fullPath = resolvePath(sData->fontsSubdirectory, path);
+        const std::string key = "font|" + fullPath + "|" + std::to_string(height) + (sdf ? "|sdf" : "");
+        if (Ref<AssetBase> cached = findCached(key)) {
+            return staticCastRef<Asset<Font>>(cached);
+        }
+
+        FontHandle asset = createRef<Asset<Font>>(fullPath, nullptr);
+        insertCached(key, asset);
+
+        // the glyphs of charsToLoad are rasterized on the worker too
+        AssetAccess::load<Font>(asset, [fullPath, height, charsToLoad, sdf]() -> Ref<Font> {
+            return createRef<Font>(fullPath, height, charsToLoad, sdf);
+        });
+
+        return asset;
+    }
+
+    void setPlaceholderTexture(Ref<Texture2D> placeholder) {
+        CR_RM_NEED_INITIALIZATION_RET_VOID();
+        CR_IF (placeholder == nullptr) {
+            CR_CORE_ERROR("ResourceManager::setPlaceholderTexture(placeholder), placeholder can not be nullptr");
+            return;
+        }
+
+        // textures that are already loading keep the old one
+        sData->placeholderTexture = placeholder;
+    }
+
+    Ref<Texture2D> getPlaceholderTexture() {
+        CR_RM_NEED_INITIALIZATION_RET_SPECIAL(nullptr);
+        return placeholderTexture();
+    }
+
+    void setCacheBudget(size_t budget) {
+        CR_RM_NEED_INITIALIZATION_RET_VOID();
+        sData->cacheBudget = budget;
+        trimCache(budget, false);
+    }
+
+    size_t getCacheBudget() {
+        CR_RM_NEED_INITIALIZATION_RET_SPECIAL(0);
+        return sData->cacheBudget;
+    }
+
+    size_t getCacheSize() {
+        CR_RM_NEED_INITIALIZATION_RET_SPECIAL(0);
+        return sData->cacheSize;
+    }
+
+    void clearCache() {
+        CR_RM_NEED_INITIALIZATION_RET_VOID();
+        trimCache(0, true);
+    }
 } // namespace Car::ResourceManager
@@ -11,10 +11,14 @@ namespace Car {
     static Window* sInstance = nullptr;
 
     void Window::onUpdate() {
-        mGraphicsContext->swapBuffers();
-        glfwPollEvents();
+        swapBuffers();
+        pollEvents();
     }
 
+    void Window::swapBuffers() { mGraphicsContext->swapBuffers(); }
+
+    void Window::pollEvents() { glfwPollEvents(); }
+
     Window* Window::Get() { return sInstance; }
 
     Window::Window(const Car::Window::Specification& spec) {
@@ -46,7 +50,7 @@ namespace Car {
             throw std::runtime_error("Car: Failed to create GLFW window");
         }
 
-        mGraphicsContext = GraphicsContext::Create(mHandle);
+        mGraphicsContext = GraphicsContext::Create(mHandle, spec.framesInFlight);
     }
 
     void Window::init() {
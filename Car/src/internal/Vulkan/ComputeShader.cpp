@@ -0,0 +1,171 @@
+#include "Car/internal/Vulkan/ComputeShader.hpp"
+#include "Car/Core/Log.hpp"
+#include "Car/Core/Ref.hpp"
+#include "Car/ResourceManager.hpp"
+#include "Car/internal/Vulkan/Shader.hpp"
+
+#include <cstring>
+#include <glad/vulkan.h>
+#include <stdexcept>
+
+namespace Car {
+    VulkanComputeShader::VulkanComputeShader(const CompiledShader& compiledShader) {
+        mGraphicsContext = reinterpretCastRef<VulkanGraphicsContext>(GraphicsContext::Get());
+        mWorkgroupSize = glm::uvec3(compiledShader.workgroupSize[0], compiledShader.workgroupSize[1],
+                                    compiledShader.workgroupSize[2]);
+
+        mDescriptors = createScope<VulkanShaderDescriptors>(mGraphicsContext.get(), compiledShader.sets);
+        createPipelineLayout(compiledShader);
+        createComputePipeline(compiledShader);
+    }
+
+    VulkanComputeShader::~VulkanComputeShader() {
+        VkDevice device = mGraphicsContext->getDevice();
+
+        mGraphicsContext->waitIdle();
+
+        mDescriptors.reset();
+
+        vkDestroyPipeline(device, mComputePipeline, nullptr);
+        vkDestroyPipelineLayout(device, mPipelineLayout, nullptr);
+    }
+
+    void VulkanComputeShader::setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<UniformBuffer> ub) {
+        mDescriptors->setInput(set, binding, applyToAll, ub);
+    }
+
+    void VulkanComputeShader::setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<Texture2D> texture) {
+        mDescriptors->setInput(set, binding, applyToAll, texture);
+    }
+
+    void VulkanComputeShader::setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<SSBO> ssbo) {
+        mDescriptors->setInput(set, binding, applyToAll, ssbo);
+    }
+
+    void VulkanComputeShader::setPushConstant(const void* data, uint32_t size, uint32_t offset) {
+        CR_IF (!data) {
+            CR_CORE_ERROR("Car::ComputeShader::setPushConstant(data, size, offset), data must not be nullptr");
+            return;
+        }
+        CR_IF (size + offset > sizeof(mPushConstantData)) {
+            CR_CORE_ERROR("Car::ComputeShader::setPushConstant(data, size, offset), size + offset can not be larger "
+                          "then 128 per the vulkan specification");
+            return;
+        }
+
+        std::memcpy(mPushConstantData + offset, data, size);
+    }
+
+    void VulkanComputeShader::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+        VkCommandBuffer cmdBuffer = mGraphicsContext->getCurrentComputeCommandBuffer();
+        const uint32_t frame = mGraphicsContext->getCurrentFrameIndex();
+
+        vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mComputePipeline);
+
+        const std::vector<VkDescriptorSet>& descriptorSets = mDescriptors->getDescriptorSets(frame);
+        if (!descriptorSets.empty()) {
+            vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0,
+                                    descriptorSets.size(), descriptorSets.data(), 0, nullptr);
+        }
+
+        if (mPushConstantRange.size > 0) {
+            vkCmdPushConstants(cmdBuffer, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, mPushConstantRange.offset,
+                               mPushConstantRange.size, mPushConstantData + mPushConstantRange.offset);
+        }
+
+        vkCmdDispatch(cmdBuffer, groupCountX, groupCountY, groupCountZ);
+
+        // the next dispatch can read what this one wrote, the draws are taken care of when the buffer is submitted
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                             1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    void VulkanComputeShader::createPipelineLayout(const CompiledShader& compiledShader) {
+        const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts = mDescriptors->getSetLayouts();
+
+        // a single stage has at most one range
+        if (!compiledShader.pushConstants.empty()) {
+            const PushConstantRange& range = compiledShader.pushConstants[0];
+            mPushConstantRange = {VK_SHADER_STAGE_COMPUTE_BIT, range.offset, range.size};
+
+            CR_IF (range.offset + range.size > 128) {
+                CR_CORE_ERROR("push constant size cant be bigger then 128 bytes");
+                CR_DEBUGBREAK();
+                return;
+            }
+        }
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = descriptorSetLayouts.size();
+        pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.empty() ? nullptr : descriptorSetLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = mPushConstantRange.size > 0 ? 1 : 0;
+        pipelineLayoutInfo.pPushConstantRanges = mPushConstantRange.size > 0 ? &mPushConstantRange : nullptr;
+
+        if (vkCreatePipelineLayout(mGraphicsContext->getDevice(), &pipelineLayoutInfo, nullptr, &mPipelineLayout) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+    }
+
+    void VulkanComputeShader::createComputePipeline(const CompiledShader& compiledShader) {
+        VkDevice device = mGraphicsContext->getDevice();
+
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = compiledShader.computeCodeSize;
+        moduleInfo.pCode = compiledShader.pComputeCode;
+
+        VkShaderModule shaderModule;
+        if (vkCreateShaderModule(device, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shader module!");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = mPipelineLayout;
+
+        VkResult result = vkCreateComputePipelines(device, mGraphicsContext->getPipelineCache(), 1, &pipelineInfo,
+                                                   nullptr, &mComputePipeline);
+        vkDestroyShaderModule(device, shaderModule, nullptr);
+
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create compute pipeline!");
+        }
+    }
+
+    Ref<ComputeShader> ComputeShader::Create(const std::string& computeShaderName) {
+        std::filesystem::path shadersPath =
+            (std::filesystem::path)ResourceManager::getResourceDirectory() / ResourceManager::getShadersSubdirectory();
+
+        LoadedShaderStage stage;
+        loadShaderStage(shadersPath, computeShaderName, DescriptorStage::ComputeShader, &stage);
+
+        for (const auto& set : stage.shader.sets) {
+            if (set.size() == 0) {
+                throw std::runtime_error("can not have an empty set in a shader");
+            }
+        }
+
+        // the stage stays alive until the pipeline is created
+        CompiledShader compiledShader;
+        compiledShader.sets = stage.shader.sets;
+        if (stage.shader.pushConstant.size > 0) {
+            compiledShader.pushConstants.push_back(stage.shader.pushConstant);
+        }
+        compiledShader.pComputeCode = stage.pCode;
+        compiledShader.computeCodeSize = stage.codeSize;
+        std::memcpy(compiledShader.workgroupSize, stage.shader.workgroupSize, sizeof(compiledShader.workgroupSize));
+
+        return createRef<VulkanComputeShader>(compiledShader);
+    }
+} // namespace Car
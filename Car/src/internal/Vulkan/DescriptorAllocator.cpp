@@ -0,0 +1,204 @@
+#include "Car/internal/Vulkan/DescriptorAllocator.hpp"
+#include "Car/internal/Vulkan/GraphicsContext.hpp"
+
+#include <stdexcept>
+
+namespace Car {
+    // descriptors per set a pool is sized for, shaders of a 2d framework use mostly buffers and textures
+    static const std::vector<std::pair<VkDescriptorType, float>> sPoolRatios = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f},
+        {VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f},
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 0.5f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0.5f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 0.5f},
+    };
+
+    VulkanDescriptorAllocator::VulkanDescriptorAllocator(VulkanGraphicsContext* pGraphicsContext,
+                                                         uint32_t maxFramesInFlight) {
+        mDevice = pGraphicsContext->getDevice();
+        mTransientPools.resize(maxFramesInFlight);
+    }
+
+    VulkanDescriptorAllocator::~VulkanDescriptorAllocator() {
+        for (const Pool& pool : mPools) {
+            CR_IF (pool.allocatedSets != 0) {
+                CR_CORE_ERROR("Car::VulkanDescriptorAllocator::~VulkanDescriptorAllocator, {0} descriptor sets were "
+                              "never freed",
+                              pool.allocatedSets);
+            }
+            vkDestroyDescriptorPool(mDevice, pool.pool, nullptr);
+        }
+
+        for (const TransientPools& frame : mTransientPools) {
+            for (VkDescriptorPool pool : frame.used) {
+                vkDestroyDescriptorPool(mDevice, pool, nullptr);
+            }
+        }
+        for (VkDescriptorPool pool : mFreeTransientPools) {
+            vkDestroyDescriptorPool(mDevice, pool, nullptr);
+        }
+    }
+
+    VkDescriptorPool VulkanDescriptorAllocator::createPool(uint32_t maxSets, VkDescriptorPoolCreateFlags flags) {
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for (const auto& [type, ratio] : sPoolRatios) {
+            poolSizes.push_back({type, MAX((uint32_t)(ratio * maxSets), 1u)});
+        }
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = flags;
+        poolInfo.maxSets = maxSets;
+        poolInfo.poolSizeCount = poolSizes.size();
+        poolInfo.pPoolSizes = poolSizes.data();
+
+        VkDescriptorPool pool;
+        if (vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+
+        return pool;
+    }
+
+    VkResult VulkanDescriptorAllocator::allocateFrom(VkDevice device, VkDescriptorPool pool,
+                                                     VkDescriptorSetLayout layout, VkDescriptorSet* pSet) {
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = pool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &layout;
+
+        return vkAllocateDescriptorSets(device, &allocInfo, pSet);
+    }
+
+    static bool isPoolExhausted(VkResult result) {
+        return result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL;
+    }
+
+    VulkanDescriptorSet VulkanDescriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        VulkanDescriptorSet ret{};
+
+        // the newest pool is the emptiest one so it is tried first
+        for (size_t i = mPools.size(); i-- > 0;) {
+            Pool& pool = mPools[i];
+            if (pool.full) {
+                continue;
+            }
+
+            VkResult result = allocateFrom(mDevice, pool.pool, layout, &ret.set);
+            if (result == VK_SUCCESS) {
+                pool.allocatedSets++;
+                ret.pool = pool.pool;
+                return ret;
+            }
+            if (!isPoolExhausted(result)) {
+                throw std::runtime_error("failed to allocate descriptor sets!");
+            }
+            pool.full = true;
+        }
+
+        CR_CORE_DEBUG("Car::VulkanDescriptorAllocator, every descriptor pool is full, adding one for {0} sets",
+                      mNextPoolSize);
+
+        Pool pool;
+        pool.pool = createPool(mNextPoolSize, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+        mNextPoolSize = MIN(mNextPoolSize * 2, (uint32_t)CR_VULKAN_DESCRIPTOR_POOL_MAX_SETS);
+
+        if (allocateFrom(mDevice, pool.pool, layout, &ret.set) != VK_SUCCESS) {
+            vkDestroyDescriptorPool(mDevice, pool.pool, nullptr);
+            throw std::runtime_error("failed to allocate descriptor sets!");
+        }
+        pool.allocatedSets++;
+        ret.pool = pool.pool;
+        mPools.push_back(pool);
+
+        return ret;
+    }
+
+    void VulkanDescriptorAllocator::free(VulkanDescriptorSet* pSet) {
+        if (pSet->set == VK_NULL_HANDLE) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        for (Pool& pool : mPools) {
+            if (pool.pool == pSet->pool) {
+                vkFreeDescriptorSets(mDevice, pool.pool, 1, &pSet->set);
+                pool.allocatedSets--;
+                pool.full = false;
+                break;
+            }
+        }
+
+        *pSet = VulkanDescriptorSet{};
+    }
+
+    VkDescriptorSet VulkanDescriptorAllocator::allocateTransient(VkDescriptorSetLayout layout) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        TransientPools& frame = mTransientPools[mCurrentFrame];
+        VkDescriptorSet set;
+
+        if (!frame.used.empty()) {
+            VkResult result = allocateFrom(mDevice, frame.used.back(), layout, &set);
+            if (result == VK_SUCCESS) {
+                frame.setCount++;
+                return set;
+            }
+            if (!isPoolExhausted(result)) {
+                throw std::runtime_error("failed to allocate descriptor sets!");
+            }
+        }
+
+        if (mFreeTransientPools.empty()) {
+            frame.used.push_back(createPool(CR_VULKAN_DESCRIPTOR_POOL_MIN_SETS, 0));
+        } else {
+            frame.used.push_back(mFreeTransientPools.back());
+            mFreeTransientPools.pop_back();
+        }
+
+        if (allocateFrom(mDevice, frame.used.back(), layout, &set) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate descriptor sets!");
+        }
+        frame.setCount++;
+
+        return set;
+    }
+
+    void VulkanDescriptorAllocator::beginFrame(uint32_t frameIndex) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        mCurrentFrame = frameIndex;
+
+        TransientPools& frame = mTransientPools[frameIndex];
+        for (VkDescriptorPool pool : frame.used) {
+            vkResetDescriptorPool(mDevice, pool, 0);
+            mFreeTransientPools.push_back(pool);
+        }
+        frame.used.clear();
+        frame.setCount = 0;
+    }
+
+    VulkanDescriptorAllocator::Stats VulkanDescriptorAllocator::getStats() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        Stats stats{};
+        stats.poolCount = mPools.size();
+        stats.transientPoolCount = mFreeTransientPools.size();
+        for (const Pool& pool : mPools) {
+            stats.allocatedSets += pool.allocatedSets;
+        }
+        for (const TransientPools& frame : mTransientPools) {
+            stats.transientPoolCount += frame.used.size();
+            stats.transientSets += frame.setCount;
+        }
+
+        return stats;
+    }
+} // namespace Car
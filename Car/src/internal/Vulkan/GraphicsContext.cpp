@@ -4,6 +4,7 @@
 #include "Car/Application.hpp"
 #include "Car/Core/Log.hpp"
 #include "Car/Window.hpp"
+#include "Car/ResourceManager.hpp"
 
 // include glad before glfw so `VK_VERSION_1_0` is defined
 #include <glad/vulkan.h>
@@ -126,7 +127,8 @@ namespace Car {
         for (uint32_t i = 0; i < queueFamilyCount; i++) {
             const VkQueueFamilyProperties& queueFamily = queueFamilies[i];
 
-            if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            // dispatches are submitted together with the draws
+            if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
                 indices.graphicsFamily = i;
             }
             VkBool32 presentSupport = false;
@@ -146,9 +148,11 @@ namespace Car {
         return indices;
     }
 
-    VulkanGraphicsContext::VulkanGraphicsContext(GLFWwindow* windowHandle) : mWindowHandle(windowHandle) {
+    VulkanGraphicsContext::VulkanGraphicsContext(GLFWwindow* windowHandle, uint32_t maxFramesInFlight)
+        : mWindowHandle(windowHandle), mMaxFramesInFlight(maxFramesInFlight) {
         CR_ASSERT(windowHandle, "Interal Error: null window handle sent to vulkan graphics context");
         CR_ASSERT(!sInstance, "an instance of the graphics context already exists, use the Get method");
+        CR_ASSERT(maxFramesInFlight > 0, "there has to be at least one frame in flight");
     }
 
     void VulkanGraphicsContext::init() {
@@ -161,6 +165,7 @@ namespace Car {
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
+        mMemoryAllocator = createScope<VulkanMemoryAllocator>(mPhysicalDevice, mDevice);
         createSwapChain();
         createImageViews();
         createRenderPass();
@@ -168,7 +173,9 @@ namespace Car {
         createCommandPool();
         createCommandBuffers();
         createSyncObjects();
+        createUploadQueue();
         createDescriptorPool();
+        createBindlessTextureTable();
 
         CR_CORE_DEBUG("Vulkan Context Initialized");
     }
@@ -203,7 +210,22 @@ namespace Car {
         VkPhysicalDeviceFeatures supportedFeatures;
         vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
-        return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+        // descriptor indexing for the bindless texture table and timeline semaphores for the upload queue
+        VkPhysicalDeviceVulkan12Features supportedFeatures12{};
+        supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 supportedFeatures2{};
+        supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures2.pNext = &supportedFeatures12;
+        vkGetPhysicalDeviceFeatures2(device, &supportedFeatures2);
+
+        bool bindlessSupported = supportedFeatures12.runtimeDescriptorArray &&
+                                 supportedFeatures12.descriptorBindingPartiallyBound &&
+                                 supportedFeatures12.descriptorBindingSampledImageUpdateAfterBind &&
+                                 supportedFeatures12.descriptorBindingUpdateUnusedWhilePending &&
+                                 supportedFeatures12.shaderSampledImageArrayNonUniformIndexing;
+
+        return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy &&
+               bindlessSupported && supportedFeatures12.timelineSemaphore;
     }
 
     std::vector<const char*> getRequiredExtensions() {
@@ -384,6 +406,20 @@ namespace Car {
         }
 
         vkGetPhysicalDeviceProperties(physicalDevice, &mPhysicalDeviceProperties);
+
+        VkPhysicalDeviceVulkan12Properties properties12{};
+        properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+        VkPhysicalDeviceProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &properties12;
+        vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+        // no reason to go above 4096 textures in 2D and some drivers report absurd limits
+        mMaxBindlessTextures = 4096;
+        mMaxBindlessTextures = MIN(mMaxBindlessTextures, properties12.maxPerStageDescriptorUpdateAfterBindSamplers);
+        mMaxBindlessTextures = MIN(mMaxBindlessTextures, properties12.maxPerStageDescriptorUpdateAfterBindSampledImages);
+        mMaxBindlessTextures = MIN(mMaxBindlessTextures, properties12.maxDescriptorSetUpdateAfterBindSamplers);
+        mMaxBindlessTextures = MIN(mMaxBindlessTextures, properties12.maxDescriptorSetUpdateAfterBindSampledImages);
     }
 
     void VulkanGraphicsContext::createLogicalDevice() {
@@ -407,8 +443,18 @@ namespace Car {
         VkPhysicalDeviceFeatures deviceFeatures{};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+        VkPhysicalDeviceVulkan12Features deviceFeatures12{};
+        deviceFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        deviceFeatures12.timelineSemaphore = VK_TRUE;
+        deviceFeatures12.runtimeDescriptorArray = VK_TRUE;
+        deviceFeatures12.descriptorBindingPartiallyBound = VK_TRUE;
+        deviceFeatures12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        deviceFeatures12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        deviceFeatures12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+
         VkDeviceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = &deviceFeatures12;
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
         createInfo.pEnabledFeatures = &deviceFeatures;
@@ -615,6 +661,7 @@ namespace Car {
 
         mRenderCommandBuffers.resize(mMaxFramesInFlight);
         mTransferCommandBuffers.resize(mMaxFramesInFlight);
+        mComputeCommandBuffers.resize(mMaxFramesInFlight);
 
         if (vkAllocateCommandBuffers(mDevice, &renderAllocInfo, mRenderCommandBuffers.data()) != VK_SUCCESS) {
             throw std::runtime_error("failed to allocate render command buffers!");
@@ -623,6 +670,63 @@ namespace Car {
         if (vkAllocateCommandBuffers(mDevice, &transferAllocInfo, mTransferCommandBuffers.data()) != VK_SUCCESS) {
             throw std::runtime_error("failed to allocate transfer command buffers!");
         }
+
+        if (vkAllocateCommandBuffers(mDevice, &renderAllocInfo, mComputeCommandBuffers.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate compute command buffers!");
+        }
+    }
+
+    VkCommandBuffer VulkanGraphicsContext::getCurrentComputeCommandBuffer() {
+        VkCommandBuffer cmdBuffer = mComputeCommandBuffers[mCurrentFrame];
+        if (mComputeRecording) {
+            return cmdBuffer;
+        }
+
+        vkResetCommandBuffer(cmdBuffer, 0);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(cmdBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording compute command buffer!");
+        }
+        mComputeRecording = true;
+
+        // the frames before it can still be reading (or in case of their dispatches writing) what is about to be
+        // written, everything on the queue that was submitted earlier is covered by the barrier
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(cmdBuffer,
+                             VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        return cmdBuffer;
+    }
+
+    void VulkanGraphicsContext::endComputeCommands() {
+        VkCommandBuffer cmdBuffer = mComputeCommandBuffers[mCurrentFrame];
+
+        // whatever the draws of the frame can read a dispatch result as
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                                VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+                                VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                                 VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        if (vkEndCommandBuffer(cmdBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to end recording of compute command buffer");
+        }
     }
 
     void VulkanGraphicsContext::createSyncObjects() {
@@ -648,20 +752,19 @@ namespace Car {
         }
     }
 
-    // TODO: Pool manager
-    // but this might be enough too
+    void VulkanGraphicsContext::createUploadQueue() {
+        CrQueueFamilyIndices indices = findQueueFamilies(mPhysicalDevice);
+
+        mStagingPool = createScope<VulkanStagingPool>(this);
+        mUploadQueue =
+            createScope<VulkanUploadQueue>(this, indices.transferFamily.value(), indices.graphicsFamily.value());
+    }
+
     void VulkanGraphicsContext::createDescriptorPool() {
-        std::vector<VkDescriptorPoolSize> poolSizes = {{VK_DESCRIPTOR_TYPE_SAMPLER, 1000},
-                                                       {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000},
-                                                       {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1000},
-                                                       {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1000},
-                                                       {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1000},
-                                                       {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1000},
-                                                       {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1000},
-                                                       {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000},
-                                                       {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1000},
-                                                       {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1000},
-                                                       {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1000}};
+        mDescriptorAllocator = createScope<VulkanDescriptorAllocator>(this, mMaxFramesInFlight);
+
+        // imgui wants a pool of its own, it only needs its font texture and whatever textures are shown with it
+        std::vector<VkDescriptorPoolSize> poolSizes = {{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 100}};
 
         VkDescriptorPoolCreateInfo poolInfo{};
         poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -671,17 +774,235 @@ namespace Car {
         poolInfo.poolSizeCount = poolSizes.size();
         poolInfo.pPoolSizes = poolSizes.data();
 
-        if (vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &mDescriptorPool) != VK_SUCCESS) {
+        if (vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &mImGuiDescriptorPool) != VK_SUCCESS) {
             throw std::runtime_error("failed to create descriptor pool!");
         }
     }
 
+    void VulkanGraphicsContext::createBindlessTextureTable() {
+        CR_CORE_DEBUG("Creating bindless texture table with {0} slots", mMaxBindlessTextures);
+
+        VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, mMaxBindlessTextures};
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        poolInfo.maxSets = 1;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+
+        if (vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &mBindlessDescriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create bindless descriptor pool!");
+        }
+
+        VkDescriptorSetLayoutBinding binding{};
+        binding.binding = 0;
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        binding.descriptorCount = mMaxBindlessTextures;
+        binding.stageFlags = VK_SHADER_STAGE_ALL;
+        binding.pImmutableSamplers = nullptr;
+
+        // slots can be written while a frame that doesnt use them is in flight and not every slot has to be valid
+        VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsInfo.bindingCount = 1;
+        bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.pNext = &bindingFlagsInfo;
+        layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        layoutInfo.bindingCount = 1;
+        layoutInfo.pBindings = &binding;
+
+        if (vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &mBindlessTextureSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create bindless descriptor set layout!");
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = mBindlessDescriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &mBindlessTextureSetLayout;
+
+        if (vkAllocateDescriptorSets(mDevice, &allocInfo, &mBindlessTextureSet) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate bindless descriptor set!");
+        }
+    }
+
+    uint32_t VulkanGraphicsContext::registerBindlessTexture(const VkDescriptorImageInfo& imageInfo) {
+        std::lock_guard<std::mutex> lock(mBindlessMutex);
+        uint32_t slot;
+
+        if (!mFreeBindlessTextureSlots.empty()) {
+            slot = mFreeBindlessTextureSlots.back();
+            mFreeBindlessTextureSlots.pop_back();
+        } else {
+            if (mBindlessTextureCount >= mMaxBindlessTextures) {
+                throw std::runtime_error("ran out of bindless texture slots, max is " +
+                                         std::to_string(mMaxBindlessTextures));
+            }
+            slot = mBindlessTextureCount++;
+        }
+
+        writeBindlessTexture(slot, imageInfo);
+
+        return slot;
+    }
+
+    void VulkanGraphicsContext::updateBindlessTexture(uint32_t slot, const VkDescriptorImageInfo& imageInfo) {
+        std::lock_guard<std::mutex> lock(mBindlessMutex);
+        writeBindlessTexture(slot, imageInfo);
+    }
+
+    void VulkanGraphicsContext::writeBindlessTexture(uint32_t slot, const VkDescriptorImageInfo& imageInfo) {
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = mBindlessTextureSet;
+        descriptorWrite.dstBinding = 0;
+        descriptorWrite.dstArrayElement = slot;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pImageInfo = &imageInfo;
+
+        vkUpdateDescriptorSets(mDevice, 1, &descriptorWrite, 0, nullptr);
+    }
+
+    void VulkanGraphicsContext::releaseBindlessTexture(uint32_t slot) {
+        // the slot is partially bound so it can stay stale until someone else registers it
+        std::lock_guard<std::mutex> lock(mBindlessMutex);
+        mFreeBindlessTextureSlots.push_back(slot);
+    }
+
+    // written in front of the data vkGetPipelineCacheData returns, a cache from another device or driver version is
+    // at best useless so it is thrown away instead of handing it to the driver
+    struct CrPipelineCacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        // keeps the struct free of padding so it can be compared with memcmp
+        uint32_t reserved;
+        uint64_t dataSize;
+    };
+
+    static constexpr uint32_t CR_PIPELINE_CACHE_MAGIC = 0x43505243; // "CRPC"
+    static constexpr uint32_t CR_PIPELINE_CACHE_VERSION = 1;
+
+    static CrPipelineCacheHeader makePipelineCacheHeader(const VkPhysicalDeviceProperties& properties,
+                                                         uint64_t dataSize) {
+        CrPipelineCacheHeader header{};
+        header.magic = CR_PIPELINE_CACHE_MAGIC;
+        header.version = CR_PIPELINE_CACHE_VERSION;
+        header.vendorID = properties.vendorID;
+        header.deviceID = properties.deviceID;
+        header.driverVersion = properties.driverVersion;
+        std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        header.dataSize = dataSize;
+
+        return header;
+    }
+
+    VkPipelineCache VulkanGraphicsContext::getPipelineCache() {
+        // shaders are created on worker threads too, only one of them creates the cache
+        std::lock_guard<std::mutex> lock(mPipelineCacheMutex);
+        if (mPipelineCache != VK_NULL_HANDLE) {
+            return mPipelineCache;
+        }
+
+        mPipelineCachePath = (std::filesystem::path)ResourceManager::getResourceDirectory() /
+                             ResourceManager::getShadersSubdirectory() / "__CACHE__" / "pipeline.cache";
+
+        std::vector<char> data;
+        std::ifstream file(mPipelineCachePath, std::ios::binary | std::ios::ate);
+        if (file.is_open()) {
+            const std::streamoff fileSize = file.tellg();
+            file.seekg(0);
+
+            CrPipelineCacheHeader header{};
+            file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+            const CrPipelineCacheHeader expected = makePipelineCacheHeader(mPhysicalDeviceProperties, header.dataSize);
+            if (file.good() && std::memcmp(&header, &expected, sizeof(header)) == 0) {
+                // the size is the only field the comparison above can not check, it has to be what is left of the file
+                bool valid = header.dataSize == (uint64_t)(fileSize - (std::streamoff)sizeof(header));
+                if (valid) {
+                    data.resize(header.dataSize);
+                    file.read(data.data(), data.size());
+                    valid = file.good();
+                }
+                if (!valid) {
+                    CR_CORE_WARN("pipeline cache {} is corrupt, ignoring it", mPipelineCachePath.string());
+                    data.clear();
+                }
+            } else {
+                CR_CORE_DEBUG("pipeline cache {} is from another device or driver, ignoring it",
+                              mPipelineCachePath.string());
+            }
+        }
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = data.size();
+        cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+        if (vkCreatePipelineCache(mDevice, &cacheInfo, nullptr, &mPipelineCache) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create the pipeline cache!");
+        }
+
+        if (!data.empty()) {
+            CR_CORE_DEBUG("Loaded pipeline cache from {}", mPipelineCachePath.string());
+        }
+
+        return mPipelineCache;
+    }
+
+    void VulkanGraphicsContext::savePipelineCache() {
+        if (mPipelineCache == VK_NULL_HANDLE) {
+            return;
+        }
+
+        size_t dataSize = 0;
+        vkGetPipelineCacheData(mDevice, mPipelineCache, &dataSize, nullptr);
+        std::vector<char> data(dataSize);
+        if (vkGetPipelineCacheData(mDevice, mPipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+            CR_CORE_WARN("failed to get the pipeline cache data");
+            return;
+        }
+
+        const CrPipelineCacheHeader header = makePipelineCacheHeader(mPhysicalDeviceProperties, dataSize);
+
+        // this runs on shutdown so a read only resource directory is not worth more than a warning
+        std::error_code ec;
+        std::filesystem::create_directories(mPipelineCachePath.parent_path(), ec);
+        std::ofstream file(mPipelineCachePath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(data.data(), dataSize);
+        if (!file.good()) {
+            CR_CORE_WARN("failed to write the pipeline cache to {}", mPipelineCachePath.string());
+        }
+    }
+
     VulkanGraphicsContext::~VulkanGraphicsContext() {
         sInstance = nullptr;
 
         vkDeviceWaitIdle(mDevice);
 
-        vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
+        savePipelineCache();
+        if (mPipelineCache != VK_NULL_HANDLE) {
+            vkDestroyPipelineCache(mDevice, mPipelineCache, nullptr);
+        }
+
+        vkDestroyDescriptorPool(mDevice, mImGuiDescriptorPool, nullptr);
+        mDescriptorAllocator.reset();
+        vkDestroyDescriptorPool(mDevice, mBindlessDescriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(mDevice, mBindlessTextureSetLayout, nullptr);
 
         for (size_t i = 0; i < mMaxFramesInFlight; i++) {
             vkDestroySemaphore(mDevice, mRenderFinishedSemaphores[i], nullptr);
@@ -696,6 +1017,10 @@ namespace Car {
 
         cleanupSwapChain();
 
+        mUploadQueue.reset();
+        mStagingPool.reset();
+        mMemoryAllocator.reset();
+
         vkDestroyDevice(mDevice, nullptr);
 
         vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
@@ -711,6 +1036,10 @@ namespace Car {
     }
 
     uint32_t VulkanGraphicsContext::aquireNextImageIndex() {
+        if (mSwapchainOutdated.exchange(false)) {
+            recreateSwapchain();
+        }
+
         VkResult result = vkAcquireNextImageKHR(mDevice, mSwapChain, UINT64_MAX, getCurrentImageAvailableSemaphore(),
                                                 VK_NULL_HANDLE, &mImageIndex);
 
@@ -738,20 +1067,42 @@ namespace Car {
     }
 
     void VulkanGraphicsContext::swapBuffers() {
-        VkSemaphore waitSemaphores[] = {mImageAvailableSemaphores[mCurrentFrame]};
-        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+        // whatever was uploaded up to now might be used by the frame
+        uint64_t uploadValue = mUploadQueue->flush();
+
+        VkSemaphore waitSemaphores[] = {mImageAvailableSemaphores[mCurrentFrame], mUploadQueue->getTimelineSemaphore()};
+        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
         VkSemaphore signalSemaphores[] = {mRenderFinishedSemaphores[mCurrentFrame]};
 
+        // the value of the binary semaphore is ignored
+        uint64_t waitValues[] = {0, uploadValue};
+
+        std::vector<VkCommandBuffer> cmdBuffers;
+        if (mComputeRecording) {
+            endComputeCommands();
+            cmdBuffers.push_back(mComputeCommandBuffers[mCurrentFrame]);
+            mComputeRecording = false;
+        }
+        cmdBuffers.push_back(mRenderCommandBuffers[mCurrentFrame]);
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = 2;
+        timelineInfo.pWaitSemaphoreValues = waitValues;
+
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.waitSemaphoreCount = 2;
         submitInfo.pWaitSemaphores = waitSemaphores;
         submitInfo.pWaitDstStageMask = waitStages;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &mRenderCommandBuffers[mCurrentFrame];
+        submitInfo.commandBufferCount = cmdBuffers.size();
+        submitInfo.pCommandBuffers = cmdBuffers.data();
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
+        std::unique_lock<std::recursive_mutex> queueLock(mQueueMutex);
         if (vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, mInFlightFences[mCurrentFrame]) != VK_SUCCESS) {
             throw std::runtime_error("failed to submit draw command buffer!");
         }
@@ -765,8 +1116,17 @@ namespace Car {
         presentInfo.pImageIndices = &mImageIndex;
 
         vkQueuePresentKHR(mPresentQueue, &presentInfo);
+        queueLock.unlock();
+
+        mUploadQueue->collect();
 
         mCurrentFrame = (mCurrentFrame + 1) % mMaxFramesInFlight;
+        mFrameCount++;
+    }
+
+    void VulkanGraphicsContext::waitForFrame() {
+        // not reset, BeginRecording still waits on it and that returns right away now
+        vkWaitForFences(mDevice, 1, &mInFlightFences[mCurrentFrame], VK_TRUE, UINT64_MAX);
     }
 
     void VulkanGraphicsContext::cleanupSwapChain() {
@@ -782,7 +1142,7 @@ namespace Car {
     }
 
     void VulkanGraphicsContext::recreateSwapchain() {
-        vkDeviceWaitIdle(mDevice);
+        waitIdle();
 
         cleanupSwapChain();
 
@@ -791,7 +1151,12 @@ namespace Car {
         createFramebuffers();
     }
 
-    void VulkanGraphicsContext::resize(uint32_t, uint32_t) { recreateSwapchain(); }
+    void VulkanGraphicsContext::resize(uint32_t, uint32_t) { mSwapchainOutdated = true; }
+
+    void VulkanGraphicsContext::waitIdle() {
+        std::lock_guard<std::recursive_mutex> lock(mQueueMutex);
+        vkDeviceWaitIdle(mDevice);
+    }
 
     uint32_t VulkanGraphicsContext::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
         VkPhysicalDeviceMemoryProperties memProperties;
@@ -806,11 +1171,9 @@ namespace Car {
         throw std::runtime_error("failed to find suitable memory type!");
     }
 
-    // TODO: https://github.com/GPUOpen-LibrariesAndSDKs/VulkanMemoryAllocator
-    // or my own heap implementation maybe
     void VulkanGraphicsContext::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
                                              VkMemoryPropertyFlags properties, VkBuffer* pBuffer,
-                                             VkDeviceMemory* pBufferMemory) {
+                                             VulkanAllocation* pAllocation) {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
@@ -824,28 +1187,20 @@ namespace Car {
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(mDevice, *pBuffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        *pAllocation = mMemoryAllocator->allocate(memRequirements, properties, true);
 
-        // TODO: A custom heap implementation
-        if (vkAllocateMemory(mDevice, &allocInfo, nullptr, pBufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate buffer memory!");
-        }
-
-        vkBindBufferMemory(mDevice, *pBuffer, *pBufferMemory, 0);
+        vkBindBufferMemory(mDevice, *pBuffer, pAllocation->memory, pAllocation->offset);
     }
 
-    void VulkanGraphicsContext::freeBuffer(VkBuffer* pBuffer, VkDeviceMemory* pBufferMemory) {
+    void VulkanGraphicsContext::freeBuffer(VkBuffer* pBuffer, VulkanAllocation* pAllocation) {
         vkDestroyBuffer(mDevice, *pBuffer, nullptr);
-        vkFreeMemory(mDevice, *pBufferMemory, nullptr);
+        mMemoryAllocator->free(pAllocation);
+        *pBuffer = VK_NULL_HANDLE;
     }
 
-    // TODO: same as above
     void VulkanGraphicsContext::createImage2D(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
                                               VkImageUsageFlags usage, VkMemoryPropertyFlags properties,
-                                              VkImage* pImage, VkDeviceMemory* pImageMemory) {
+                                              VkImage* pImage, VulkanAllocation* pAllocation) {
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
         imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -868,21 +1223,24 @@ namespace Car {
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(mDevice, *pImage, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        *pAllocation = mMemoryAllocator->allocate(memRequirements, properties, tiling == VK_IMAGE_TILING_LINEAR);
 
-        if (vkAllocateMemory(mDevice, &allocInfo, nullptr, pImageMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
+        vkBindImageMemory(mDevice, *pImage, pAllocation->memory, pAllocation->offset);
+    }
 
-        vkBindImageMemory(mDevice, *pImage, *pImageMemory, 0);
+    void VulkanGraphicsContext::freeImage2D(VkImage* pImage, VulkanAllocation* pAllocation) {
+        vkDestroyImage(mDevice, *pImage, nullptr);
+        mMemoryAllocator->free(pAllocation);
+        *pImage = VK_NULL_HANDLE;
     }
 
     // TODO: We have command buffers allocated already so we dont need to create them on the fly
     void VulkanGraphicsContext::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size,
                                            VkDeviceSize srcOffset /*=0*/, VkDeviceSize dstOffset /*=0*/) {
+        // the buffer might still have an upload pending
+        mUploadQueue->waitIdle();
+
+        std::lock_guard<std::recursive_mutex> queueLock(mQueueMutex);
         VkCommandBuffer cmdBuffer = beginSingleTimeCommands(mTransferCommandPool);
 
         VkBufferCopy copyRegion{};
@@ -898,6 +1256,9 @@ namespace Car {
                                                       VkImageLayout newLayout) {
         UNUSED(format);
 
+        mUploadQueue->waitIdle();
+
+        std::lock_guard<std::recursive_mutex> queueLock(mQueueMutex);
         VkCommandBuffer commandBuffer = beginSingleTimeCommands(mTransferCommandPool);
 
         VkImageMemoryBarrier barrier{};
@@ -941,6 +1302,9 @@ namespace Car {
     void VulkanGraphicsContext::copyBufferToImage2D(VkBuffer* pBuffer, VkImage* pImage, uint32_t width, uint32_t height,
                                                     uint64_t srcOffset /*=0*/, uint64_t dstOffsetX /*=0*/,
                                                     uint64_t dstOffsetY /*=0*/) {
+        mUploadQueue->waitIdle();
+
+        std::lock_guard<std::recursive_mutex> queueLock(mQueueMutex);
         VkCommandBuffer commandBuffer = beginSingleTimeCommands(mTransferCommandPool);
 
         VkBufferImageCopy region{};
@@ -1017,8 +1381,8 @@ namespace Car {
 
     Ref<GraphicsContext> GraphicsContext::Get() { return sInstance; }
 
-    Ref<GraphicsContext> GraphicsContext::Create(GLFWwindow* windowHandle) {
-        Ref<GraphicsContext> context = createRef<VulkanGraphicsContext>(windowHandle);
+    Ref<GraphicsContext> GraphicsContext::Create(GLFWwindow* windowHandle, uint32_t maxFramesInFlight) {
+        Ref<GraphicsContext> context = createRef<VulkanGraphicsContext>(windowHandle, maxFramesInFlight);
 
         sInstance = context;
 
@@ -48,41 +48,23 @@ namespace Car {
             data = calloc(mSize, 1);
         }
 
-        VkDevice device = mGraphicsContext->getDevice();
         VkDeviceSize bufferSize = mSize;
 
         switch (mUsage) {
         case Buffer::Usage::DynamicDraw: {
             mGraphicsContext->createBuffer(bufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
                                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                           &mBuffer, &mBufferMemory);
+                                           &mBuffer, &mAllocation);
 
-            void* mappedData;
-            vkMapMemory(device, mBufferMemory, 0, mSize, 0, &mappedData);
-            memcpy(mappedData, data, (size_t)mSize);
-            vkUnmapMemory(device, mBufferMemory);
+            std::memcpy(mAllocation.mapped, data, (size_t)mSize);
             break;
         }
         case Buffer::Usage::StaticDraw: {
-            VkBuffer stagingBuffer;
-            VkDeviceMemory stagingBufferMemory;
-            mGraphicsContext->createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                           &stagingBuffer, &stagingBufferMemory);
-
-            void* mappedData;
-            vkMapMemory(device, stagingBufferMemory, 0, mSize, 0, &mappedData);
-            memcpy(mappedData, data, (size_t)mSize);
-            vkUnmapMemory(device, stagingBufferMemory);
-
             mGraphicsContext->createBuffer(bufferSize,
                                            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mBuffer, &mBufferMemory);
+                                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mBuffer, &mAllocation);
 
-            mGraphicsContext->copyBuffer(stagingBuffer, mBuffer, bufferSize, 0, 0);
-
-            vkDestroyBuffer(device, stagingBuffer, nullptr);
-            vkFreeMemory(device, stagingBufferMemory, nullptr);
+            mGraphicsContext->getUploadQueue().uploadBuffer(mBuffer, data, bufferSize);
             break;
         }
         default: {
@@ -98,10 +80,10 @@ namespace Car {
     }
 
     void VulkanIndexBuffer::releaseDeviceObjects() {
-        VkDevice device = mGraphicsContext->getDevice();
-
-        vkDeviceWaitIdle(device);
-        mGraphicsContext->freeBuffer(&mBuffer, &mBufferMemory);
+        // a static buffer might still be waiting for its upload
+        mGraphicsContext->getUploadQueue().waitIdle();
+        mGraphicsContext->waitIdle();
+        mGraphicsContext->freeBuffer(&mBuffer, &mAllocation);
     }
 
     VulkanIndexBuffer::~VulkanIndexBuffer() { releaseDeviceObjects(); }
@@ -166,35 +148,20 @@ namespace Car {
             }
         }
 
-        VkDevice device = mGraphicsContext->getDevice();
-
         if (offset == 0) {
             if (size <= mSize) {
                 switch (mUsage) {
                 case Buffer::Usage::DynamicDraw: {
-                    void* mappedData;
-                    vkMapMemory(device, mBufferMemory, 0, size, 0, &mappedData);
-                    std::memcpy(mappedData, data, (size_t)size);
-                    vkUnmapMemory(device, mBufferMemory);
+                    std::memcpy(mAllocation.mapped, data, (size_t)size);
                     break;
                 }
                 case Buffer::Usage::StaticDraw: {
-                    VkBuffer stagingBuffer;
-                    VkDeviceMemory stagingBufferMemory;
-                    mGraphicsContext->createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                   &stagingBuffer, &stagingBufferMemory);
-
-                    void* mappedData;
-                    vkMapMemory(device, stagingBufferMemory, 0, size, 0, &mappedData);
-                    std::memcpy(mappedData, data, (size_t)size);
-                    vkUnmapMemory(device, stagingBufferMemory);
+                    VulkanStagingBuffer staging = mGraphicsContext->getStagingPool().acquire(size);
+                    std::memcpy(staging.data(), data, (size_t)size);
 
-                    mGraphicsContext->copyBuffer(stagingBuffer, mBuffer, size, 0, 0);
+                    mGraphicsContext->copyBuffer(staging.buffer, mBuffer, size, 0, 0);
 
-                    vkDestroyBuffer(device, stagingBuffer, nullptr);
-                    vkFreeMemory(device, stagingBufferMemory, nullptr);
+                    mGraphicsContext->getStagingPool().release(&staging);
                     break;
                 }
                 default: {
@@ -204,8 +171,7 @@ namespace Car {
                 }
                 }
             } else {
-                vkDestroyBuffer(device, mBuffer, nullptr);
-                vkFreeMemory(device, mBufferMemory, nullptr);
+                mGraphicsContext->freeBuffer(&mBuffer, &mAllocation);
                 mSize = size;
                 VkDeviceSize bufferSize = size;
 
@@ -214,35 +180,17 @@ namespace Car {
                     mGraphicsContext->createBuffer(bufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
                                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                                                        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                   &mBuffer, &mBufferMemory);
+                                                   &mBuffer, &mAllocation);
 
-                    void* mappedData;
-                    vkMapMemory(device, mBufferMemory, 0, mSize, 0, &mappedData);
-                    std::memcpy(mappedData, data, (size_t)mSize);
-                    vkUnmapMemory(device, mBufferMemory);
+                    std::memcpy(mAllocation.mapped, data, (size_t)mSize);
                     break;
                 }
                 case Buffer::Usage::StaticDraw: {
-                    VkBuffer stagingBuffer;
-                    VkDeviceMemory stagingBufferMemory;
-                    mGraphicsContext->createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                   &stagingBuffer, &stagingBufferMemory);
-
-                    void* mappedData;
-                    vkMapMemory(device, stagingBufferMemory, 0, mSize, 0, &mappedData);
-                    std::memcpy(mappedData, data, (size_t)mSize);
-                    vkUnmapMemory(device, stagingBufferMemory);
-
                     mGraphicsContext->createBuffer(bufferSize,
                                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mBuffer, &mBufferMemory);
+                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mBuffer, &mAllocation);
 
-                    mGraphicsContext->copyBuffer(stagingBuffer, mBuffer, bufferSize, 0, 0);
-
-                    vkDestroyBuffer(device, stagingBuffer, nullptr);
-                    vkFreeMemory(device, stagingBufferMemory, nullptr);
+                    mGraphicsContext->getUploadQueue().uploadBuffer(mBuffer, data, bufferSize);
                     break;
                 }
                 default: {
@@ -256,29 +204,16 @@ namespace Car {
             if (offset + size <= mSize) {
                 switch (mUsage) {
                 case Buffer::Usage::DynamicDraw: {
-                    void* mappedData;
-                    vkMapMemory(device, mBufferMemory, offset, size, 0, &mappedData);
-                    std::memcpy(mappedData, data, (size_t)size);
-                    vkUnmapMemory(device, mBufferMemory);
+                    std::memcpy(mAllocation.mapped + offset, data, (size_t)size);
                     break;
                 }
                 case Buffer::Usage::StaticDraw: {
-                    VkBuffer stagingBuffer;
-                    VkDeviceMemory stagingBufferMemory;
-                    mGraphicsContext->createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                   &stagingBuffer, &stagingBufferMemory);
-
-                    void* mappedData;
-                    vkMapMemory(device, stagingBufferMemory, offset, size, 0, &mappedData);
-                    std::memcpy(mappedData, data, (size_t)size);
-                    vkUnmapMemory(device, stagingBufferMemory);
+                    VulkanStagingBuffer staging = mGraphicsContext->getStagingPool().acquire(size);
+                    std::memcpy(staging.data(), data, (size_t)size);
 
-                    mGraphicsContext->copyBuffer(stagingBuffer, mBuffer, size, 0, offset);
+                    mGraphicsContext->copyBuffer(staging.buffer, mBuffer, size, 0, offset);
 
-                    vkDestroyBuffer(device, stagingBuffer, nullptr);
-                    vkFreeMemory(device, stagingBufferMemory, nullptr);
+                    mGraphicsContext->getStagingPool().release(&staging);
                     break;
                 }
                 default: {
@@ -294,10 +229,7 @@ namespace Car {
                     if (offset <= mSize) {
                         temp = (uint8_t*)std::malloc(offset + size);
 
-                        void* mappedData;
-                        vkMapMemory(device, mBufferMemory, 0, offset, 0, &mappedData);
-                        std::memcpy(temp, mappedData, (size_t)offset);
-                        vkUnmapMemory(device, mBufferMemory);
+                        std::memcpy(temp, mAllocation.mapped, (size_t)offset);
 
                         std::memcpy(temp + offset, data, size);
 
@@ -307,10 +239,7 @@ namespace Car {
 
                         std::memset(temp + mSize - 1, 0, mSize - offset + 2);
 
-                        void* mappedData;
-                        vkMapMemory(device, mBufferMemory, 0, mSize, 0, &mappedData);
-                        std::memcpy(temp, mappedData, (size_t)mSize);
-                        vkUnmapMemory(device, mBufferMemory);
+                        std::memcpy(temp, mAllocation.mapped, (size_t)mSize);
 
                         std::memcpy(temp + offset, data, size);
 
@@ -322,12 +251,9 @@ namespace Car {
                     mGraphicsContext->createBuffer(mSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
                                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                                                        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                   &mBuffer, &mBufferMemory);
+                                                   &mBuffer, &mAllocation);
 
-                    void* mappedData;
-                    vkMapMemory(device, mBufferMemory, 0, mSize, 0, &mappedData);
-                    std::memcpy(mappedData, temp, (size_t)mSize);
-                    vkUnmapMemory(device, mBufferMemory);
+                    std::memcpy(mAllocation.mapped, temp, (size_t)mSize);
 
                     std::free(temp);
                     break;
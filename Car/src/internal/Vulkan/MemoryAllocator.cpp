@@ -0,0 +1,364 @@
+#include "Car/internal/Vulkan/MemoryAllocator.hpp"
+
+#include <unordered_set>
+
+// smallest piece a block is split into
+#define minOrder 8
+
+namespace Car {
+    struct VulkanMemoryBlock {
+        VkDeviceMemory memory;
+        uint8_t* mapped;
+        VkDeviceSize size;
+        uint32_t poolIndex;
+        uint32_t maxOrder;
+
+        // free offsets of every order, buddies are found by flipping the bit of their order
+        std::vector<std::unordered_set<VkDeviceSize>> freeLists;
+        // offset -> order and size of every live allocation, for the defragmentation hook
+        std::unordered_map<VkDeviceSize, std::pair<uint32_t, VkDeviceSize>> allocations;
+        VkDeviceSize usedBytes = 0;
+        // no new allocations while the block is being defragmented
+        bool draining = false;
+    };
+
+    static uint32_t orderOf(VkDeviceSize size) {
+        uint32_t order = minOrder;
+        while (((VkDeviceSize)1 << order) < size) {
+            order++;
+        }
+        return order;
+    }
+
+    VulkanMemoryAllocator::VulkanMemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device) {
+        mDevice = device;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &mMemoryProperties);
+
+        mPools.resize(mMemoryProperties.memoryTypeCount * 2);
+        for (uint32_t i = 0; i < mPools.size(); i++) {
+            const VkMemoryType& type = mMemoryProperties.memoryTypes[i / 2];
+            VkDeviceSize heapSize = mMemoryProperties.memoryHeaps[type.heapIndex].size;
+
+            // small heaps (like the 256MiB host visible device local one) would be used up by a couple of blocks
+            VkDeviceSize blockSize = CR_VULKAN_MEMORY_BLOCK_SIZE;
+            while (blockSize > ((VkDeviceSize)1 << 20) && blockSize > heapSize / 8) {
+                blockSize >>= 1;
+            }
+            mPools[i].blockSize = blockSize;
+        }
+    }
+
+    VulkanMemoryAllocator::~VulkanMemoryAllocator() {
+        CR_IF (mAllocationCount != 0) {
+            CR_CORE_WARN("Car::VulkanMemoryAllocator, {0} allocations were not freed", mAllocationCount);
+        }
+
+        for (Pool& pool : mPools) {
+            for (Scope<VulkanMemoryBlock>& block : pool.blocks) {
+                if (block->mapped != nullptr) {
+                    vkUnmapMemory(mDevice, block->memory);
+                }
+                vkFreeMemory(mDevice, block->memory, nullptr);
+            }
+        }
+    }
+
+    uint32_t VulkanMemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+        for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) &&
+                (mMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    VulkanMemoryBlock* VulkanMemoryAllocator::createBlock(uint32_t poolIndex) {
+        Pool& pool = mPools[poolIndex];
+        const uint32_t memoryTypeIndex = poolIndex / 2;
+
+        Scope<VulkanMemoryBlock> block = createScope<VulkanMemoryBlock>();
+        block->size = pool.blockSize;
+        block->poolIndex = poolIndex;
+        block->maxOrder = orderOf(pool.blockSize);
+        block->mapped = nullptr;
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = block->size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        if (vkAllocateMemory(mDevice, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) {
+            return nullptr;
+        }
+
+        if (mMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            void* mapped;
+            if (vkMapMemory(mDevice, block->memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+                vkFreeMemory(mDevice, block->memory, nullptr);
+                throw std::runtime_error("failed to map a memory block!");
+            }
+            block->mapped = (uint8_t*)mapped;
+        }
+
+        block->freeLists.resize(block->maxOrder + 1);
+        block->freeLists[block->maxOrder].insert(0);
+
+        pool.blocks.push_back(std::move(block));
+
+        return pool.blocks.back().get();
+    }
+
+    void VulkanMemoryAllocator::destroyBlock(VulkanMemoryBlock* pBlock) {
+        Pool& pool = mPools[pBlock->poolIndex];
+
+        if (pBlock->mapped != nullptr) {
+            vkUnmapMemory(mDevice, pBlock->memory);
+        }
+        vkFreeMemory(mDevice, pBlock->memory, nullptr);
+
+        pool.blocks.erase(std::find_if(pool.blocks.begin(), pool.blocks.end(),
+                                       [pBlock](const Scope<VulkanMemoryBlock>& b) { return b.get() == pBlock; }));
+    }
+
+    VulkanAllocation VulkanMemoryAllocator::allocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size) {
+        VulkanAllocation allocation{};
+        allocation.size = size;
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        if (vkAllocateMemory(mDevice, &allocInfo, nullptr, &allocation.memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate device memory!");
+        }
+
+        if (mMemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            void* mapped;
+            if (vkMapMemory(mDevice, allocation.memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+                vkFreeMemory(mDevice, allocation.memory, nullptr);
+                throw std::runtime_error("failed to map device memory!");
+            }
+            allocation.mapped = (uint8_t*)mapped;
+        }
+
+        mDedicatedBytes += size;
+        mDedicatedAllocationCount++;
+
+        return allocation;
+    }
+
+    VulkanAllocation VulkanMemoryAllocator::allocate(const VkMemoryRequirements& requirements,
+                                                     VkMemoryPropertyFlags properties, bool linear) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        const uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+        const uint32_t poolIndex = memoryTypeIndex * 2 + (linear ? 0 : 1);
+        Pool& pool = mPools[poolIndex];
+
+        mUsedBytes += requirements.size;
+        mAllocationCount++;
+
+        // buddies are aligned to their own size so the alignment only matters when it is larger than the allocation
+        const uint32_t order = orderOf(MAX(requirements.size, requirements.alignment));
+        if (((VkDeviceSize)1 << order) > pool.blockSize / 2) {
+            return allocateDedicated(memoryTypeIndex, requirements.size);
+        }
+
+        // the smallest free piece that fits in any block
+        VulkanMemoryBlock* pBlock = nullptr;
+        uint32_t foundOrder = 0;
+        for (Scope<VulkanMemoryBlock>& block : pool.blocks) {
+            if (block->draining) {
+                continue;
+            }
+            for (uint32_t o = order; o <= block->maxOrder; o++) {
+                if (!block->freeLists[o].empty() && (pBlock == nullptr || o < foundOrder)) {
+                    pBlock = block.get();
+                    foundOrder = o;
+                    break;
+                }
+            }
+            if (pBlock != nullptr && foundOrder == order) {
+                break;
+            }
+        }
+
+        if (pBlock == nullptr) {
+            pBlock = createBlock(poolIndex);
+            // out of device memory for another block, the allocation might still fit on its own
+            if (pBlock == nullptr) {
+                return allocateDedicated(memoryTypeIndex, requirements.size);
+            }
+            foundOrder = pBlock->maxOrder;
+        }
+
+        std::unordered_set<VkDeviceSize>& freeList = pBlock->freeLists[foundOrder];
+        VkDeviceSize offset = *freeList.begin();
+        freeList.erase(freeList.begin());
+
+        // split down to the wanted order, the upper halves become free buddies
+        while (foundOrder > order) {
+            foundOrder--;
+            pBlock->freeLists[foundOrder].insert(offset + ((VkDeviceSize)1 << foundOrder));
+        }
+
+        pBlock->allocations[offset] = {order, requirements.size};
+        pBlock->usedBytes += (VkDeviceSize)1 << order;
+
+        VulkanAllocation allocation{};
+        allocation.memory = pBlock->memory;
+        allocation.offset = offset;
+        allocation.size = requirements.size;
+        allocation.mapped = pBlock->mapped != nullptr ? pBlock->mapped + offset : nullptr;
+        allocation.pBlock = pBlock;
+        allocation.order = order;
+
+        return allocation;
+    }
+
+    void VulkanMemoryAllocator::free(VulkanAllocation* pAllocation) {
+        if (pAllocation->memory == VK_NULL_HANDLE) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        mUsedBytes -= pAllocation->size;
+        mAllocationCount--;
+
+        if (pAllocation->pBlock == nullptr) {
+            if (pAllocation->mapped != nullptr) {
+                vkUnmapMemory(mDevice, pAllocation->memory);
+            }
+            vkFreeMemory(mDevice, pAllocation->memory, nullptr);
+
+            mDedicatedBytes -= pAllocation->size;
+            mDedicatedAllocationCount--;
+            *pAllocation = {};
+            return;
+        }
+
+        VulkanMemoryBlock* pBlock = pAllocation->pBlock;
+        VkDeviceSize offset = pAllocation->offset;
+        uint32_t order = pAllocation->order;
+
+        pBlock->allocations.erase(offset);
+        pBlock->usedBytes -= (VkDeviceSize)1 << order;
+
+        // merge with the buddy for as long as it is free
+        while (order < pBlock->maxOrder) {
+            VkDeviceSize buddy = offset ^ ((VkDeviceSize)1 << order);
+            std::unordered_set<VkDeviceSize>& freeList = pBlock->freeLists[order];
+            auto it = freeList.find(buddy);
+            if (it == freeList.end()) {
+                break;
+            }
+            freeList.erase(it);
+            offset = MIN(offset, buddy);
+            order++;
+        }
+        pBlock->freeLists[order].insert(offset);
+
+        // one empty block is kept around so a resource that is recreated every frame doesnt allocate a block every
+        // frame, this one only goes if the pool already has another empty one
+        if (pBlock->usedBytes == 0 && !pBlock->draining) {
+            for (const Scope<VulkanMemoryBlock>& block : mPools[pBlock->poolIndex].blocks) {
+                if (block.get() != pBlock && block->usedBytes == 0 && !block->draining) {
+                    destroyBlock(pBlock);
+                    break;
+                }
+            }
+        }
+
+        *pAllocation = {};
+    }
+
+    void VulkanMemoryAllocator::trim() {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        for (Pool& pool : mPools) {
+            for (size_t i = pool.blocks.size(); i > 0; i--) {
+                if (pool.blocks[i - 1]->usedBytes == 0 && !pool.blocks[i - 1]->draining) {
+                    destroyBlock(pool.blocks[i - 1].get());
+                }
+            }
+        }
+    }
+
+    uint32_t VulkanMemoryAllocator::defragment(float maxBlockUsage) {
+        if (!mDefragmentationCallback) {
+            return 0;
+        }
+
+        std::vector<VulkanAllocation> candidates;
+        std::vector<VulkanMemoryBlock*> drainedBlocks;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            for (Pool& pool : mPools) {
+                // a single block has nowhere to move to
+                if (pool.blocks.size() < 2) {
+                    continue;
+                }
+
+                for (Scope<VulkanMemoryBlock>& block : pool.blocks) {
+                    if (block->usedBytes == 0 || (float)block->usedBytes / (float)block->size > maxBlockUsage) {
+                        continue;
+                    }
+
+                    block->draining = true;
+                    drainedBlocks.push_back(block.get());
+
+                    for (const auto& [offset, allocationInfo] : block->allocations) {
+                        VulkanAllocation allocation{};
+                        allocation.memory = block->memory;
+                        allocation.offset = offset;
+                        allocation.size = allocationInfo.second;
+                        allocation.mapped = block->mapped != nullptr ? block->mapped + offset : nullptr;
+                        allocation.pBlock = block.get();
+                        allocation.order = allocationInfo.first;
+                        candidates.push_back(allocation);
+                    }
+                }
+            }
+        }
+
+        // the callback allocates and frees so the lock cant be held
+        for (const VulkanAllocation& allocation : candidates) {
+            mDefragmentationCallback(allocation);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            for (VulkanMemoryBlock* pBlock : drainedBlocks) {
+                pBlock->draining = false;
+            }
+        }
+
+        trim();
+
+        return candidates.size();
+    }
+
+    VulkanMemoryAllocator::Stats VulkanMemoryAllocator::getStats() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        Stats stats{};
+        stats.usedBytes = mUsedBytes;
+        stats.reservedBytes = mDedicatedBytes;
+        stats.allocationCount = mAllocationCount;
+        stats.dedicatedAllocationCount = mDedicatedAllocationCount;
+
+        for (const Pool& pool : mPools) {
+            stats.blockCount += pool.blocks.size();
+            stats.reservedBytes += pool.blocks.size() * pool.blockSize;
+        }
+
+        return stats;
+    }
+} // namespace Car
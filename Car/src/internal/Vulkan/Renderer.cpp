@@ -1,6 +1,7 @@
 #include "Car/Core/Ref.hpp"
 #include "Car/Renderer/VertexArray.hpp"
 
+#include "Car/internal/Vulkan/ComputeShader.hpp"
 #include "Car/internal/Vulkan/GraphicsContext.hpp"
 #include "Car/internal/Vulkan/Shader.hpp"
 #include "Car/internal/Vulkan/Renderer.hpp"
@@ -15,6 +16,8 @@ namespace Car {
     Renderer* Renderer::sInstance = new VulkanRenderer();
     Ref<VulkanGraphicsContext> sGraphicsContext;
     static VulkanRendererData* sData;
+    // between BeginRecording and EndRecording, only on the thread that records (the render thread if there is one)
+    static thread_local bool tRecording = false;
 
     void VulkanRenderer::InitImpl() {
         sData = new VulkanRendererData();
@@ -40,6 +43,8 @@ namespace Car {
         VkFence inFlightFence = sGraphicsContext->getCurrentInFlightFence();
         vkWaitForFences(device, 1, &inFlightFence, VK_TRUE, UINT64_MAX);
         vkResetFences(device, 1, &inFlightFence);
+        // nothing of this frame index is in flight anymore
+        sGraphicsContext->getDescriptorAllocator().beginFrame(sGraphicsContext->getCurrentFrameIndex());
 
         uint32_t imageIndex = sGraphicsContext->aquireNextImageIndex();
         vkResetCommandBuffer(cmdBuffer, /*VkCommandBufferResetFlagBits*/ 0);
@@ -47,6 +52,7 @@ namespace Car {
         if (vkBeginCommandBuffer(cmdBuffer, &beginInfo) != VK_SUCCESS) {
             throw std::runtime_error("failed to begin recording command buffer!");
         }
+        sGraphicsContext->resetBoundGraphicsState();
 
         VkClearValue clearColor;
         std::memcpy(clearColor.color.float32, glm::value_ptr(sData->clearColor), sizeof(glm::vec4));
@@ -75,10 +81,13 @@ namespace Car {
         scissor.offset = {0, 0};
         scissor.extent = swapChainExtent;
         vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
+
+        tRecording = true;
     }
 
     void VulkanRenderer::EndRecordingImpl() {
         VkCommandBuffer cmdBuffer = sGraphicsContext->getCurrentRenderCommandBuffer();
+        tRecording = false;
 
         vkCmdEndRenderPass(cmdBuffer);
         if (vkEndCommandBuffer(cmdBuffer) != VK_SUCCESS) {
@@ -100,20 +109,39 @@ namespace Car {
             return;
         }
         
-        VkShaderStageFlags stageFlags = 0;
-
-        if (vert) {
-            stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
-        }
-        if (frag) {
-            stageFlags |= VK_SHADER_STAGE_FRAGMENT_BIT;
+        Ref<VulkanShader> shader = reinterpretCastRef<VulkanShader>(va->getShader());
+
+        // the reflected ranges know better which stages the bytes belong to
+        VkShaderStageFlags stageFlags = shader->getPushConstantStages(offset, size);
+        if (stageFlags == 0) {
+            if (vert) {
+                stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+            }
+            if (frag) {
+                stageFlags |= VK_SHADER_STAGE_FRAGMENT_BIT;
+            }
         }
         
         VkCommandBuffer cmdBuffer = sGraphicsContext->getCurrentRenderCommandBuffer();
         
-        vkCmdPushConstants(cmdBuffer, reinterpretCastRef<VulkanShader>(va->getShader())->getPipelineLayout(), stageFlags, offset, size, data);
+        vkCmdPushConstants(cmdBuffer, shader->getPipelineLayout(), stageFlags, offset, size, data);
     }
     
+    void VulkanRenderer::DispatchImpl(const Ref<ComputeShader> shader, uint32_t groupCountX, uint32_t groupCountY,
+                                      uint32_t groupCountZ) {
+        // the fence of the frame has to be waited on before its compute command buffer can be reused
+        CR_IF (!tRecording) {
+            CR_CORE_ERROR("Car::Renderer::Dispatch(shader, x, y, z), can only dispatch while recording (in onRender "
+                          "without a render thread)");
+            return;
+        }
+        if (groupCountX == 0 || groupCountY == 0 || groupCountZ == 0) {
+            return;
+        }
+
+        reinterpretCastRef<VulkanComputeShader>(shader)->dispatch(groupCountX, groupCountY, groupCountZ);
+    }
+
     void VulkanRenderer::SetViewportImpl(float x, float y, float width, float height, float minDepth, float maxDepth) {
         VkCommandBuffer cmdBuffer = sGraphicsContext->getCurrentRenderCommandBuffer();
 
@@ -147,4 +175,12 @@ namespace Car {
 
         vkCmdDrawIndexed(cmdBuffer, indicesCount, 1, 0, 0, 0);
     }
+
+    void VulkanRenderer::DrawInstancedImpl(const Ref<VertexArray> va, uint32_t vertexCount, uint32_t instanceCount) {
+        va->bind();
+
+        VkCommandBuffer cmdBuffer = sGraphicsContext->getCurrentRenderCommandBuffer();
+
+        vkCmdDraw(cmdBuffer, vertexCount, instanceCount, 0, 0);
+    }
 } // namespace Car
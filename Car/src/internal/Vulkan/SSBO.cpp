@@ -1,27 +1,107 @@
 #include "Car/internal/Vulkan/SSBO.hpp"
+#include "Car/Core/Log.hpp"
+#include "Car/Core/Ref.hpp"
 
+#include <cstring>
 #include <glad/vulkan.h>
 #include <stdexcept>
 
 namespace Car {
     VulkanSSBO::VulkanSSBO(void* data, uint64_t size, Buffer::Usage usage) {
-        UNUSED(data);
-        UNUSED(usage);
+        mGraphicsContext = reinterpretCastRef<VulkanGraphicsContext>(GraphicsContext::Get());
         mSize = size;
-        
-        throw std::runtime_error("Vulkan SSBO not implemented yet");
+        mUsage = usage;
+
+        switch (mUsage) {
+        case Buffer::Usage::StaticDraw: {
+            mBuffers.resize(1);
+            mAllocations.resize(1);
+            mGraphicsContext->createBuffer(mSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mBuffers[0], &mAllocations[0]);
+
+            bool shouldFree = data == nullptr;
+            if (data == nullptr) {
+                data = calloc(size, 1);
+            }
+
+            mGraphicsContext->getUploadQueue().uploadBuffer(mBuffers[0], data, mSize);
+
+            if (shouldFree) {
+                free(data);
+            }
+            break;
+        }
+        case Buffer::Usage::DynamicDraw:
+        case Buffer::Usage::Stream: {
+            mBuffers.resize(mGraphicsContext->getMaxFramesInFlight());
+            mAllocations.resize(mGraphicsContext->getMaxFramesInFlight());
+
+            for (size_t i = 0; i < mBuffers.size(); i++) {
+                mGraphicsContext->createBuffer(mSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                               &mBuffers[i], &mAllocations[i]);
+
+                // nothing can be reading them yet so every copy starts out with the data
+                if (data != nullptr) {
+                    std::memcpy(mAllocations[i].mapped, data, (size_t)mSize);
+                } else {
+                    std::memset(mAllocations[i].mapped, 0, (size_t)mSize);
+                }
+            }
+            break;
+        }
+        default: {
+            throw std::runtime_error("Unrecognized usage passed to Car::SSBO::Create(data, size, usage)");
+            break;
+        }
+        }
     }
 
-    VulkanSSBO::~VulkanSSBO() {}
+    VulkanSSBO::~VulkanSSBO() {
+        // a static buffer might still be waiting for its upload and any buffer can be read by a frame in flight
+        mGraphicsContext->getUploadQueue().waitIdle();
+        mGraphicsContext->waitIdle();
 
-    void VulkanSSBO::updateBuffer(void* data, uint64_t size) {
-        UNUSED(data);
-        UNUSED(size);
+        for (size_t i = 0; i < mBuffers.size(); i++) {
+            mGraphicsContext->freeBuffer(&mBuffers[i], &mAllocations[i]);
+        }
     }
 
-    void VulkanSSBO::bind(uint32_t binding) const { UNUSED(binding); }
+    VkDescriptorBufferInfo VulkanSSBO::getDescriptorBufferInfo(uint32_t i) {
+        VkDescriptorBufferInfo bufferInfo{};
+        bufferInfo.buffer = mBuffers[mUsage == Buffer::Usage::StaticDraw ? 0 : i];
+        bufferInfo.offset = 0;
+        bufferInfo.range = mSize;
 
-    void VulkanSSBO::unbind() const {}
+        return bufferInfo;
+    }
+
+    void VulkanSSBO::updateBuffer(void* data, uint64_t size, uint64_t offset) {
+        CR_IF (data == nullptr) {
+            CR_CORE_ERROR("Car::SSBO::updateBuffer(data, size, offset), data can not be a null pointer");
+            return;
+        }
+        CR_IF (size + offset > mSize) {
+            CR_CORE_ERROR("Car::SSBO::updateBuffer(data, size, offset), size + offset ({0}) is bigger than the "
+                          "buffer ({1})",
+                          size + offset, mSize);
+            CR_DEBUGBREAK();
+            return;
+        }
+
+        if (mUsage == Buffer::Usage::StaticDraw) {
+            VulkanStagingBuffer staging = mGraphicsContext->getStagingPool().acquire(size);
+            std::memcpy(staging.data(), data, (size_t)size);
+
+            mGraphicsContext->copyBuffer(staging.buffer, mBuffers[0], size, 0, offset);
+
+            mGraphicsContext->getStagingPool().release(&staging);
+            return;
+        }
+
+        std::memcpy(mAllocations[mGraphicsContext->getCurrentFrameIndex()].mapped + offset, data, (size_t)size);
+    }
 
     Ref<SSBO> SSBO::Create(void* data, uint64_t size, Buffer::Usage usage) {
         return createRef<VulkanSSBO>(data, size, usage);
@@ -4,17 +4,21 @@
 #include "Car/Renderer/UniformBuffer.hpp"
 #include "Car/internal/Vulkan/CompiledShader.hpp"
 #include "Car/internal/Vulkan/GraphicsContext.hpp"
+#include "Car/internal/Vulkan/ShaderBundle.hpp"
 #include "Car/Utils.hpp"
 
 #include "Car/ResourceManager.hpp"
+#include "Car/internal/Vulkan/SSBO.hpp"
 #include "Car/internal/Vulkan/Texture2D.hpp"
 #include "Car/internal/Vulkan/UniformBuffer.hpp"
 
 #include <glad/vulkan.h>
+#include <mutex>
 #include <stdexcept>
 
 #if defined(CR_HAVE_SPIRV_CROSS) && defined(CR_HAVE_SHADERC)
-#include <spirv_cross/spirv_cross.hpp>
+#include "Car/internal/Vulkan/ShaderIncluder.hpp"
+#include "Car/internal/Vulkan/ShaderReflection.hpp"
 #include <shaderc/shaderc.hpp>
 #define CR_CAN_COMPILE_SHADER 1
 #else
@@ -65,7 +69,7 @@ namespace Car {
             return VK_FORMAT_UNDEFINED;
         }
     }
-    
+
     /////////////////////////////////////////
     /////// Constructor & Destructor ////////
     /////////////////////////////////////////
@@ -77,18 +81,18 @@ namespace Car {
         createDescriptors();
         createPipelineLayout();
         createGraphicsPipeline();
+
+        // the spir-v is not owned by the shader
+        mCompiledShader.pVertexCode = nullptr;
+        mCompiledShader.pFragmeantCode = nullptr;
     }
 
     VulkanShader::~VulkanShader() {
         VkDevice device = mGraphicsContext->getDevice();
 
-        vkDeviceWaitIdle(device);
-
-        for (const VkDescriptorSetLayout& descriptorSetLayout : mDescriptorSetLayouts) {
-            vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
-        }
+        mGraphicsContext->waitIdle();
 
-        // vkFreeDescriptorSets
+        mDescriptors.reset();
 
         vkDestroyPipeline(device, mGraphicsPipeline, nullptr);
         vkDestroyPipelineLayout(device, mPipelineLayout, nullptr);
@@ -99,236 +103,54 @@ namespace Car {
     /////////////////////////////////////////
 
     void VulkanShader::setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<UniformBuffer> ub) {
-        CR_IF (set > mCompiledShader.sets.size()) {
-            CR_CORE_ERROR("set {0} binding {1} does not exist", set, binding);
-            CR_DEBUGBREAK();
-            return;
-        }
-        CR_IF (1) {
-            bool exists = false;
-            for (const Descriptor& descriptor : mCompiledShader.sets[set]) {
-                if (descriptor.binding == binding) {
-                    if (descriptor.descriptorType != DescriptorType::UniformBuffer) {
-                        CR_CORE_ERROR("set {0} binding {1} is not a uniformbuffer", set, binding);
-                        CR_DEBUGBREAK();
-                        return;
-                    }
-                    exists = true;
-                }
-            }
-
-            if (!exists) {
-                CR_CORE_ERROR("set {0} binding {1} does not exist", set, binding);
-                CR_DEBUGBREAK();
-                return;
-            }
-        }
-
-        VkDevice device = mGraphicsContext->getDevice();
-        if (applyToAll) {
-            for (size_t i = 0; i < mGraphicsContext->getMaxFramesInFlight(); i++) {
-                VkDescriptorBufferInfo bufferInfo =
-                    reinterpretCastRef<VulkanUniformBuffer>(ub)->getDescriptorBufferInfo(i);
-
-                VkWriteDescriptorSet descriptorWrite{};
-                descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrite.dstSet = mDescriptorSets[i][set];
-                descriptorWrite.dstBinding = binding;
-                descriptorWrite.dstArrayElement = 0;
-                descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                descriptorWrite.descriptorCount = 1;
-                descriptorWrite.pBufferInfo = &bufferInfo;
-                descriptorWrite.pImageInfo = nullptr;
-                descriptorWrite.pTexelBufferView = nullptr;
-
-                vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
-            }
-        } else {
-            VkDescriptorBufferInfo bufferInfo = reinterpretCastRef<VulkanUniformBuffer>(ub)->getDescriptorBufferInfo(
-                mGraphicsContext->getCurrentFrameIndex());
-
-            VkWriteDescriptorSet descriptorWrite{};
-            descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrite.dstSet = mDescriptorSets[mGraphicsContext->getCurrentFrameIndex()][set];
-            descriptorWrite.dstBinding = binding;
-            descriptorWrite.dstArrayElement = 0;
-            descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descriptorWrite.descriptorCount = 1;
-            descriptorWrite.pBufferInfo = &bufferInfo;
-            descriptorWrite.pImageInfo = nullptr;
-            descriptorWrite.pTexelBufferView = nullptr;
-
-            vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
-        }
+        mDescriptors->setInput(set, binding, applyToAll, ub);
     }
 
     void VulkanShader::setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<Texture2D> texture) {
-        CR_IF (set > mCompiledShader.sets.size()) {
-            CR_CORE_ERROR("set {0} binding {1} does not exist", set, binding);
-            CR_DEBUGBREAK();
-            return;
-        }
-        CR_IF (1) {
-            bool exists = false;
-            for (const Descriptor& descriptor : mCompiledShader.sets[set]) {
-                if (descriptor.binding == binding) {
-                    if (descriptor.descriptorType != DescriptorType::Sampler2D) {
-                        CR_CORE_ERROR("set {0} binding {1} is not a sampler2D", set, binding);
-                        CR_DEBUGBREAK();
-                        return;
-                    }
-                    exists = true;
-                }
-            }
+        mDescriptors->setInput(set, binding, applyToAll, texture);
+    }
 
-            if (!exists) {
-                CR_CORE_ERROR("set {0} binding {1} does not exist", set, binding);
-                CR_DEBUGBREAK();
-                return;
-            }
-        }
+    void VulkanShader::setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<SSBO> ssbo) {
+        mDescriptors->setInput(set, binding, applyToAll, ssbo);
+    }
 
-        VkDevice device = mGraphicsContext->getDevice();
-        if (applyToAll) {
-            for (size_t i = 0; i < mGraphicsContext->getMaxFramesInFlight(); i++) {
-                VkDescriptorImageInfo imageInfo =
-                    reinterpretCastRef<VulkanTexture2D>(texture)->getDescriptorImageInfo();
-
-                VkWriteDescriptorSet descriptorWrite{};
-                descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrite.dstSet = mDescriptorSets[i][set];
-                descriptorWrite.dstBinding = binding;
-                descriptorWrite.dstArrayElement = 0;
-                descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                descriptorWrite.descriptorCount = 1;
-                descriptorWrite.pBufferInfo = nullptr;
-                descriptorWrite.pImageInfo = &imageInfo;
-                descriptorWrite.pTexelBufferView = nullptr;
-
-                vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+    VkShaderStageFlags VulkanShader::getPushConstantStages(uint32_t offset, uint32_t size) const {
+        // vkCmdPushConstants has to name every stage whose range overlaps the bytes that are updated
+        VkShaderStageFlags stageFlags = 0;
+        for (const VkPushConstantRange& range : mPushConstantRanges) {
+            if (offset < range.offset + range.size && range.offset < offset + size) {
+                stageFlags |= range.stageFlags;
             }
-        } else {
-            VkDescriptorImageInfo imageInfo = reinterpretCastRef<VulkanTexture2D>(texture)->getDescriptorImageInfo();
-
-            VkWriteDescriptorSet descriptorWrite{};
-            descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrite.dstSet = mDescriptorSets[mGraphicsContext->getCurrentFrameIndex()][set];
-            descriptorWrite.dstBinding = binding;
-            descriptorWrite.dstArrayElement = 0;
-            descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            descriptorWrite.descriptorCount = 1;
-            descriptorWrite.pBufferInfo = nullptr;
-            descriptorWrite.pImageInfo = &imageInfo;
-            descriptorWrite.pTexelBufferView = nullptr;
-
-            vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
         }
+        return stageFlags;
     }
-    
+
     void VulkanShader::bind() const {
         VkCommandBuffer cmdBuffer = mGraphicsContext->getCurrentRenderCommandBuffer();
-        if (mCompiledShader.sets.size()) {
-            // maybe it shouldnt bind it if it doesnt changes
+        const uint32_t frame = mGraphicsContext->getCurrentFrameIndex();
+        VulkanGraphicsContext::BoundGraphicsState& bound = mGraphicsContext->getBoundGraphicsState();
+
+        if (bound.pipeline != mGraphicsPipeline) {
+            vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline);
+            bound.pipeline = mGraphicsPipeline;
+        }
+
+        // sets bound with the same layout stay valid no matter which pipelines were bound since
+        const std::vector<VkDescriptorSet>& descriptorSets = mDescriptors->getDescriptorSets(frame);
+        if (!descriptorSets.empty() && (bound.layout != mPipelineLayout || bound.descriptorSets != descriptorSets)) {
             vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0,
-                                    mDescriptorSets[mGraphicsContext->getCurrentFrameIndex()].size(),
-                                    mDescriptorSets[mGraphicsContext->getCurrentFrameIndex()].data(), 0, nullptr);
+                                    descriptorSets.size(), descriptorSets.data(), 0, nullptr);
+            bound.layout = mPipelineLayout;
+            bound.descriptorSets = descriptorSets;
         }
-        vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline);
     }
-    
+
     /////////////////////////////////////////
     //////////// Object Creation ////////////
     /////////////////////////////////////////
 
     void VulkanShader::createDescriptors() {
-        VkDevice device = mGraphicsContext->getDevice();
-
-        mDescriptorSetLayouts.resize(mCompiledShader.sets.size());
-        mDescriptorSets.resize(mGraphicsContext->getMaxFramesInFlight());
-        for (uint32_t i = 0; i < mGraphicsContext->getMaxFramesInFlight(); i++) {
-            mDescriptorSets[i].resize(mCompiledShader.sets.size());
-        }
-
-        for (uint32_t i = 0; i < mCompiledShader.sets.size(); i++) {
-            std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayouts;
-            for (uint32_t j = 0; j < mCompiledShader.sets[i].size(); j++) {
-                switch (mCompiledShader.sets[i][j].descriptorType) {
-                case Car::DescriptorType::UniformBuffer: {
-                    VkDescriptorSetLayoutBinding uboLayoutBinding{};
-                    uboLayoutBinding.binding = mCompiledShader.sets[i][j].binding;
-                    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                    uboLayoutBinding.descriptorCount = 1;
-
-                    switch (mCompiledShader.sets[i][j].stageFlags) {
-                    case Car::DescriptorStage::VertexShader:
-                        uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-                        break;
-                    case Car::DescriptorStage::FragmeantShader:
-                        uboLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-                        break;
-                    case Car::DescriptorStage::Combined:
-                        uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-                        break;
-                    }
-                    uboLayoutBinding.pImmutableSamplers = nullptr;
-
-                    descriptorSetLayouts.push_back(uboLayoutBinding);
-                    break;
-                }
-                case Car::DescriptorType::Sampler2D: {
-                    VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-                    samplerLayoutBinding.binding = mCompiledShader.sets[i][j].binding;
-                    samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                    samplerLayoutBinding.descriptorCount = 1;
-
-                    switch (mCompiledShader.sets[i][j].stageFlags) {
-                    case Car::DescriptorStage::VertexShader:
-                        samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-                        break;
-                    case Car::DescriptorStage::FragmeantShader:
-                        samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-                        break;
-                    case Car::DescriptorStage::Combined:
-                        samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-                        break;
-                    }
-                    samplerLayoutBinding.pImmutableSamplers = nullptr;
-
-                    descriptorSetLayouts.push_back(samplerLayoutBinding);
-                    break;
-                }
-                case Car::DescriptorType::NONE: {
-                    throw std::runtime_error("internal error in VulkanShader.cpp in createDescriptors");
-                }
-                }
-            }
-
-            VkDescriptorSetLayoutCreateInfo layoutInfo{};
-            layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-            layoutInfo.bindingCount = descriptorSetLayouts.size();
-            layoutInfo.pBindings = descriptorSetLayouts.data();
-
-            if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &mDescriptorSetLayouts[i]) != VK_SUCCESS) {
-                throw std::runtime_error("failed to create descriptor set layout!");
-            }
-
-            std::vector<VkDescriptorSetLayout> layouts(mGraphicsContext->getMaxFramesInFlight(),
-                                                       mDescriptorSetLayouts[i]);
-            VkDescriptorSetAllocateInfo allocInfo{};
-            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-            allocInfo.descriptorPool = mGraphicsContext->getDescriptorPool();
-            allocInfo.descriptorSetCount = layouts.size();
-            allocInfo.pSetLayouts = layouts.data();
-
-            std::vector<VkDescriptorSet> descriptorSets(mGraphicsContext->getMaxFramesInFlight());
-
-            if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
-                throw std::runtime_error("failed to allocate descriptor sets!");
-            }
-            for (uint32_t k = 0; k < descriptorSets.size(); k++) {
-                mDescriptorSets[k][i] = descriptorSets[k];
-            }
-        }
+        mDescriptors = createScope<VulkanShaderDescriptors>(mGraphicsContext.get(), mCompiledShader.sets);
     }
 
     void VulkanShader::createPipelineLayout() {
@@ -336,40 +158,48 @@ namespace Car {
 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        if (mDescriptorSetLayouts.size() > 0) {
-            pipelineLayoutInfo.setLayoutCount = mDescriptorSetLayouts.size();
-            pipelineLayoutInfo.pSetLayouts = mDescriptorSetLayouts.data();
+        const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts = mDescriptors->getSetLayouts();
+        if (descriptorSetLayouts.size() > 0) {
+            pipelineLayoutInfo.setLayoutCount = descriptorSetLayouts.size();
+            pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
         } else {
             pipelineLayoutInfo.setLayoutCount = 0;
             pipelineLayoutInfo.pSetLayouts = nullptr;
         }
         
-        VkPushConstantRange pushConstantRange;
-        pushConstantRange.stageFlags = (mSpec.pushConstantLayout.useInVertexShader ? VK_SHADER_STAGE_VERTEX_BIT : 0) |
-                                       (mSpec.pushConstantLayout.useInFragmentShader ? VK_SHADER_STAGE_FRAGMENT_BIT : 0);
-        
-        pushConstantRange.size = mSpec.pushConstantLayout.size;
-        pushConstantRange.offset = 0;
-        
-        if (mSpec.pushConstantLayout.size > 0) {
+        // the reflected ranges are exact, the specification is only used for shaders without reflection data
+        mPushConstantRanges.clear();
+        for (const PushConstantRange& range : mCompiledShader.pushConstants) {
+            mPushConstantRanges.push_back({DescriptorStageToVulkanStage(range.stageFlags), range.offset, range.size});
+        }
+        if (mPushConstantRanges.empty() && mSpec.pushConstantLayout.size > 0) {
             CR_IF (!mSpec.pushConstantLayout.useInVertexShader && !mSpec.pushConstantLayout.useInFragmentShader) {
                 CR_CORE_ERROR("a push constant should be used in vertex shader or fragmeant shader or both");
                 CR_DEBUGBREAK();
                 return;
             }
-            CR_IF (mSpec.pushConstantLayout.size > 128) {
+
+            VkPushConstantRange pushConstantRange;
+            pushConstantRange.stageFlags =
+                (mSpec.pushConstantLayout.useInVertexShader ? VK_SHADER_STAGE_VERTEX_BIT : 0) |
+                (mSpec.pushConstantLayout.useInFragmentShader ? VK_SHADER_STAGE_FRAGMENT_BIT : 0);
+            pushConstantRange.size = mSpec.pushConstantLayout.size;
+            pushConstantRange.offset = 0;
+            mPushConstantRanges.push_back(pushConstantRange);
+        }
+
+        for (const VkPushConstantRange& range : mPushConstantRanges) {
+            UNUSED(range);
+            CR_IF (range.offset + range.size > 128) {
                 CR_CORE_ERROR("push constant size cant be bigger then 128 bytes");
                 CR_DEBUGBREAK();
                 return;
             }
-            
-            pipelineLayoutInfo.pushConstantRangeCount = 1;
-            pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-        } else {
-            pipelineLayoutInfo.pushConstantRangeCount = 0;
-            pipelineLayoutInfo.pPushConstantRanges = nullptr;
         }
-        
+
+        pipelineLayoutInfo.pushConstantRangeCount = mPushConstantRanges.size();
+        pipelineLayoutInfo.pPushConstantRanges = mPushConstantRanges.empty() ? nullptr : mPushConstantRanges.data();
+
         if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS) {
             throw std::runtime_error("failed to create pipeline layout!");
         }
@@ -378,8 +208,10 @@ namespace Car {
     void VulkanShader::createGraphicsPipeline() {
         VkDevice device = mGraphicsContext->getDevice();
 
-        VkShaderModule vertShaderModule = createShaderModule(mCompiledShader.vertexShader);
-        VkShaderModule fragShaderModule = createShaderModule(mCompiledShader.fragmeantShader);
+        VkShaderModule vertShaderModule =
+            createShaderModule(mCompiledShader.pVertexCode, mCompiledShader.vertexCodeSize);
+        VkShaderModule fragShaderModule =
+            createShaderModule(mCompiledShader.pFragmeantCode, mCompiledShader.fragmeantCodeSize);
 
         VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
         vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -402,14 +234,39 @@ namespace Car {
         dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
         dynamicState.pDynamicStates = dynamicStates.data();
 
+        // the formats and offsets come from the specification since normalized bytes look like floats to the
+        // shader, the locations come from the shader. without a layout the reflected inputs are tightly packed
+        const std::vector<VertexInput>& inputs = mCompiledShader.vertexInputs;
+        std::vector<VertexInputLayout::Element> elements = mSpec.vertexInputLayout.getElements();
+        uint32_t stride = mSpec.vertexInputLayout.getTotalSize();
+        if (elements.empty()) {
+            stride = 0;
+            for (const VertexInput& input : inputs) {
+                VertexInputLayout::Element element("", input.type);
+                element.offset = stride;
+                stride += element.size;
+                elements.push_back(element);
+            }
+        }
+
+        CR_IF (!inputs.empty() && elements.size() != inputs.size()) {
+            CR_CORE_ERROR("the vertex input layout has {0} elements but the vertex shader takes {1} inputs",
+                          elements.size(), inputs.size());
+            CR_DEBUGBREAK();
+        }
+
         VkVertexInputBindingDescription bindingDescription{};
         bindingDescription.binding = 0;
-        bindingDescription.stride = mSpec.vertexInputLayout.getTotalSize();
+        bindingDescription.stride = stride;
         switch (mSpec.vertexInputRate) {
         case Shader::VertexInputRate::VERTEX: {
             bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
             break;
         }
+        case Shader::VertexInputRate::INSTANCE: {
+            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+            break;
+        }
         default: {
             throw std::runtime_error("unrecognized VertexInputRate " + std::to_string((uint32_t)mSpec.vertexInputRate));
             break;
@@ -417,21 +274,18 @@ namespace Car {
         }
 
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
-
-        const std::vector<VertexInputLayout::Element>& elements = mSpec.vertexInputLayout.getElements();
         attributeDescriptions.resize(elements.size());
 
         for (uint32_t i = 0; i < attributeDescriptions.size(); i++) {
             attributeDescriptions[i].binding = 0;
-            // TODO: location might be wrong if ex an element is dvec4
-            attributeDescriptions[i].location = i;
+            attributeDescriptions[i].location = i < inputs.size() ? inputs[i].location : i;
             attributeDescriptions[i].format = BufferLayoutDataTypeToVulkanType(elements[i].type);
             attributeDescriptions[i].offset = elements[i].offset;
         }
 
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = 1;
+        vertexInputInfo.vertexBindingDescriptionCount = attributeDescriptions.empty() ? 0 : 1;
         vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
         vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
         vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
@@ -953,8 +807,8 @@ namespace Car {
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
         pipelineInfo.basePipelineIndex = -1;              // Optional
 
-        if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &mGraphicsPipeline) !=
-            VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(device, mGraphicsContext->getPipelineCache(), 1, &pipelineInfo, nullptr,
+                                      &mGraphicsPipeline) != VK_SUCCESS) {
             throw std::runtime_error("failed to create graphics pipeline!");
         }
 
@@ -962,11 +816,11 @@ namespace Car {
         vkDestroyShaderModule(device, vertShaderModule, nullptr);
     }
 
-    VkShaderModule VulkanShader::createShaderModule(const std::string& code) {
+    VkShaderModule VulkanShader::createShaderModule(const uint32_t* pCode, size_t codeSize) {
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.c_str());
+        createInfo.codeSize = codeSize;
+        createInfo.pCode = pCode;
 
         VkShaderModule shaderModule;
         if (vkCreateShaderModule(mGraphicsContext->getDevice(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
@@ -977,54 +831,37 @@ namespace Car {
     }
 
 #if CR_CAN_COMPILE_SHADER
-    static void fillSetField(SingleCompiledShader* pSCS) {
-        pSCS->sets.resize(0);
-        spirv_cross::Compiler compiler((uint32_t*)pSCS->shader.data(), pSCS->shader.size() / 4);
-        spirv_cross::ShaderResources resources(compiler.get_shader_resources());
-
-        uint32_t maxDescriptorSetCount = 0;
-        for (const auto& uniformBuffer : resources.uniform_buffers) {
-            maxDescriptorSetCount =
-                MAX(compiler.get_decoration(uniformBuffer.id, spv::DecorationDescriptorSet) + 1, maxDescriptorSetCount);
-        }
-        for (const auto& uniformBuffer : resources.sampled_images) {
-            maxDescriptorSetCount =
-                MAX(compiler.get_decoration(uniformBuffer.id, spv::DecorationDescriptorSet) + 1, maxDescriptorSetCount);
-        }
+    // only the spir-v version shaderc targets is exposed, it is the best there is to notice a different compiler
+    static uint64_t crVkShaderCompilerVersion() {
+        unsigned int version = 0;
+        unsigned int revision = 0;
+        shaderc_get_spv_version(&version, &revision);
 
-        if (maxDescriptorSetCount > 4) {
-            throw std::runtime_error("A shader can have max of 4 sets per the vulkan spec");
-        }
-
-        pSCS->sets.resize(maxDescriptorSetCount);
-
-        for (const auto& resource : resources.uniform_buffers) {
-            uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
-            uint8_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
-            pSCS->sets[set].push_back({
-                binding,
-                Car::DescriptorType::UniformBuffer,
-                Car::DescriptorStage::VertexShader,
-            });
-        }
+        return ((uint64_t)version << 32) | revision;
+    }
 
-        for (const auto& resource : resources.sampled_images) {
-            uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
-            uint8_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
-            pSCS->sets[set].push_back({
-                binding,
-                Car::DescriptorType::Sampler2D,
-                Car::DescriptorStage::VertexShader,
-            });
+    static shaderc_shader_kind crVkShaderKind(DescriptorStage stage) {
+        switch (stage) {
+        case DescriptorStage::VertexShader:
+            return shaderc_vertex_shader;
+        case DescriptorStage::FragmeantShader:
+            return shaderc_fragment_shader;
+        case DescriptorStage::ComputeShader:
+            return shaderc_compute_shader;
+        default:
+            throw std::runtime_error("not a single shader stage " + std::to_string((uint32_t)stage));
         }
     }
-    
-    static std::string crVkCompileSingleShader(const std::string& path, const shaderc_shader_kind kind) {
+
+    static std::string crVkCompileSingleShader(const std::string& path, const shaderc_shader_kind kind,
+                                               const std::filesystem::path& includeRoot) {
         std::string sourceCode = Car::readFile(path);
         shaderc::CompileOptions options;
         shaderc::Compiler compiler;
+        // keep CR_SHADER_COMPILE_OPTIONS in sync with these
         options.SetOptimizationLevel(shaderc_optimization_level_performance);
         options.SetSourceLanguage(shaderc_source_language_glsl);
+        options.SetIncluder(std::make_unique<ShaderIncluder>(includeRoot));
     
         options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
     
@@ -1039,50 +876,53 @@ namespace Car {
     }
 #endif
 
-    static CompiledShader combineSingleShaders(SingleCompiledShader* vertShader, SingleCompiledShader* fragShader) {
+    static CompiledShader combineSingleShaders(LoadedShaderStage* pVertStage, LoadedShaderStage* pFragStage) {
+        SingleCompiledShader* vertShader = &pVertStage->shader;
+        SingleCompiledShader* fragShader = &pFragStage->shader;
+
         CompiledShader ret;
-        ret.vertexShader = std::string(vertShader->shader);
-        ret.fragmeantShader = std::string(fragShader->shader);
+        ret.pVertexCode = pVertStage->pCode;
+        ret.vertexCodeSize = pVertStage->codeSize;
+        ret.pFragmeantCode = pFragStage->pCode;
+        ret.fragmeantCodeSize = pFragStage->codeSize;
         ret.sets.resize(MAX(vertShader->sets.size(), fragShader->sets.size()));
 
-        for (uint32_t i = 0; i < vertShader->sets.size(); i++) {
-            std::vector<Descriptor>& set = vertShader->sets[i];
-            for (const Descriptor& descriptor : set) {
-                ret.sets[i].push_back({
-                    descriptor.binding,
-                    descriptor.descriptorType,
-                    DescriptorStage::VertexShader,
-                });
-            }
-        }
+        for (SingleCompiledShader* pShader : {vertShader, fragShader}) {
+            for (uint32_t i = 0; i < pShader->sets.size(); i++) {
+                for (const Descriptor& descriptor : pShader->sets[i]) {
+                    bool shouldPush = true;
 
-        for (uint32_t i = 0; i < fragShader->sets.size(); i++) {
-            std::vector<Descriptor>& set = fragShader->sets[i];
-            for (const Descriptor& descriptor : set) {
-                bool shouldPush = true;
+                    for (auto& otherDescriptor : ret.sets[i]) {
+                        if (descriptor.binding == otherDescriptor.binding) {
+                            shouldPush = false;
 
-                for (auto& otherDescriptor : ret.sets[i]) {
-                    if (descriptor.binding == otherDescriptor.binding) {
-                        shouldPush = false;
+                            if (descriptor.descriptorType != otherDescriptor.descriptorType ||
+                                descriptor.count != otherDescriptor.count) {
+                                throw std::runtime_error("descriptor missmatch");
+                            }
 
-                        if (descriptor.descriptorType != otherDescriptor.descriptorType) {
-                            throw std::runtime_error("descriptor missmatch");
+                            otherDescriptor.stageFlags = otherDescriptor.stageFlags | descriptor.stageFlags;
                         }
+                    }
 
-                        otherDescriptor.stageFlags = DescriptorStage::Combined;
+                    if (shouldPush) {
+                        ret.sets[i].push_back(descriptor);
                     }
                 }
+            }
 
-                if (shouldPush) {
-                    ret.sets[i].push_back({
-                        descriptor.binding,
-                        descriptor.descriptorType,
-                        DescriptorStage::FragmeantShader,
-                    });
-                }
+            if (pShader->pushConstant.size > 0) {
+                ret.pushConstants.push_back(pShader->pushConstant);
             }
         }
 
+        for (auto& set : ret.sets) {
+            std::sort(set.begin(), set.end(),
+                      [](const Descriptor& a, const Descriptor& b) { return a.binding < b.binding; });
+        }
+
+        ret.vertexInputs = vertShader->vertexInputs;
+
         for (const auto& set : ret.sets) {
             if (set.size() == 0) {
                 throw std::runtime_error("can not have an empty set in a shader");
@@ -1092,55 +932,122 @@ namespace Car {
         return ret;
     }
 
-    Ref<Shader> Shader::Create(const std::string& vertexShaderName, const std::string& fragmeantShaderName,
-                               const Shader::Specification* pSpec) {
-        SingleCompiledShader vertCompiledShader;
-        SingleCompiledShader fragCompiledShader;
+    // mapped once per shaders folder and kept for the lifetime of the program
+    static const VulkanShaderBundle* getShaderBundle(const std::filesystem::path& shadersPath) {
+        static std::unordered_map<std::string, Scope<VulkanShaderBundle>> sBundles;
+        // shaders can be created from worker threads, the bundles themselves are read only once mapped
+        static std::mutex sBundlesMutex;
+        std::lock_guard<std::mutex> lock(sBundlesMutex);
 
-        std::filesystem::path shadersPath =
-            (std::filesystem::path)ResourceManager::getResourceDirectory() / ResourceManager::getShadersSubdirectory();
-        std::filesystem::path cacheShaderDir = shadersPath / "__CACHE__";
+        Scope<VulkanShaderBundle>& bundle = sBundles[shadersPath.string()];
+        if (bundle == nullptr) {
+            bundle = createScope<VulkanShaderBundle>(shadersPath / "__CACHE__" / "shaders.crsb");
+        }
 
-        std::string vertPath = shadersPath / vertexShaderName;
-        std::string fragPath = shadersPath / fragmeantShaderName;
-        std::filesystem::path vertCacheFile = std::string(cacheShaderDir / vertexShaderName) + ".crss";
-        std::filesystem::path fragCacheFile = std::string(cacheShaderDir / fragmeantShaderName) + ".crss";
+        return bundle->isValid() ? bundle.get() : nullptr;
+    }
 
-        if (!std::filesystem::exists(vertCacheFile)) {
+    static bool isCompiledShaderUpToDate(bool haveSource, uint64_t sourceHash, uint64_t compiledSourceHash,
+                                         uint64_t compiledCompilerVersion) {
+        bool upToDate = !haveSource || compiledSourceHash == sourceHash;
 #if CR_CAN_COMPILE_SHADER
-            std::filesystem::create_directories(vertCacheFile.parent_path());
-            CR_CORE_DEBUG("compiling vertex shader {}", vertPath);
-            vertCompiledShader.shader = crVkCompileSingleShader(vertPath, shaderc_vertex_shader);
-            fillSetField(&vertCompiledShader);
-
-            writeToFile(vertCacheFile, vertCompiledShader.toBytes());
+        upToDate = upToDate && compiledCompilerVersion == crVkShaderCompilerVersion();
 #else
-            CR_CORE_ERROR("Can not online compile shaders without shaderc and spirv-cross");
+        UNUSED(compiledCompilerVersion);
 #endif // CR_CAN_COMPILE_SHADER
-        } else {
-            CR_CORE_DEBUG("Loading pre-processed vertex shader from {}", (std::string)vertCacheFile);
-            std::string data = readFile(vertCacheFile);
-            vertCompiledShader = SingleCompiledShader::fromBytes({data.begin(), data.end()});
+        return upToDate;
+    }
+
+    void loadShaderStage(const std::filesystem::path& shadersPath, const std::string& name, DescriptorStage stage,
+                         LoadedShaderStage* pStage) {
+        const std::filesystem::path sourcePath = shadersPath / name;
+        const std::filesystem::path cacheFile = std::string(shadersPath / "__CACHE__" / name) + ".crss";
+        const std::string stageName = DescriptorStageExtension(stage);
+
+        const bool haveSource = std::filesystem::exists(sourcePath);
+        // shipped builds can come with the cache only
+        const uint64_t sourceHash = haveSource ? computeShaderSourceHash(sourcePath, shadersPath, stageName) : 0;
+
+        if (const VulkanShaderBundle* pBundle = getShaderBundle(shadersPath)) {
+            const CompiledShaderBundleEntry* pEntry =
+                pBundle->find(std::filesystem::path(name).lexically_normal().generic_string(), stage);
+            if (pEntry != nullptr &&
+                isCompiledShaderUpToDate(haveSource, sourceHash, pEntry->sourceHash, pEntry->compilerVersion)) {
+                if (pBundle->readReflection(*pEntry, &pStage->shader)) {
+                    pStage->pCode = pBundle->getCode(*pEntry);
+                    pStage->codeSize = pEntry->codeSize;
+                    return;
+                }
+
+                CR_CORE_WARN("the shader bundle entry of {} is corrupt, ignoring it", name);
+                pStage->shader = SingleCompiledShader{};
+            }
         }
 
-        if (!std::filesystem::exists(fragCacheFile)) {
-#if CR_CAN_COMPILE_SHADER
-            std::filesystem::create_directories(fragCacheFile.parent_path());
-            CR_CORE_DEBUG("compiling fragmeant shader {}", fragPath);
-            fragCompiledShader.shader = crVkCompileSingleShader(fragPath, shaderc_fragment_shader);
-            fillSetField(&fragCompiledShader);
+        std::vector<uint8_t> cached;
+        CompiledShaderHeader header;
+        bool upToDate = false;
+        if (std::filesystem::exists(cacheFile)) {
+            std::ifstream file(cacheFile, std::ios::binary);
+            cached.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+            upToDate = SingleCompiledShader::readHeader(cached, &header) &&
+                       isCompiledShaderUpToDate(haveSource, sourceHash, header.sourceHash, header.compilerVersion);
+        }
+
+        if (upToDate) {
+            CR_CORE_DEBUG("Loading pre-processed {} shader from {}", stageName, cacheFile.string());
+            // an interrupted write leaves the header intact, such a file is compiled again like an outdated one
+            try {
+                pStage->shader = SingleCompiledShader::fromBytes(cached);
+            } catch (const std::runtime_error& e) {
+                CR_CORE_WARN("{}: {}, ignoring it", cacheFile.string(), e.what());
+                UNUSED(e);
+                pStage->shader = SingleCompiledShader{};
+                upToDate = false;
+            }
+        }
 
-            writeToFile(fragCacheFile, fragCompiledShader.toBytes());
+        if (!upToDate) {
+#if CR_CAN_COMPILE_SHADER
+            SingleCompiledShader& compiledShader = pStage->shader;
+            std::filesystem::create_directories(cacheFile.parent_path());
+            CR_CORE_DEBUG("compiling {} shader {}", stageName, sourcePath.string());
+            compiledShader.shader = crVkCompileSingleShader(sourcePath, crVkShaderKind(stage), shadersPath);
+            ShaderReflection::reflect(&compiledShader, stage);
+            compiledShader.header.sourceHash = sourceHash;
+            compiledShader.header.compilerVersion = crVkShaderCompilerVersion();
+
+            writeToFile(cacheFile, compiledShader.toBytes());
 #else
-            CR_CORE_ERROR("Can not online compile shaders without shaderc and spirv-cross");
+            if (cached.empty() || !SingleCompiledShader::readHeader(cached, &header)) {
+                CR_CORE_ERROR("Can not online compile shaders without shaderc and spirv-cross");
+                throw std::runtime_error("no usable compiled shader for " + sourcePath.string());
+            }
+
+            CR_CORE_WARN("{} is out of date with {} but shaders can not be compiled without shaderc and spirv-cross, "
+                         "using it anyway",
+                         cacheFile.string(), sourcePath.string());
+            pStage->shader = SingleCompiledShader::fromBytes(cached);
 #endif // CR_CAN_COMPILE_SHADER
-        } else {
-            CR_CORE_DEBUG("Loading pre-processed fragmeant shader from {}", (std::string)fragCacheFile);
-            std::string data = readFile(fragCacheFile);
-            fragCompiledShader = SingleCompiledShader::fromBytes({data.begin(), data.end()});
         }
 
-        CompiledShader compiledShader = combineSingleShaders(&vertCompiledShader, &fragCompiledShader);
+        pStage->pCode = reinterpret_cast<const uint32_t*>(pStage->shader.shader.data());
+        pStage->codeSize = pStage->shader.shader.size();
+    }
+
+    Ref<Shader> Shader::Create(const std::string& vertexShaderName, const std::string& fragmeantShaderName,
+                               const Shader::Specification* pSpec) {
+        std::filesystem::path shadersPath =
+            (std::filesystem::path)ResourceManager::getResourceDirectory() / ResourceManager::getShadersSubdirectory();
+
+        LoadedShaderStage vertStage;
+        LoadedShaderStage fragStage;
+        loadShaderStage(shadersPath, vertexShaderName, DescriptorStage::VertexShader, &vertStage);
+        loadShaderStage(shadersPath, fragmeantShaderName, DescriptorStage::FragmeantShader, &fragStage);
+
+        // the stages stay alive until the shader modules are created
+        CompiledShader compiledShader = combineSingleShaders(&vertStage, &fragStage);
 
         return createRef<VulkanShader>(compiledShader, pSpec);
     }
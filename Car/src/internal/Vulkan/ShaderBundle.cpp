@@ -0,0 +1,155 @@
+#include "Car/internal/Vulkan/ShaderBundle.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace Car {
+    VulkanShaderBundle::VulkanShaderBundle(const std::filesystem::path& path) {
+#ifdef _WIN32
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        mFile = file;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            unmap();
+            return;
+        }
+        mSize = (size_t)size.QuadPart;
+
+        mMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mMapping == nullptr) {
+            unmap();
+            return;
+        }
+
+        mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+        if (mData == nullptr) {
+            unmap();
+            return;
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return;
+        }
+        mSize = (size_t)st.st_size;
+
+        void* pData = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping keeps the file alive
+        close(fd);
+        if (pData == MAP_FAILED) {
+            mSize = 0;
+            return;
+        }
+        mData = static_cast<const uint8_t*>(pData);
+#endif // _WIN32
+
+        if (!validate()) {
+            CR_CORE_WARN("{} is not a valid shader bundle, ignoring it", path.string());
+            unmap();
+            return;
+        }
+
+        mEntryCount = reinterpret_cast<const CompiledShaderBundleHeader*>(mData)->entryCount;
+        mEntries = reinterpret_cast<const CompiledShaderBundleEntry*>(mData + sizeof(CompiledShaderBundleHeader));
+
+        CR_CORE_DEBUG("Mapped shader bundle {} with {} shaders", path.string(), mEntryCount);
+    }
+
+    VulkanShaderBundle::~VulkanShaderBundle() { unmap(); }
+
+    void VulkanShaderBundle::unmap() {
+#ifdef _WIN32
+        if (mData != nullptr) {
+            UnmapViewOfFile(mData);
+        }
+        if (mMapping != nullptr) {
+            CloseHandle(mMapping);
+        }
+        if (mFile != nullptr) {
+            CloseHandle(mFile);
+        }
+        mFile = nullptr;
+        mMapping = nullptr;
+#else
+        if (mData != nullptr) {
+            munmap(const_cast<uint8_t*>(mData), mSize);
+        }
+#endif // _WIN32
+
+        mData = nullptr;
+        mSize = 0;
+        mEntries = nullptr;
+        mEntryCount = 0;
+    }
+
+    // every offset is checked once here so the lookups do not have to
+    bool VulkanShaderBundle::validate() const {
+        if (mSize < sizeof(CompiledShaderBundleHeader)) {
+            return false;
+        }
+
+        CompiledShaderBundleHeader header;
+        std::memcpy(&header, mData, sizeof(header));
+        if (header.magic != CR_CRSB_MAGIC || header.version != CR_CRSB_VERSION) {
+            return false;
+        }
+
+        const uint64_t tableEnd =
+            sizeof(CompiledShaderBundleHeader) + (uint64_t)header.entryCount * sizeof(CompiledShaderBundleEntry);
+        if (tableEnd > mSize) {
+            return false;
+        }
+
+        const CompiledShaderBundleEntry* entries =
+            reinterpret_cast<const CompiledShaderBundleEntry*>(mData + sizeof(CompiledShaderBundleHeader));
+        for (uint32_t i = 0; i < header.entryCount; i++) {
+            const CompiledShaderBundleEntry& entry = entries[i];
+            if ((uint64_t)entry.nameOffset + entry.nameSize > mSize ||
+                (uint64_t)entry.reflectionOffset + entry.reflectionSize > mSize ||
+                (uint64_t)entry.codeOffset + entry.codeSize > mSize || entry.codeOffset % 4 != 0 ||
+                entry.codeSize % 4 != 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    const CompiledShaderBundleEntry* VulkanShaderBundle::find(const std::string& name, DescriptorStage stage) const {
+        auto getName = [this](const CompiledShaderBundleEntry& entry) {
+            return std::string_view(reinterpret_cast<const char*>(mData + entry.nameOffset), entry.nameSize);
+        };
+
+        // the entries are sorted by name then stage
+        const CompiledShaderBundleEntry* end = mEntries + mEntryCount;
+        const CompiledShaderBundleEntry* it =
+            std::lower_bound(mEntries, end, std::make_pair(std::string_view(name), (uint32_t)stage),
+                             [&](const CompiledShaderBundleEntry& entry, const auto& key) {
+                                 std::string_view entryName = getName(entry);
+                                 return entryName != key.first ? entryName < key.first : entry.stage < key.second;
+                             });
+
+        if (it == end || getName(*it) != name || it->stage != (uint32_t)stage) {
+            return nullptr;
+        }
+        return it;
+    }
+} // namespace Car
@@ -0,0 +1,337 @@
+#include "Car/internal/Vulkan/ShaderDescriptors.hpp"
+#include "Car/Core/Log.hpp"
+#include "Car/Core/Ref.hpp"
+#include "Car/internal/Vulkan/GraphicsContext.hpp"
+#include "Car/internal/Vulkan/SSBO.hpp"
+#include "Car/internal/Vulkan/Texture2D.hpp"
+#include "Car/internal/Vulkan/UniformBuffer.hpp"
+
+#include <glad/vulkan.h>
+#include <stdexcept>
+
+namespace Car {
+    VulkanShaderDescriptors::VulkanShaderDescriptors(VulkanGraphicsContext* pGraphicsContext,
+                                                     const std::vector<std::vector<Descriptor>>& sets)
+        : mGraphicsContext(pGraphicsContext), mSets(sets) {
+        VkDevice device = mGraphicsContext->getDevice();
+        const uint32_t maxFramesInFlight = mGraphicsContext->getMaxFramesInFlight();
+
+        mDescriptorSetLayouts.resize(mSets.size());
+        mSetCaches.resize(mSets.size());
+        mDescriptorSets.resize(maxFramesInFlight);
+        mPendingResources.resize(maxFramesInFlight);
+        // every set starts out dirty so it gets a descriptor set even if nothing is ever bound to it
+        mDirtySets.assign(maxFramesInFlight, (uint32_t)BIT(mSets.size()) - 1);
+        for (uint32_t i = 0; i < maxFramesInFlight; i++) {
+            mDescriptorSets[i].resize(mSets.size());
+            mPendingResources[i].resize(mSets.size());
+        }
+
+        for (uint32_t i = 0; i < mSets.size(); i++) {
+            // the bindless texture table is shared so the set from the graphics context is used as is
+            bool isBindlessSet = false;
+            for (const Descriptor& descriptor : mSets[i]) {
+                isBindlessSet |= descriptor.descriptorType == Car::DescriptorType::BindlessSampler2D;
+            }
+            if (isBindlessSet) {
+                if (mSets[i].size() != 1 || mSets[i][0].binding != 0) {
+                    throw std::runtime_error("a bindless texture array must be the only descriptor of its set and "
+                                             "use binding 0");
+                }
+
+                mDescriptorSetLayouts[i] = mGraphicsContext->getBindlessTextureSetLayout();
+                for (uint32_t k = 0; k < maxFramesInFlight; k++) {
+                    mDescriptorSets[k][i] = mGraphicsContext->getBindlessTextureSet();
+                }
+                continue;
+            }
+
+            std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayouts;
+            for (const Descriptor& descriptor : mSets[i]) {
+                VkDescriptorSetLayoutBinding layoutBinding{};
+                layoutBinding.binding = descriptor.binding;
+                layoutBinding.descriptorType = DescriptorTypeToVulkanType(descriptor.descriptorType);
+                layoutBinding.descriptorCount = descriptor.count;
+                layoutBinding.stageFlags = DescriptorStageToVulkanStage(descriptor.stageFlags);
+                layoutBinding.pImmutableSamplers = nullptr;
+
+                descriptorSetLayouts.push_back(layoutBinding);
+            }
+
+            VkDescriptorSetLayoutCreateInfo layoutInfo{};
+            layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            layoutInfo.bindingCount = descriptorSetLayouts.size();
+            layoutInfo.pBindings = descriptorSetLayouts.data();
+
+            if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &mDescriptorSetLayouts[i]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create descriptor set layout!");
+            }
+
+            // the sets themselves are allocated by the cache the first time the shader is bound
+            for (uint32_t k = 0; k < maxFramesInFlight; k++) {
+                mPendingResources[k][i].resize(mSets[i].size());
+            }
+        }
+    }
+
+    // the gpu must be done with the sets
+    VulkanShaderDescriptors::~VulkanShaderDescriptors() {
+        for (const VkDescriptorSetLayout& descriptorSetLayout : mDescriptorSetLayouts) {
+            // owned by the graphics context
+            if (descriptorSetLayout == mGraphicsContext->getBindlessTextureSetLayout()) {
+                continue;
+            }
+            vkDestroyDescriptorSetLayout(mGraphicsContext->getDevice(), descriptorSetLayout, nullptr);
+        }
+
+        for (SetCache& cache : mSetCaches) {
+            for (CachedSet& entry : cache.entries) {
+                mGraphicsContext->getDescriptorAllocator().free(&entry.set);
+            }
+        }
+    }
+
+    const std::vector<VkDescriptorSet>& VulkanShaderDescriptors::getDescriptorSets(uint32_t frame) {
+        if (mDirtySets[frame] != 0) {
+            flushDescriptorWrites(frame);
+        }
+        return mDescriptorSets[frame];
+    }
+
+    bool VulkanShaderDescriptors::validateInput(uint32_t set, uint32_t binding, DescriptorType type,
+                                                const char* typeName) const {
+        UNUSED(typeName);
+        UNUSED(type);
+        const Descriptor* pDescriptor = findDescriptor(set, binding);
+        UNUSED(pDescriptor);
+        CR_IF (pDescriptor == nullptr) {
+            CR_CORE_ERROR("set {0} binding {1} does not exist", set, binding);
+            CR_DEBUGBREAK();
+            return false;
+        }
+        CR_IF (pDescriptor->descriptorType != type) {
+            CR_CORE_ERROR("set {0} binding {1} is not a {2}", set, binding, typeName);
+            CR_DEBUGBREAK();
+            return false;
+        }
+        return true;
+    }
+
+    void VulkanShaderDescriptors::setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<UniformBuffer> ub) {
+        if (!validateInput(set, binding, DescriptorType::UniformBuffer, "uniformbuffer")) {
+            return;
+        }
+
+        Ref<VulkanUniformBuffer> vulkanUb = reinterpretCastRef<VulkanUniformBuffer>(ub);
+        const uint32_t currentFrame = mGraphicsContext->getCurrentFrameIndex();
+        for (uint32_t i = 0; i < mGraphicsContext->getMaxFramesInFlight(); i++) {
+            if (!applyToAll && i != currentFrame) {
+                continue;
+            }
+
+            // every frame has its own copy of the buffer
+            BoundResource* pResource = getPendingResource(i, set, binding);
+            pResource->bufferInfo = vulkanUb->getDescriptorBufferInfo(i);
+            pResource->owner = ub;
+            pResource->isSet = true;
+        }
+    }
+
+    void VulkanShaderDescriptors::setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<Texture2D> texture) {
+        if (!validateInput(set, binding, DescriptorType::Sampler2D, "sampler2D")) {
+            return;
+        }
+
+        VkDescriptorImageInfo imageInfo = reinterpretCastRef<VulkanTexture2D>(texture)->getDescriptorImageInfo();
+        const uint32_t currentFrame = mGraphicsContext->getCurrentFrameIndex();
+        for (uint32_t i = 0; i < mGraphicsContext->getMaxFramesInFlight(); i++) {
+            if (!applyToAll && i != currentFrame) {
+                continue;
+            }
+
+            BoundResource* pResource = getPendingResource(i, set, binding);
+            pResource->imageInfo = imageInfo;
+            pResource->owner = texture;
+            pResource->isSet = true;
+        }
+    }
+
+    void VulkanShaderDescriptors::setInput(uint32_t set, uint32_t binding, bool applyToAll, Ref<SSBO> ssbo) {
+        if (!validateInput(set, binding, DescriptorType::StorageBuffer, "storage buffer")) {
+            return;
+        }
+
+        Ref<VulkanSSBO> vulkanSSBO = reinterpretCastRef<VulkanSSBO>(ssbo);
+        const uint32_t currentFrame = mGraphicsContext->getCurrentFrameIndex();
+        for (uint32_t i = 0; i < mGraphicsContext->getMaxFramesInFlight(); i++) {
+            if (!applyToAll && i != currentFrame) {
+                continue;
+            }
+
+            BoundResource* pResource = getPendingResource(i, set, binding);
+            pResource->bufferInfo = vulkanSSBO->getDescriptorBufferInfo(i);
+            pResource->owner = ssbo;
+            pResource->isSet = true;
+        }
+    }
+
+    const Descriptor* VulkanShaderDescriptors::findDescriptor(uint32_t set, uint32_t binding) const {
+        if (set >= mSets.size()) {
+            return nullptr;
+        }
+
+        // sorted by binding
+        const std::vector<Descriptor>& descriptors = mSets[set];
+        auto it = std::lower_bound(descriptors.begin(), descriptors.end(), binding,
+                                   [](const Descriptor& descriptor, uint32_t b) { return descriptor.binding < b; });
+
+        return it != descriptors.end() && it->binding == binding ? &*it : nullptr;
+    }
+
+    bool VulkanShaderDescriptors::BoundResource::operator==(const BoundResource& other) const {
+        return bufferInfo.buffer == other.bufferInfo.buffer && bufferInfo.offset == other.bufferInfo.offset &&
+               bufferInfo.range == other.bufferInfo.range && imageInfo.imageView == other.imageInfo.imageView &&
+               imageInfo.sampler == other.imageInfo.sampler && imageInfo.imageLayout == other.imageInfo.imageLayout &&
+               isSet == other.isSet && !owner.owner_before(other.owner) && !other.owner.owner_before(owner);
+    }
+
+    static uint64_t hashSetResources(const std::vector<uint64_t>& words) {
+        uint64_t hash = 14695981039346656037ull;
+        for (uint64_t word : words) {
+            hash ^= word;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    VulkanShaderDescriptors::BoundResource* VulkanShaderDescriptors::getPendingResource(uint32_t frame, uint32_t set,
+                                                                                        uint32_t binding) {
+        const Descriptor* pDescriptor = findDescriptor(set, binding);
+        mDirtySets[frame] |= BIT(set);
+        return &mPendingResources[frame][set][pDescriptor - mSets[set].data()];
+    }
+
+    uint32_t VulkanShaderDescriptors::acquireCachedSet(uint32_t set, uint64_t hash, const SetResources& resources,
+                                                       bool* pNeedsWrite) {
+        SetCache& cache = mSetCaches[set];
+        const uint64_t frameCount = mGraphicsContext->getFrameCount();
+
+        auto it = cache.lookup.find(hash);
+        if (it != cache.lookup.end()) {
+            CachedSet& entry = cache.entries[it->second];
+            bool stale = false;
+            for (const BoundResource& resource : entry.resources) {
+                stale |= resource.isSet && resource.owner.expired();
+            }
+            if (!stale && entry.resources == resources) {
+                *pNeedsWrite = false;
+                return it->second;
+            }
+        }
+
+        *pNeedsWrite = true;
+
+        // a set can be rewritten once no frame has it bound and every frame that used it is done
+        uint32_t victim = UINT32_MAX;
+        if (cache.entries.size() >= CR_VULKAN_DESCRIPTOR_SET_CACHE_SIZE) {
+            for (uint32_t i = 0; i < cache.entries.size(); i++) {
+                const CachedSet& entry = cache.entries[i];
+                bool inUse = entry.lastUsedFrame + mGraphicsContext->getMaxFramesInFlight() > frameCount;
+                for (const std::vector<VkDescriptorSet>& frameSets : mDescriptorSets) {
+                    inUse |= frameSets[set] == entry.set.set;
+                }
+                if (!inUse && (victim == UINT32_MAX || entry.lastUsedFrame < cache.entries[victim].lastUsedFrame)) {
+                    victim = i;
+                }
+            }
+        }
+
+        if (victim == UINT32_MAX) {
+            victim = cache.entries.size();
+            cache.entries.push_back({mGraphicsContext->getDescriptorAllocator().allocate(mDescriptorSetLayouts[set]),
+                                     {}, 0, 0});
+        } else {
+            auto old = cache.lookup.find(cache.entries[victim].hash);
+            if (old != cache.lookup.end() && old->second == victim) {
+                cache.lookup.erase(old);
+            }
+        }
+
+        CachedSet& entry = cache.entries[victim];
+        entry.resources = resources;
+        entry.hash = hash;
+        cache.lookup[hash] = victim;
+
+        return victim;
+    }
+
+    void VulkanShaderDescriptors::flushDescriptorWrites(uint32_t frame) {
+        const uint64_t frameCount = mGraphicsContext->getFrameCount();
+
+        std::vector<VkWriteDescriptorSet> descriptorWrites;
+        std::vector<uint64_t> words;
+        for (uint32_t i = 0; i < mSets.size(); i++) {
+            const bool isBindlessSet = mDescriptorSetLayouts[i] == mGraphicsContext->getBindlessTextureSetLayout();
+            if ((mDirtySets[frame] & BIT(i)) == 0 || isBindlessSet) {
+                continue;
+            }
+
+            const SetResources& resources = mPendingResources[frame][i];
+            words.clear();
+            for (const BoundResource& resource : resources) {
+                words.push_back((uint64_t)resource.bufferInfo.buffer);
+                words.push_back(resource.bufferInfo.offset);
+                words.push_back(resource.bufferInfo.range);
+                words.push_back((uint64_t)resource.imageInfo.imageView);
+                words.push_back((uint64_t)resource.imageInfo.sampler);
+            }
+
+            // the set that is replaced can still be in use by the frames in flight
+            for (CachedSet& entry : mSetCaches[i].entries) {
+                if (entry.set.set == mDescriptorSets[frame][i]) {
+                    entry.lastUsedFrame = frameCount;
+                }
+            }
+
+            bool needsWrite;
+            uint32_t index = acquireCachedSet(i, hashSetResources(words), resources, &needsWrite);
+            CachedSet& entry = mSetCaches[i].entries[index];
+            entry.lastUsedFrame = frameCount;
+            mDescriptorSets[frame][i] = entry.set.set;
+
+            if (!needsWrite) {
+                continue;
+            }
+
+            for (uint32_t j = 0; j < entry.resources.size(); j++) {
+                const Descriptor& descriptor = mSets[i][j];
+                const BoundResource& resource = entry.resources[j];
+                // never set (or already destroyed), it is fine as long as the shader does not read it
+                if (resource.owner.expired()) {
+                    continue;
+                }
+
+                VkWriteDescriptorSet descriptorWrite{};
+                descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                descriptorWrite.dstSet = entry.set.set;
+                descriptorWrite.dstBinding = descriptor.binding;
+                descriptorWrite.dstArrayElement = 0;
+                descriptorWrite.descriptorType = DescriptorTypeToVulkanType(descriptor.descriptorType);
+                descriptorWrite.descriptorCount = 1;
+                if (resource.bufferInfo.buffer != VK_NULL_HANDLE) {
+                    descriptorWrite.pBufferInfo = &resource.bufferInfo;
+                } else {
+                    descriptorWrite.pImageInfo = &resource.imageInfo;
+                }
+
+                descriptorWrites.push_back(descriptorWrite);
+            }
+        }
+        mDirtySets[frame] = 0;
+
+        if (!descriptorWrites.empty()) {
+            vkUpdateDescriptorSets(mGraphicsContext->getDevice(), descriptorWrites.size(), descriptorWrites.data(), 0,
+                                   nullptr);
+        }
+    }
+} // namespace Car
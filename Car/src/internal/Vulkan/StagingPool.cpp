@@ -0,0 +1,105 @@
+#include "Car/internal/Vulkan/StagingPool.hpp"
+#include "Car/internal/Vulkan/GraphicsContext.hpp"
+
+namespace Car {
+    static uint32_t bucketOf(VkDeviceSize size) {
+        uint32_t bucket = 0;
+        while ((CR_VULKAN_STAGING_MIN_SIZE << bucket) < size) {
+            bucket++;
+        }
+        return bucket;
+    }
+
+    VulkanStagingPool::VulkanStagingPool(VulkanGraphicsContext* pGraphicsContext) {
+        mGraphicsContext = pGraphicsContext;
+    }
+
+    VulkanStagingPool::~VulkanStagingPool() {
+        trim();
+
+        CR_IF (mBufferCount != 0) {
+            CR_CORE_ERROR("Car::VulkanStagingPool::~VulkanStagingPool, {0} staging buffers were never released",
+                          mBufferCount);
+        }
+    }
+
+    VulkanStagingBuffer VulkanStagingPool::acquire(VkDeviceSize size) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        const uint32_t bucket = bucketOf(size);
+        if (bucket < mFreeBuffers.size() && !mFreeBuffers[bucket].empty()) {
+            VulkanStagingBuffer buffer = mFreeBuffers[bucket].back();
+            mFreeBuffers[bucket].pop_back();
+            mFreeBytes -= buffer.size;
+            mReuseCount++;
+            return buffer;
+        }
+
+        VulkanStagingBuffer buffer{};
+        buffer.size = CR_VULKAN_STAGING_MIN_SIZE << bucket;
+        buffer.bucket = bucket;
+        mGraphicsContext->createBuffer(buffer.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                       &buffer.buffer, &buffer.allocation);
+        mBufferCount++;
+        mCreateCount++;
+
+        return buffer;
+    }
+
+    void VulkanStagingPool::release(VulkanStagingBuffer* pBuffer) {
+        if (pBuffer->buffer == VK_NULL_HANDLE) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // one huge texture should not keep its staging memory forever
+        if (mFreeBytes + pBuffer->size > CR_VULKAN_STAGING_POOL_BUDGET) {
+            destroy(pBuffer);
+            return;
+        }
+
+        if (pBuffer->bucket >= mFreeBuffers.size()) {
+            mFreeBuffers.resize(pBuffer->bucket + 1);
+        }
+        mFreeBuffers[pBuffer->bucket].push_back(*pBuffer);
+        mFreeBytes += pBuffer->size;
+
+        *pBuffer = VulkanStagingBuffer{};
+    }
+
+    void VulkanStagingPool::destroy(VulkanStagingBuffer* pBuffer) {
+        mGraphicsContext->freeBuffer(&pBuffer->buffer, &pBuffer->allocation);
+        mBufferCount--;
+
+        *pBuffer = VulkanStagingBuffer{};
+    }
+
+    void VulkanStagingPool::trim() {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        for (std::vector<VulkanStagingBuffer>& buffers : mFreeBuffers) {
+            for (VulkanStagingBuffer& buffer : buffers) {
+                destroy(&buffer);
+            }
+            buffers.clear();
+        }
+        mFreeBytes = 0;
+    }
+
+    VulkanStagingPool::Stats VulkanStagingPool::getStats() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        Stats stats{};
+        stats.bufferCount = mBufferCount;
+        stats.freeBytes = mFreeBytes;
+        stats.reuseCount = mReuseCount;
+        stats.createCount = mCreateCount;
+        for (const std::vector<VulkanStagingBuffer>& buffers : mFreeBuffers) {
+            stats.freeBufferCount += (uint32_t)buffers.size();
+        }
+
+        return stats;
+    }
+} // namespace Car
@@ -16,12 +16,14 @@ namespace Car {
         createTextureImage2D(pBuffer);
         createImageView();
         createImageSampler();
+
+        mBindlessIndex = mGraphicsContext->registerBindlessTexture(getDescriptorImageInfo());
     }
 
     VulkanTexture2D::VulkanTexture2D(const std::string& filepath, bool flipped) {
         mGraphicsContext = reinterpretCastRef<VulkanGraphicsContext>(GraphicsContext::Get());
 
-        stbi_set_flip_vertically_on_load(flipped);
+        stbi_set_flip_vertically_on_load_thread(flipped);
 
         int texWidth, texHeight;
         void* pixels = stbi_load(filepath.c_str(), &texWidth, &texHeight, nullptr, STBI_rgb_alpha);
@@ -38,36 +40,19 @@ namespace Car {
         createImageSampler();
 
         stbi_image_free(pixels);
+
+        mBindlessIndex = mGraphicsContext->registerBindlessTexture(getDescriptorImageInfo());
     }
 
     void VulkanTexture2D::createTextureImage2D(void* pBuffer) {
-        VkDeviceSize imageSize = mWidth * mHeight * 4;
-        VkDevice device = mGraphicsContext->getDevice();
-
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        mGraphicsContext->createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                       &stagingBuffer, &stagingBufferMemory);
-
-        void* mappedData;
-        vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &mappedData);
-        std::memcpy(mappedData, pBuffer, imageSize);
-        vkUnmapMemory(device, stagingBufferMemory);
-
         mGraphicsContext->createImage2D(mWidth, mHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
                                         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mImage, &mImageMemory);
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mImage, &mImageAllocation);
 
-        mGraphicsContext->transitionImageLayout(&mImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED,
-                                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        mGraphicsContext->copyBufferToImage2D(&stagingBuffer, &mImage, mWidth, mHeight);
+        // the pixels are copied into a staging buffer right away, the copy itself runs on the transfer queue and the
+        // frame that first draws the texture waits for it
         // TODO: this is for samplers only
-        mGraphicsContext->transitionImageLayout(&mImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-        vkDestroyBuffer(device, stagingBuffer, nullptr);
-        vkFreeMemory(device, stagingBufferMemory, nullptr);
+        mUploadValue = mGraphicsContext->getUploadQueue().uploadImage2D(mImage, pBuffer, mWidth, mHeight);
     }
 
     void VulkanTexture2D::createImageView() {
@@ -99,11 +84,12 @@ namespace Car {
     VulkanTexture2D::~VulkanTexture2D() {
         VkDevice device = mGraphicsContext->getDevice();
 
-        vkDeviceWaitIdle(device);
+        mGraphicsContext->getUploadQueue().wait(mUploadValue);
+        mGraphicsContext->waitIdle();
+        mGraphicsContext->releaseBindlessTexture(mBindlessIndex);
         vkDestroySampler(device, mSampler, nullptr);
         vkDestroyImageView(device, mImageView, nullptr);
-        vkDestroyImage(device, mImage, nullptr);
-        vkFreeMemory(device, mImageMemory, nullptr);
+        mGraphicsContext->freeImage2D(&mImage, &mImageAllocation);
     }
 
     void VulkanTexture2D::updateData(const std::string& filepath, bool flipped) {
@@ -111,6 +97,25 @@ namespace Car {
         UNUSED(flipped);
     }
 
+    void VulkanTexture2D::updateRegion(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* pBuffer) {
+        CR_IF (x + width > mWidth || y + height > mHeight) {
+            CR_CORE_ERROR("Car::VulkanTexture2D::updateRegion, region ({0}, {1}, {2}, {3}) is outside of the texture "
+                          "({4}, {5})",
+                          x, y, width, height, mWidth, mHeight);
+            CR_DEBUGBREAK();
+            return;
+        }
+
+        // no wait here, the copy is ordered after the frames that still sample the texture and the next frame waits
+        // for it like for any other upload
+        mUploadValue = mGraphicsContext->getUploadQueue().uploadImage2DRegion(mImage, pBuffer, x, y, width, height,
+                                                                              mUploadValue);
+    }
+
+    bool VulkanTexture2D::isReady() const { return mGraphicsContext->getUploadQueue().isComplete(mUploadValue); }
+
+    void VulkanTexture2D::wait() const { mGraphicsContext->getUploadQueue().wait(mUploadValue); }
+
     Ref<Texture2D> Texture2D::Create(const std::string& filepath, bool flipped) {
         return createRef<VulkanTexture2D>(filepath, flipped);
     }
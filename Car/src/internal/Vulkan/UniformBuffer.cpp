@@ -13,25 +13,18 @@ namespace Car {
         mGraphicsContext = reinterpretCastRef<VulkanGraphicsContext>(GraphicsContext::Get());
 
         mBuffers.resize(mGraphicsContext->getMaxFramesInFlight());
-        mBuffersMemory.resize(mGraphicsContext->getMaxFramesInFlight());
-        mBuffersMapped.resize(mGraphicsContext->getMaxFramesInFlight());
-
-        VkDevice device = mGraphicsContext->getDevice();
+        mAllocations.resize(mGraphicsContext->getMaxFramesInFlight());
 
         for (size_t i = 0; i < mGraphicsContext->getMaxFramesInFlight(); i++) {
             mGraphicsContext->createBuffer(mSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                           &mBuffers[i], &mBuffersMemory[i]);
-
-            vkMapMemory(device, mBuffersMemory[i], 0, mSize, 0, &mBuffersMapped[i]);
+                                           &mBuffers[i], &mAllocations[i]);
         }
     }
 
     VulkanUniformBuffer::~VulkanUniformBuffer() {
-        VkDevice device = mGraphicsContext->getDevice();
         for (size_t i = 0; i < mGraphicsContext->getMaxFramesInFlight(); i++) {
-            vkDestroyBuffer(device, mBuffers[i], nullptr);
-            vkFreeMemory(device, mBuffersMemory[i], nullptr);
+            mGraphicsContext->freeBuffer(&mBuffers[i], &mAllocations[i]);
         }
     }
 
@@ -45,7 +38,7 @@ namespace Car {
     }
 
     void VulkanUniformBuffer::setData(const void* data) {
-        std::memcpy(mBuffersMapped[mGraphicsContext->getCurrentFrameIndex()], data, mSize);
+        std::memcpy(mAllocations[mGraphicsContext->getCurrentFrameIndex()].mapped, data, mSize);
     }
 
     Ref<Car::UniformBuffer> UniformBuffer::Create(uint64_t size, Buffer::Usage usage) {
@@ -0,0 +1,420 @@
+#include "Car/internal/Vulkan/UploadQueue.hpp"
+#include "Car/internal/Vulkan/GraphicsContext.hpp"
+
+namespace Car {
+    VulkanUploadQueue::VulkanUploadQueue(VulkanGraphicsContext* pGraphicsContext, uint32_t transferFamily,
+                                         uint32_t graphicsFamily) {
+        mGraphicsContext = pGraphicsContext;
+        mDevice = pGraphicsContext->getDevice();
+        mTransferFamily = transferFamily;
+        mGraphicsFamily = graphicsFamily;
+        mOwnershipTransfer = transferFamily != graphicsFamily;
+
+        VkSemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+
+        if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &mTimelineSemaphore) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create the upload timeline semaphore!");
+        }
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = mTransferFamily;
+
+        if (vkCreateCommandPool(mDevice, &poolInfo, nullptr, &mTransferCommandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create the upload command pool!");
+        }
+
+        // the region uploads need it even when the families are the same
+        poolInfo.queueFamilyIndex = mGraphicsFamily;
+        if (vkCreateCommandPool(mDevice, &poolInfo, nullptr, &mGraphicsCommandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create the upload command pool!");
+        }
+    }
+
+    VulkanUploadQueue::~VulkanUploadQueue() {
+        waitIdle();
+        collect();
+
+        vkDestroyCommandPool(mDevice, mTransferCommandPool, nullptr);
+        vkDestroyCommandPool(mDevice, mGraphicsCommandPool, nullptr);
+        vkDestroySemaphore(mDevice, mTimelineSemaphore, nullptr);
+    }
+
+    VkCommandBuffer VulkanUploadQueue::getCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList) {
+        VkCommandBuffer commandBuffer;
+
+        if (!freeList.empty()) {
+            commandBuffer = freeList.back();
+            freeList.pop_back();
+        } else {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = pool;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(mDevice, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate an upload command buffer!");
+            }
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+        return commandBuffer;
+    }
+
+    void VulkanUploadQueue::beginBatch() {
+        if (mRecording) {
+            return;
+        }
+
+        mBatch = Batch{};
+        mBatch.transferCommandBuffer = getCommandBuffer(mTransferCommandPool, mFreeTransferCommandBuffers);
+        // the release submit signals value - 2, the transfer submit value - 1 (or value without an ownership
+        // transfer) and the acquire submit value. the values that are not signaled are simply skipped
+        mBatch.value = mNextValue + 3;
+        mNextValue = mBatch.value;
+        mRecording = true;
+    }
+
+    VulkanStagingBuffer& VulkanUploadQueue::createStagingBuffer(const void* data, VkDeviceSize size) {
+        VulkanStagingBuffer& staging =
+            mBatch.stagingBuffers.emplace_back(mGraphicsContext->getStagingPool().acquire(size));
+        std::memcpy(staging.data(), data, size);
+
+        return staging;
+    }
+
+    uint64_t VulkanUploadQueue::uploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size,
+                                             VkDeviceSize dstOffset) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        beginBatch();
+
+        VulkanStagingBuffer& staging = createStagingBuffer(data, size);
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = 0;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(mBatch.transferCommandBuffer, staging.buffer, dstBuffer, 1, &copyRegion);
+
+        // without an ownership transfer the semaphore alone makes the copy visible to the frame
+        if (mOwnershipTransfer) {
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+            barrier.srcQueueFamilyIndex = mTransferFamily;
+            barrier.dstQueueFamilyIndex = mGraphicsFamily;
+            barrier.buffer = dstBuffer;
+            barrier.offset = dstOffset;
+            barrier.size = size;
+
+            vkCmdPipelineBarrier(mBatch.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+            barrier.srcAccessMask = 0;
+            mBatch.bufferAcquires.push_back(barrier);
+        }
+
+        return mBatch.value;
+    }
+
+    uint64_t VulkanUploadQueue::uploadImage2D(VkImage image, const void* data, uint32_t width, uint32_t height) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        beginBatch();
+
+        VulkanStagingBuffer& staging = createStagingBuffer(data, (VkDeviceSize)width * height * 4);
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(mBatch.transferCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {width, height, 1};
+
+        vkCmdCopyBufferToImage(mBatch.transferCommandBuffer, staging.buffer, image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        // the layout transition is part of the release so a transfer only queue never needs the shader stages
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        if (mOwnershipTransfer) {
+            barrier.srcQueueFamilyIndex = mTransferFamily;
+            barrier.dstQueueFamilyIndex = mGraphicsFamily;
+        }
+
+        vkCmdPipelineBarrier(mBatch.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        if (mOwnershipTransfer) {
+            barrier.srcAccessMask = 0;
+            mBatch.imageAcquires.push_back(barrier);
+        }
+
+        return mBatch.value;
+    }
+
+    uint64_t VulkanUploadQueue::uploadImage2DRegion(VkImage image, const void* data, uint32_t x, uint32_t y,
+                                                     uint32_t width, uint32_t height, uint64_t imageValue) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // the image was uploaded in this batch already, the release has to come after that copy
+        if (mRecording && imageValue == mBatch.value) {
+            flushLocked();
+        }
+
+        beginBatch();
+
+        VulkanStagingBuffer& staging = createStagingBuffer(data, (VkDeviceSize)width * height * 4);
+
+        // recorded on the graphics queue after the frames that might sample the image, the layout transition is part
+        // of it so the transfer queue never needs the shader stages
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = 0;
+        if (mOwnershipTransfer) {
+            barrier.srcQueueFamilyIndex = mGraphicsFamily;
+            barrier.dstQueueFamilyIndex = mTransferFamily;
+        }
+        mBatch.imageReleases.push_back(barrier);
+
+        // without an ownership transfer the semaphore between the submits is enough
+        if (mOwnershipTransfer) {
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            vkCmdPipelineBarrier(mBatch.transferCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        }
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {(int32_t)x, (int32_t)y, 0};
+        region.imageExtent = {width, height, 1};
+
+        vkCmdCopyBufferToImage(mBatch.transferCommandBuffer, staging.buffer, image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        // back to the graphics family, the same way uploadImage2D ends
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        if (mOwnershipTransfer) {
+            barrier.srcQueueFamilyIndex = mTransferFamily;
+            barrier.dstQueueFamilyIndex = mGraphicsFamily;
+        }
+
+        vkCmdPipelineBarrier(mBatch.transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        if (mOwnershipTransfer) {
+            barrier.srcAccessMask = 0;
+            mBatch.imageAcquires.push_back(barrier);
+        }
+
+        return mBatch.value;
+    }
+
+    void VulkanUploadQueue::submit(VkQueue queue, VkCommandBuffer commandBuffer, uint64_t waitValue,
+                                   uint64_t signalValue) {
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = waitValue != 0 ? 1 : 0;
+        timelineInfo.pWaitSemaphoreValues = &waitValue;
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.waitSemaphoreCount = waitValue != 0 ? 1 : 0;
+        submitInfo.pWaitSemaphores = &mTimelineSemaphore;
+        submitInfo.pWaitDstStageMask = &waitStage;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &mTimelineSemaphore;
+
+        std::lock_guard<std::recursive_mutex> queueLock(mGraphicsContext->getQueueMutex());
+        if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit an upload batch!");
+        }
+    }
+
+    uint64_t VulkanUploadQueue::flush() {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        return flushLocked();
+    }
+
+    uint64_t VulkanUploadQueue::flushLocked() {
+        if (!mRecording) {
+            return mSubmittedValue;
+        }
+
+        vkEndCommandBuffer(mBatch.transferCommandBuffer);
+
+        uint64_t transferWaitValue = 0;
+        if (!mBatch.imageReleases.empty()) {
+            // after every frame submitted so far on the graphics queue, and after the last batch since that might
+            // have been the one the images were uploaded in
+            mBatch.releaseCommandBuffer = getCommandBuffer(mGraphicsCommandPool, mFreeGraphicsCommandBuffers);
+            vkCmdPipelineBarrier(mBatch.releaseCommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr,
+                                 mBatch.imageReleases.size(), mBatch.imageReleases.data());
+            vkEndCommandBuffer(mBatch.releaseCommandBuffer);
+
+            submit(mGraphicsContext->getGraphicsQueue(), mBatch.releaseCommandBuffer, mSubmittedValue,
+                   mBatch.value - 2);
+            transferWaitValue = mBatch.value - 2;
+        }
+
+        if (!mOwnershipTransfer) {
+            submit(mGraphicsContext->getTransferQueue(), mBatch.transferCommandBuffer, transferWaitValue,
+                   mBatch.value);
+        } else {
+            submit(mGraphicsContext->getTransferQueue(), mBatch.transferCommandBuffer, transferWaitValue,
+                   mBatch.value - 1);
+
+            mBatch.graphicsCommandBuffer = getCommandBuffer(mGraphicsCommandPool, mFreeGraphicsCommandBuffers);
+            vkCmdPipelineBarrier(mBatch.graphicsCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, mBatch.bufferAcquires.size(),
+                                 mBatch.bufferAcquires.data(), mBatch.imageAcquires.size(),
+                                 mBatch.imageAcquires.data());
+            vkEndCommandBuffer(mBatch.graphicsCommandBuffer);
+
+            submit(mGraphicsContext->getGraphicsQueue(), mBatch.graphicsCommandBuffer, mBatch.value - 1,
+                   mBatch.value);
+        }
+
+        mSubmittedValue = mBatch.value;
+        mInFlightBatches.push_back(std::move(mBatch));
+        mRecording = false;
+
+        return mSubmittedValue;
+    }
+
+    bool VulkanUploadQueue::isComplete(uint64_t value) const {
+        uint64_t currentValue;
+        vkGetSemaphoreCounterValue(mDevice, mTimelineSemaphore, &currentValue);
+
+        return currentValue >= value;
+    }
+
+    void VulkanUploadQueue::wait(uint64_t value) {
+        bool submitted;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            submitted = value <= mSubmittedValue;
+        }
+        if (!submitted) {
+            flush();
+        }
+
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &mTimelineSemaphore;
+        waitInfo.pValues = &value;
+
+        vkWaitSemaphores(mDevice, &waitInfo, UINT64_MAX);
+
+        collect();
+    }
+
+    void VulkanUploadQueue::waitIdle() {
+        uint64_t value;
+        {
+            // written by beginBatch on whatever thread is uploading
+            std::lock_guard<std::mutex> lock(mMutex);
+            value = mNextValue;
+        }
+
+        wait(value);
+    }
+
+    void VulkanUploadQueue::collect() {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        uint64_t currentValue;
+        vkGetSemaphoreCounterValue(mDevice, mTimelineSemaphore, &currentValue);
+
+        while (!mInFlightBatches.empty() && mInFlightBatches.front().value <= currentValue) {
+            Batch& batch = mInFlightBatches.front();
+
+            for (VulkanStagingBuffer& staging : batch.stagingBuffers) {
+                mGraphicsContext->getStagingPool().release(&staging);
+            }
+
+            vkResetCommandBuffer(batch.transferCommandBuffer, 0);
+            mFreeTransferCommandBuffers.push_back(batch.transferCommandBuffer);
+            if (batch.graphicsCommandBuffer != VK_NULL_HANDLE) {
+                vkResetCommandBuffer(batch.graphicsCommandBuffer, 0);
+                mFreeGraphicsCommandBuffers.push_back(batch.graphicsCommandBuffer);
+            }
+            if (batch.releaseCommandBuffer != VK_NULL_HANDLE) {
+                vkResetCommandBuffer(batch.releaseCommandBuffer, 0);
+                mFreeGraphicsCommandBuffers.push_back(batch.releaseCommandBuffer);
+            }
+
+            mInFlightBatches.pop_front();
+        }
+    }
+} // namespace Car
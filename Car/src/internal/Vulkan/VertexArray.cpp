@@ -15,8 +15,14 @@ namespace Car {
 
     void VulkanVertexArray::bind() const {
         mShader->bind();
-        mVb->bind();
-        mIb->bind();
+        // vertex pulling shaders dont have a vertex buffer either
+        if (mVb) {
+            mVb->bind();
+        }
+        // instanced vertex arrays dont have an index buffer
+        if (mIb) {
+            mIb->bind();
+        }
     }
 
     Ref<VertexArray> VertexArray::Create(Ref<VertexBuffer> vb, Ref<IndexBuffer> ib, Ref<Shader> shader) {
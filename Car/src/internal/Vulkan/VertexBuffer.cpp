@@ -20,41 +20,37 @@ namespace Car {
             data = calloc(size, 1);
         }
 
-        VkDevice device = mGraphicsContext->getDevice();
         VkDeviceSize bufferSize = mSize;
 
         switch (mUsage) {
         case Buffer::Usage::DynamicDraw: {
             mGraphicsContext->createBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                           &mBuffer, &mBufferMemory);
+                                           &mBuffer, &mAllocation);
 
-            void* mappedData;
-            vkMapMemory(device, mBufferMemory, 0, mSize, 0, &mappedData);
-            std::memcpy(mappedData, data, (size_t)mSize);
-            vkUnmapMemory(device, mBufferMemory);
+            std::memcpy(mAllocation.mapped, data, (size_t)mSize);
             break;
         }
         case Buffer::Usage::StaticDraw: {
-            VkBuffer stagingBuffer;
-            VkDeviceMemory stagingBufferMemory;
-            mGraphicsContext->createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                           &stagingBuffer, &stagingBufferMemory);
-
-            void* mappedData;
-            vkMapMemory(device, stagingBufferMemory, 0, mSize, 0, &mappedData);
-            std::memcpy(mappedData, data, (size_t)mSize);
-            vkUnmapMemory(device, stagingBufferMemory);
-
             mGraphicsContext->createBuffer(bufferSize,
                                            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mBuffer, &mBufferMemory);
+                                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mBuffer, &mAllocation);
 
-            mGraphicsContext->copyBuffer(stagingBuffer, mBuffer, bufferSize, 0, 0);
+            mGraphicsContext->getUploadQueue().uploadBuffer(mBuffer, data, bufferSize);
+            break;
+        }
+        case Buffer::Usage::Stream: {
+            mStreamArenas.resize(mGraphicsContext->getMaxFramesInFlight());
+            for (StreamArena& arena : mStreamArenas) {
+                createStreamBlock(arena, mSize);
+            }
 
-            vkDestroyBuffer(device, stagingBuffer, nullptr);
-            vkFreeMemory(device, stagingBufferMemory, nullptr);
+            if (!shouldFree) {
+                uint64_t capacity;
+                void* mappedData = reserveStream(mSize, &capacity);
+                std::memcpy(mappedData, data, (size_t)mSize);
+                commitStream(mSize);
+            }
             break;
         }
         default: {
@@ -70,20 +66,112 @@ namespace Car {
     }
 
     void VulkanVertexBuffer::releaseDeviceObjects() {
-        VkDevice device = mGraphicsContext->getDevice();
-        vkDeviceWaitIdle(device);
-        vkDestroyBuffer(device, mBuffer, nullptr);
-        vkFreeMemory(device, mBufferMemory, nullptr);
+        // a static buffer might still be waiting for its upload
+        mGraphicsContext->getUploadQueue().waitIdle();
+        mGraphicsContext->waitIdle();
+
+        if (mUsage == Buffer::Usage::Stream) {
+            // mBuffer is one of the blocks so it is not destroyed on its own
+            for (StreamArena& arena : mStreamArenas) {
+                for (StreamBlock& block : arena.blocks) {
+                    mGraphicsContext->freeBuffer(&block.buffer, &block.allocation);
+                }
+            }
+            mStreamArenas.clear();
+            return;
+        }
+
+        mGraphicsContext->freeBuffer(&mBuffer, &mAllocation);
     }
 
     VulkanVertexBuffer::~VulkanVertexBuffer() { releaseDeviceObjects(); }
 
     void VulkanVertexBuffer::bind() const {
         VkBuffer vertexBuffers[] = {mBuffer};
-        VkDeviceSize offsets[] = {0};
+        VkDeviceSize offsets[] = {mBindOffset};
         vkCmdBindVertexBuffers(mGraphicsContext->getCurrentRenderCommandBuffer(), 0, 1, vertexBuffers, offsets);
     }
 
+    void VulkanVertexBuffer::createStreamBlock(StreamArena& arena, uint64_t size) {
+        StreamBlock block{};
+        block.size = size;
+
+        mGraphicsContext->createBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                       &block.buffer, &block.allocation);
+
+        // host visible allocations stay mapped for their whole lifetime
+        block.mapped = block.allocation.mapped;
+
+        arena.blocks.push_back(block);
+    }
+
+    VulkanVertexBuffer::StreamArena& VulkanVertexBuffer::getCurrentStreamArena() {
+        StreamArena& arena = mStreamArenas[mGraphicsContext->getCurrentFrameIndex()];
+
+        // first use of the arena in this frame, the in flight fence of this frame has already been waited on so
+        // everything written the last time this arena was used has been consumed
+        // NOTE: this means streaming should only happen while recording
+        if (arena.frameCount != mGraphicsContext->getFrameCount()) {
+            arena.frameCount = mGraphicsContext->getFrameCount();
+            arena.currentBlock = 0;
+            arena.head = 0;
+        }
+
+        return arena;
+    }
+
+    void* VulkanVertexBuffer::reserveStream(uint64_t minSize, uint64_t* pCapacity) {
+        CR_IF (mUsage != Buffer::Usage::Stream) {
+            CR_CORE_ERROR("Car::VertexBuffer::reserveStream(minSize, pCapacity), the VertexBuffer was not created with "
+                          "Car::Buffer::Usage::Stream");
+            CR_DEBUGBREAK();
+            return nullptr;
+        }
+
+        StreamArena& arena = getCurrentStreamArena();
+
+        // move to the next block, a new one is only allocated if this frame streams more than any frame before it
+        while (arena.head + minSize > arena.blocks[arena.currentBlock].size) {
+            arena.currentBlock++;
+            arena.head = 0;
+
+            if (arena.currentBlock == arena.blocks.size()) {
+                createStreamBlock(arena, MAX(mSize, minSize));
+            }
+        }
+
+        StreamBlock& block = arena.blocks[arena.currentBlock];
+
+        if (pCapacity != nullptr) {
+            *pCapacity = block.size - arena.head;
+        }
+
+        return block.mapped + arena.head;
+    }
+
+    void VulkanVertexBuffer::commitStream(uint64_t size) {
+        CR_IF (mUsage != Buffer::Usage::Stream) {
+            CR_CORE_ERROR("Car::VertexBuffer::commitStream(size), the VertexBuffer was not created with "
+                          "Car::Buffer::Usage::Stream");
+            CR_DEBUGBREAK();
+            return;
+        }
+
+        StreamArena& arena = getCurrentStreamArena();
+        StreamBlock& block = arena.blocks[arena.currentBlock];
+
+        CR_IF (arena.head + size > block.size) {
+            CR_CORE_ERROR("Car::VertexBuffer::commitStream(size), size is larger than the last reservation");
+            CR_DEBUGBREAK();
+            return;
+        }
+
+        mBuffer = block.buffer;
+        mBindOffset = arena.head;
+        arena.head += size;
+    }
+
     void VulkanVertexBuffer::updateData(void* data, uint64_t size, uint64_t offset) {
         CR_IF (data == nullptr) {
             CR_CORE_ERROR("Car::VertexBuffer::updateData(data, size, offset), data can not be a null pointer");
@@ -92,35 +180,33 @@ namespace Car {
             CR_CORE_ERROR("Car::VertexBuffer::updateData(data, size, offset), size can not be 0");
         }
 
-        VkDevice device = mGraphicsContext->getDevice();
+        if (mUsage == Buffer::Usage::Stream) {
+            CR_IF (offset != 0) {
+                CR_CORE_ERROR("Car::VertexBuffer::updateData(data, size, offset), offset must be 0 for a VertexBuffer "
+                              "created with Car::Buffer::Usage::Stream");
+                return;
+            }
+
+            void* mappedData = reserveStream(size, nullptr);
+            std::memcpy(mappedData, data, (size_t)size);
+            commitStream(size);
+            return;
+        }
 
         if (offset == 0) {
             if (size <= mSize) {
                 switch (mUsage) {
                 case Buffer::Usage::DynamicDraw: {
-                    void* mappedData;
-                    vkMapMemory(device, mBufferMemory, 0, size, 0, &mappedData);
-                    std::memcpy(mappedData, data, (size_t)size);
-                    vkUnmapMemory(device, mBufferMemory);
+                    std::memcpy(mAllocation.mapped, data, (size_t)size);
                     break;
                 }
                 case Buffer::Usage::StaticDraw: {
-                    VkBuffer stagingBuffer;
-                    VkDeviceMemory stagingBufferMemory;
-                    mGraphicsContext->createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                   &stagingBuffer, &stagingBufferMemory);
+                    VulkanStagingBuffer staging = mGraphicsContext->getStagingPool().acquire(size);
+                    std::memcpy(staging.data(), data, (size_t)size);
 
-                    void* mappedData;
-                    vkMapMemory(device, stagingBufferMemory, 0, size, 0, &mappedData);
-                    std::memcpy(mappedData, data, (size_t)size);
-                    vkUnmapMemory(device, stagingBufferMemory);
+                    mGraphicsContext->copyBuffer(staging.buffer, mBuffer, size, 0, 0);
 
-                    mGraphicsContext->copyBuffer(stagingBuffer, mBuffer, size, 0, 0);
-
-                    vkDestroyBuffer(device, stagingBuffer, nullptr);
-                    vkFreeMemory(device, stagingBufferMemory, nullptr);
+                    mGraphicsContext->getStagingPool().release(&staging);
                     break;
                 }
                 default: {
@@ -139,35 +225,17 @@ namespace Car {
                     mGraphicsContext->createBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                                                        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                   &mBuffer, &mBufferMemory);
+                                                   &mBuffer, &mAllocation);
 
-                    void* mappedData;
-                    vkMapMemory(device, mBufferMemory, 0, mSize, 0, &mappedData);
-                    std::memcpy(mappedData, data, (size_t)mSize);
-                    vkUnmapMemory(device, mBufferMemory);
+                    std::memcpy(mAllocation.mapped, data, (size_t)mSize);
                     break;
                 }
                 case Buffer::Usage::StaticDraw: {
-                    VkBuffer stagingBuffer;
-                    VkDeviceMemory stagingBufferMemory;
-                    mGraphicsContext->createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                   &stagingBuffer, &stagingBufferMemory);
-
-                    void* mappedData;
-                    vkMapMemory(device, stagingBufferMemory, 0, mSize, 0, &mappedData);
-                    std::memcpy(mappedData, data, (size_t)mSize);
-                    vkUnmapMemory(device, stagingBufferMemory);
-
                     mGraphicsContext->createBuffer(bufferSize,
                                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mBuffer, &mBufferMemory);
-
-                    mGraphicsContext->copyBuffer(stagingBuffer, mBuffer, bufferSize, 0, 0);
+                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mBuffer, &mAllocation);
 
-                    vkDestroyBuffer(device, stagingBuffer, nullptr);
-                    vkFreeMemory(device, stagingBufferMemory, nullptr);
+                    mGraphicsContext->getUploadQueue().uploadBuffer(mBuffer, data, bufferSize);
                     break;
                 }
                 default: {
@@ -181,29 +249,16 @@ namespace Car {
             if (offset + size <= mSize) {
                 switch (mUsage) {
                 case Buffer::Usage::DynamicDraw: {
-                    void* mappedData;
-                    vkMapMemory(device, mBufferMemory, offset, size, 0, &mappedData);
-                    std::memcpy(mappedData, data, (size_t)size);
-                    vkUnmapMemory(device, mBufferMemory);
+                    std::memcpy(mAllocation.mapped + offset, data, (size_t)size);
                     break;
                 }
                 case Buffer::Usage::StaticDraw: {
-                    VkBuffer stagingBuffer;
-                    VkDeviceMemory stagingBufferMemory;
-                    mGraphicsContext->createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                   &stagingBuffer, &stagingBufferMemory);
-
-                    void* mappedData;
-                    vkMapMemory(device, stagingBufferMemory, offset, size, 0, &mappedData);
-                    std::memcpy(mappedData, data, (size_t)size);
-                    vkUnmapMemory(device, stagingBufferMemory);
+                    VulkanStagingBuffer staging = mGraphicsContext->getStagingPool().acquire(size);
+                    std::memcpy(staging.data(), data, (size_t)size);
 
-                    mGraphicsContext->copyBuffer(stagingBuffer, mBuffer, size, 0, offset);
+                    mGraphicsContext->copyBuffer(staging.buffer, mBuffer, size, 0, offset);
 
-                    vkDestroyBuffer(device, stagingBuffer, nullptr);
-                    vkFreeMemory(device, stagingBufferMemory, nullptr);
+                    mGraphicsContext->getStagingPool().release(&staging);
                     break;
                 }
                 default: {
@@ -219,10 +274,7 @@ namespace Car {
                     if (offset <= mSize) {
                         temp = (uint8_t*)std::malloc(offset + size);
 
-                        void* mappedData;
-                        vkMapMemory(device, mBufferMemory, 0, offset, 0, &mappedData);
-                        std::memcpy(temp, mappedData, (size_t)offset);
-                        vkUnmapMemory(device, mBufferMemory);
+                        std::memcpy(temp, mAllocation.mapped, (size_t)offset);
 
                         std::memcpy(temp + offset, data, size);
 
@@ -232,10 +284,7 @@ namespace Car {
 
                         std::memset(temp + mSize - 1, 0, mSize - offset + 2);
 
-                        void* mappedData;
-                        vkMapMemory(device, mBufferMemory, 0, mSize, 0, &mappedData);
-                        std::memcpy(temp, mappedData, (size_t)mSize);
-                        vkUnmapMemory(device, mBufferMemory);
+                        std::memcpy(temp, mAllocation.mapped, (size_t)mSize);
 
                         std::memcpy(temp + offset, data, size);
 
@@ -247,12 +296,9 @@ namespace Car {
                     mGraphicsContext->createBuffer(mSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                                                        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                   &mBuffer, &mBufferMemory);
+                                                   &mBuffer, &mAllocation);
 
-                    void* mappedData;
-                    vkMapMemory(device, mBufferMemory, 0, mSize, 0, &mappedData);
-                    std::memcpy(mappedData, temp, (size_t)mSize);
-                    vkUnmapMemory(device, mBufferMemory);
+                    std::memcpy(mAllocation.mapped, temp, (size_t)mSize);
 
                     std::free(temp);
                     break;
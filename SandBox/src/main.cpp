@@ -48,7 +48,7 @@ public:
         }
     }
 
-    virtual void onRender() override {
+    virtual void onRender(double) override {
         for (const auto& wall : mWalls) {
             Car::Renderer2D::DrawLine(wall.start, wall.end);
         }
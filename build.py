@@ -266,6 +266,9 @@ def carlib() -> None:
             "./Car/src/Application.cpp",
             "./Car/src/ResourceManager.cpp",
             "./Car/src/Time.cpp",
+            "./Car/src/FramePacer.cpp",
+            "./Car/src/RenderThread.cpp",
+            "./Car/src/Jobs.cpp",
             "./Car/src/Input.cpp",
             "./Car/src/Window.cpp",
             "./Car/src/Random.cpp",
@@ -275,9 +278,18 @@ def carlib() -> None:
             "./Car/src/Renderer/Buffer.cpp",
             "./Car/src/Renderer/Renderer2D.cpp",
             "./Car/src/Renderer/Font.cpp",
+            "./Car/src/Renderer/TextLayout.cpp",
+            "./Car/src/Renderer/ParticleSystem2D.cpp",
             "./Car/src/internal/Vulkan/Renderer.cpp",
             "./Car/src/internal/Vulkan/GraphicsContext.cpp",
+            "./Car/src/internal/Vulkan/MemoryAllocator.cpp",
+            "./Car/src/internal/Vulkan/StagingPool.cpp",
+            "./Car/src/internal/Vulkan/DescriptorAllocator.cpp",
+            "./Car/src/internal/Vulkan/UploadQueue.cpp",
             "./Car/src/internal/Vulkan/Shader.cpp",
+            "./Car/src/internal/Vulkan/ShaderDescriptors.cpp",
+            "./Car/src/internal/Vulkan/ComputeShader.cpp",
+            "./Car/src/internal/Vulkan/ShaderBundle.cpp",
             "./Car/src/internal/Vulkan/IndexBuffer.cpp",
             "./Car/src/internal/Vulkan/VertexBuffer.cpp",
             "./Car/src/internal/Vulkan/SSBO.cpp",
@@ -48,7 +48,7 @@ public:
         }
     }
 
-    virtual void onRender() override {
+    virtual void onRender(double) override {
         for (const auto& wall : mWalls) {
             Car::Renderer2D::DrawLine(wall.start, wall.end);
         }
@@ -56,47 +56,67 @@ public:
         glm::ivec2 mousePos_ = Car::Input::MousePos();
         glm::vec2 mousePos = {mousePos_.x, mousePos_.y};
 
-        for (float i = 0; i < 360.0f; i += 1.0f) {
-            glm::vec2 ray(glm::cos(glm::radians(i)), glm::sin(glm::radians(i)));
-
-            float x3 = mousePos.x;
-            float y3 = mousePos.y;
-            float x4 = x3 + ray.x;
-            float y4 = y3 + ray.y;
-            float record = FLT_MAX;
-            glm::vec2 closePoint;
-            for (const auto& wall : mWalls) {
-                float x1 = wall.start.x;
-                float y1 = wall.start.y;
-                float x2 = wall.end.x;
-                float y2 = wall.end.y;
-
-                float den = (x1 - x2) * (y3 - y4) - (y1 - y2) * (x3 - x4);
-
-                if (den == 0) { // line are parallel and they will never meet even if you stretch them out infinitely
-                    continue;
-                }
+        // every ray is tested against every wall on the workers, only the drawing happens here
+        mHits.resize(360);
+        Car::Jobs::ParallelForAndWait(0, 360, [this, mousePos](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                mHits[i] = castRay(mousePos, glm::radians((float)i));
+            }
+        });
+
+        for (const Hit& hit : mHits) {
+            if (hit.found) {
+                Car::Renderer2D::DrawLine(mousePos, hit.point, {0.0f, 1.0f, 0.f});
+            }
+        }
+    }
 
-                float t = ((x1 - x3) * (y3 - y4) - (y1 - y3) * (x3 - x4)) / den;
-                float u = -((x1 - x2) * (y1 - y3) - (y1 - y2) * (x1 - x3)) / den;
+    struct Hit {
+        glm::vec2 point;
+        bool found;
+    };
 
-                if (0 <= t && t <= 1 && 0 <= u) {
-                    float dis = glm::distance(mousePos, {x1 + t * (x2 - x1), y1 + t * (y2 - y1)});
-                    if (dis < record && dis < mMaxDistance) {
-                        record = dis;
-                        closePoint.x = x1 + t * (x2 - x1);
-                        closePoint.y = y1 + t * (y2 - y1);
-                    }
-                }
+    Hit castRay(glm::vec2 origin, float angle) const {
+        glm::vec2 ray(glm::cos(angle), glm::sin(angle));
+
+        float x3 = origin.x;
+        float y3 = origin.y;
+        float x4 = x3 + ray.x;
+        float y4 = y3 + ray.y;
+        float record = FLT_MAX;
+        Hit hit{{0.0f, 0.0f}, false};
+        for (const auto& wall : mWalls) {
+            float x1 = wall.start.x;
+            float y1 = wall.start.y;
+            float x2 = wall.end.x;
+            float y2 = wall.end.y;
+
+            float den = (x1 - x2) * (y3 - y4) - (y1 - y2) * (x3 - x4);
+
+            if (den == 0) { // line are parallel and they will never meet even if you stretch them out infinitely
+                continue;
             }
-            if (record < FLT_MAX) {
-                Car::Renderer2D::DrawLine(mousePos, closePoint, {0.0f, 1.0f, 0.f});
+
+            float t = ((x1 - x3) * (y3 - y4) - (y1 - y3) * (x3 - x4)) / den;
+            float u = -((x1 - x2) * (y1 - y3) - (y1 - y2) * (x1 - x3)) / den;
+
+            if (0 <= t && t <= 1 && 0 <= u) {
+                float dis = glm::distance(origin, {x1 + t * (x2 - x1), y1 + t * (y2 - y1)});
+                if (dis < record && dis < mMaxDistance) {
+                    record = dis;
+                    hit.point.x = x1 + t * (x2 - x1);
+                    hit.point.y = y1 + t * (y2 - y1);
+                    hit.found = true;
+                }
             }
         }
+
+        return hit;
     }
 
 private:
     std::vector<Wall> mWalls;
+    std::vector<Hit> mHits;
     int32_t mWallCount;
     float mMaxDistance = 500;
 };
@@ -0,0 +1,47 @@
+#version 450 core
+
+// draws the particles of ParticleSystem2D.comp as quads for Renderer2D.frag, dead ones collapse to a point
+struct Particle {
+    vec2 pos;
+    vec2 velocity;
+    float age;
+    float lifetime;
+    float padding0, padding1;
+};
+
+layout(std430, set=1, binding=0) readonly buffer Particles {
+    Particle uParticles[];
+};
+
+layout(location=0) out vec2 oSourceUV;
+layout(location=1) out vec4 oTint;
+layout(location=2) out flat uint oTextureID;
+
+layout(push_constant) uniform PC {
+    mat4 uProj;
+    vec4 uStartColor;
+    vec4 uEndColor;
+    float uStartSize;
+    float uEndSize;
+    uint uTextureID;
+};
+
+// same as Renderer2DStatic.vert
+const vec2 cCorners[6] = vec2[](
+    vec2(0.0f, 0.0f), vec2(1.0f, 0.0f), vec2(1.0f, 1.0f),
+    vec2(1.0f, 1.0f), vec2(0.0f, 1.0f), vec2(0.0f, 0.0f)
+);
+
+void main() {
+    Particle p = uParticles[gl_InstanceIndex];
+    vec2 corner = cCorners[gl_VertexIndex];
+
+    float t = p.lifetime > 0.0f ? p.age / p.lifetime : 1.0f;
+    // a zero sized quad has no area so nothing is rasterized
+    float size = t < 1.0f ? mix(uStartSize, uEndSize, t) : 0.0f;
+
+    gl_Position = uProj * vec4(p.pos + (corner - 0.5f) * size, 0.0f, 1.0f);
+    oSourceUV = corner;
+    oTint = mix(uStartColor, uEndColor, min(t, 1.0f));
+    oTextureID = uTextureID;
+}
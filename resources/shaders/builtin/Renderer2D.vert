@@ -1,12 +1,15 @@
 #version 450 core
 
+// per instance
 layout(location=0) in vec2 iPos;
-layout(location=1) in vec2 iSourceUV;
-layout(location=2) in vec3 iTint;
-layout(location=3) in uint iTextureID;
+layout(location=1) in vec2 iSize;
+layout(location=2) in vec4 iSourceRect;
+layout(location=3) in vec4 iTint;
+layout(location=4) in uint iTextureID;
+layout(location=5) in float iRotation;
 
 layout(location=0) out vec2 oSourceUV;
-layout(location=1) out vec3 oTint;
+layout(location=1) out vec4 oTint;
 layout(location=2) out flat uint oTextureID;
 
 
@@ -14,9 +17,23 @@ layout(push_constant) uniform PC {
     mat4 uProj;
 };
 
+// two clockwise triangles, same winding as the old index buffer (0, 1, 2, 2, 3, 0)
+const vec2 cCorners[6] = vec2[](
+    vec2(0.0f, 0.0f), vec2(1.0f, 0.0f), vec2(1.0f, 1.0f),
+    vec2(1.0f, 1.0f), vec2(0.0f, 1.0f), vec2(0.0f, 0.0f)
+);
+
 void main() {
-    gl_Position = uProj * vec4(iPos, 0.0f, 1.0f);
-    oSourceUV = iSourceUV; 
+    vec2 corner = cCorners[gl_VertexIndex];
+
+    // rotate around the center of the quad
+    vec2 local = (corner - 0.5f) * iSize;
+    float c = cos(iRotation);
+    float s = sin(iRotation);
+    vec2 pos = iPos + iSize * 0.5f + vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    gl_Position = uProj * vec4(pos, 0.0f, 1.0f);
+    oSourceUV = iSourceRect.xy + corner * iSourceRect.zw;
     oTint = iTint;
     oTextureID = iTextureID;
-}
\ No newline at end of file
+}
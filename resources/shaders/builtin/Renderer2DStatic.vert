@@ -0,0 +1,49 @@
+#version 450 core
+
+// Renderer2D.vert that pulls the sprites out of a storage buffer instead of taking them as instance attributes, the
+// members are scalars so the stride matches Renderer2DInstance (44 bytes) without padding
+struct Sprite {
+    float posX, posY;
+    float sizeX, sizeY;
+    float srcX, srcY, srcW, srcH;
+    uint tint;
+    uint textureID;
+    float rotation;
+};
+
+layout(std430, set=1, binding=0) readonly buffer Sprites {
+    Sprite uSprites[];
+};
+
+layout(location=0) out vec2 oSourceUV;
+layout(location=1) out vec4 oTint;
+layout(location=2) out flat uint oTextureID;
+
+
+layout(push_constant) uniform PC {
+    mat4 uProj;
+};
+
+// two clockwise triangles, same winding as the old index buffer (0, 1, 2, 2, 3, 0)
+const vec2 cCorners[6] = vec2[](
+    vec2(0.0f, 0.0f), vec2(1.0f, 0.0f), vec2(1.0f, 1.0f),
+    vec2(1.0f, 1.0f), vec2(0.0f, 1.0f), vec2(0.0f, 0.0f)
+);
+
+void main() {
+    Sprite sprite = uSprites[gl_InstanceIndex];
+    vec2 corner = cCorners[gl_VertexIndex];
+    vec2 spritePos = vec2(sprite.posX, sprite.posY);
+    vec2 size = vec2(sprite.sizeX, sprite.sizeY);
+
+    // rotate around the center of the quad
+    vec2 local = (corner - 0.5f) * size;
+    float c = cos(sprite.rotation);
+    float s = sin(sprite.rotation);
+    vec2 pos = spritePos + size * 0.5f + vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    gl_Position = uProj * vec4(pos, 0.0f, 1.0f);
+    oSourceUV = vec2(sprite.srcX, sprite.srcY) + corner * vec2(sprite.srcW, sprite.srcH);
+    oTint = unpackUnorm4x8(sprite.tint);
+    oTextureID = sprite.textureID;
+}
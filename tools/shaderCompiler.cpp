@@ -1,11 +1,17 @@
 #include <shaderc/shaderc.h>
 #include <shaderc/shaderc.hpp>
-#include <spirv_cross/spirv_cross.hpp>
 #include <Car/internal/Vulkan/CompiledShader.hpp>
+#include <Car/internal/Vulkan/ShaderIncluder.hpp>
+#include <Car/internal/Vulkan/ShaderReflection.hpp>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
 #include <utility>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <sstream>
+#include <unordered_set>
 
 std::string readFile(const std::string& path) {
     std::ifstream file(path);
@@ -36,12 +42,23 @@ void writeToFile(const std::string& path, const std::vector<uint8_t>& data) {
     }
 }
 
-std::string compileSingleShader(const std::string& path, const shaderc_shader_kind kind) {
+uint64_t shaderCompilerVersion() {
+    unsigned int version = 0;
+    unsigned int revision = 0;
+    shaderc_get_spv_version(&version, &revision);
+
+    return ((uint64_t)version << 32) | revision;
+}
+
+// a shaderc::Compiler is not free to create so every worker keeps its own
+std::string compileSingleShader(const shaderc::Compiler& compiler, const std::string& path,
+                                const shaderc_shader_kind kind) {
     std::string sourceCode = readFile(path);
     shaderc::CompileOptions options;
-    shaderc::Compiler compiler;
+    // keep CR_SHADER_COMPILE_OPTIONS in sync with these
     options.SetOptimizationLevel(shaderc_optimization_level_performance);
     options.SetSourceLanguage(shaderc_source_language_glsl);
+    options.SetIncluder(std::make_unique<Car::ShaderIncluder>("."));
 
     options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
 
@@ -55,108 +72,329 @@ std::string compileSingleShader(const std::string& path, const shaderc_shader_ki
     return std::string(reinterpret_cast<char*>(res.data()), res.size() * sizeof(uint32_t));
 }
 
-void fillSetField(Car::SingleCompiledShader* pSCS) {
-    pSCS->sets.resize(0);
-    spirv_cross::Compiler compiler((uint32_t*)pSCS->shader.data(), pSCS->shader.size() / 4);
-    spirv_cross::ShaderResources resources(compiler.get_shader_resources());
+struct Job {
+    std::string file;
+    shaderc_shader_kind kind;
+};
 
-    uint32_t maxDescriptorSetCount = 0;
-    for (const auto& uniformBuffer : resources.uniform_buffers) {
-        maxDescriptorSetCount =
-            MAX(compiler.get_decoration(uniformBuffer.id, spv::DecorationDescriptorSet) + 1, maxDescriptorSetCount);
+bool parseKind(const std::string& kindStr, shaderc_shader_kind* pKind) {
+    if (kindStr == "vert") {
+        *pKind = shaderc_vertex_shader;
+    } else if (kindStr == "frag") {
+        *pKind = shaderc_fragment_shader;
+    } else if (kindStr == "comp") {
+        *pKind = shaderc_compute_shader;
+    } else {
+        return false;
     }
-    for (const auto& uniformBuffer : resources.sampled_images) {
-        maxDescriptorSetCount =
-            MAX(compiler.get_decoration(uniformBuffer.id, spv::DecorationDescriptorSet) + 1, maxDescriptorSetCount);
+    return true;
+}
+
+Car::DescriptorStage kindToStage(shaderc_shader_kind kind) {
+    switch (kind) {
+    case shaderc_vertex_shader:
+        return Car::DescriptorStage::VertexShader;
+    case shaderc_fragment_shader:
+        return Car::DescriptorStage::FragmeantShader;
+    default:
+        return Car::DescriptorStage::ComputeShader;
     }
+}
 
-    if (maxDescriptorSetCount > 4) {
-        throw std::runtime_error("A shader can have max of 4 sets per the vulkan spec");
+// `*` and `?` stop at a '/', `**` does not
+bool globMatch(const char* pattern, const char* path) {
+    while (*pattern) {
+        if (pattern[0] == '*' && pattern[1] == '*') {
+            pattern += 2;
+            if (*pattern == '/') {
+                // "**/" can match nothing at all
+                if (globMatch(pattern + 1, path)) {
+                    return true;
+                }
+            }
+            for (const char* p = path;; p++) {
+                if (globMatch(pattern, p)) {
+                    return true;
+                }
+                if (!*p) {
+                    return false;
+                }
+            }
+        }
+        if (*pattern == '*') {
+            pattern++;
+            for (const char* p = path;; p++) {
+                if (globMatch(pattern, p)) {
+                    return true;
+                }
+                if (!*p || *p == '/') {
+                    return false;
+                }
+            }
+        }
+        if (!*path || (*pattern != '?' && *pattern != *path) || (*pattern == '?' && *path == '/')) {
+            return false;
+        }
+        pattern++;
+        path++;
     }
+    return !*path;
+}
 
-    pSCS->sets.resize(maxDescriptorSetCount);
+// every .vert, .frag and .comp under the current directory that matches, the kind comes from the extension
+bool addGlob(const std::string& pattern, std::vector<Job>* pJobs) {
+    bool found = false;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(".")) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        std::string path = entry.path().lexically_relative(".").generic_string();
+        if (path.rfind("__CACHE__/", 0) == 0 || !globMatch(pattern.c_str(), path.c_str())) {
+            continue;
+        }
 
-    for (const auto& resource : resources.uniform_buffers) {
-        uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
-        uint8_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
-        pSCS->sets[set].push_back({
-            binding,
-            Car::DescriptorType::UniformBuffer,
-            Car::DescriptorStage::VertexShader,
-        });
+        shaderc_shader_kind kind;
+        if (!parseKind(entry.path().extension().string().substr(1), &kind)) {
+            continue;
+        }
+        pJobs->push_back({path, kind});
+        found = true;
     }
+    return found;
+}
 
-    for (const auto& resource : resources.sampled_images) {
-        uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
-        uint8_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
-        pSCS->sets[set].push_back({
-            binding,
-            Car::DescriptorType::Sampler2D,
-            Car::DescriptorStage::VertexShader,
-        });
+// one `<filename> <vert|frag|comp>` pair per line, empty lines and lines starting with # are skipped
+bool addManifest(const std::string& manifestPath, std::vector<Job>* pJobs) {
+    std::ifstream manifest(manifestPath);
+    if (!manifest.is_open()) {
+        std::cerr << "can not open manifest " << manifestPath << std::endl;
+        return false;
+    }
+
+    bool ok = true;
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(manifest, line)) {
+        lineNumber++;
+        std::istringstream ss(line);
+        std::string file, kindStr;
+        if (!(ss >> file) || file[0] == '#') {
+            continue;
+        }
+
+        shaderc_shader_kind kind;
+        if (!(ss >> kindStr) || !parseKind(kindStr, &kind)) {
+            std::cerr << manifestPath << ":" << lineNumber << ": expected <filename> <vert|frag|comp>" << std::endl;
+            ok = false;
+            continue;
+        }
+        pJobs->push_back({file, kind});
+    }
+    return ok;
+}
+
+// a file can be given more than once (explicitly and by a glob, or by two globs), two threads compiling it would write
+// the same .crss at the same time and the bundle would get it twice
+void removeDuplicateJobs(std::vector<Job>* pJobs) {
+    std::unordered_set<std::string> seen;
+    std::vector<Job> unique;
+    for (Job& job : *pJobs) {
+        job.file = std::filesystem::path(job.file).lexically_normal().generic_string();
+        if (seen.insert(job.file + ":" + std::to_string((int)job.kind)).second) {
+            unique.push_back(job);
+        }
+    }
+    *pJobs = std::move(unique);
+}
+
+// returns true if the file on disk changed
+bool writeIfChanged(const std::string& path, const std::vector<uint8_t>& data) {
+    std::ifstream existing(path, std::ios::binary);
+    if (existing.is_open()) {
+        std::vector<uint8_t> old((std::istreambuf_iterator<char>(existing)), std::istreambuf_iterator<char>());
+        if (old == data) {
+            return false;
+        }
     }
+
+    writeToFile(path, data);
+    return true;
 }
 
+void printUsage() {
+    std::cout << "shaderCompiler is a simple program similar to glslc but it dumps out data optimal for car" << std::endl;
+    std::cout << "it is meant to be run from the shaders folder in the resource folder" << std::endl;
+    std::cerr << "Usage: [-j N] [-f] [-b] [-m manifest] [-g glob] [filename1 (vert|frag|comp) ...]" << std::endl;
+    std::cerr << "    -j N         compile on N threads (default: all cores)" << std::endl;
+    std::cerr << "    -f           compile even if the .crss is up to date" << std::endl;
+    std::cerr << "    -b           also pack every shader into __CACHE__/shaders.crsb" << std::endl;
+    std::cerr << "    -m manifest  file with a `<filename> <vert|frag|comp>` pair per line" << std::endl;
+    std::cerr << "    -g glob      every .vert/.frag/.comp matching the glob, e.g. \"**/*\"" << std::endl;
+}
 
 int main(int argc, char** argv) {
     argc--;
     argv++;
     
-    if (argc % 2 || argc == 0) {
-        std::cout << "shaderCompiler is a simple program similar to glslc but it dumps out data optimal for car" << std::endl;
-        std::cout << "it is meant to be run from the shaders folder in the resource folder" << std::endl;
-        std::cerr << "Usage: <filename1 (vert|frag)> [filename2 (vert|frag) ...]" << std::endl;
-        return 1;
-    }
+    std::vector<Job> jobs;
+    uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    bool force = false;
+    bool bundle = false;
+    bool ok = true;
     
-    std::vector<std::string> files;
-    std::vector<shaderc_shader_kind> shaderKinds;
-    
-    while (argc) {        
-        std::string file = argv[0];
-        if (!std::filesystem::exists(file)) {
-            std::cerr << "file " << file << " doesnt exist" << std::endl;
-        }
-        
-        files.push_back(file);
+    while (argc) {
+        std::string arg = argv[0];
         
-        std::string kindStr = argv[1];
+        if ((arg == "-j" || arg == "-m" || arg == "-g") && argc < 2) {
+            std::cerr << arg << " needs an argument" << std::endl;
+            printUsage();
+            return 1;
+        }
         
-        if (kindStr == "vert") {
-            shaderKinds.push_back(shaderc_vertex_shader);
-        } else if (kindStr == "frag") {
-            shaderKinds.push_back(shaderc_fragment_shader);
+        if (arg == "-j") {
+            threadCount = std::max(1, std::atoi(argv[1]));
+        } else if (arg == "-m") {
+            ok = addManifest(argv[1], &jobs) && ok;
+        } else if (arg == "-g") {
+            if (!addGlob(argv[1], &jobs)) {
+                std::cerr << "glob " << argv[1] << " did not match any shader" << std::endl;
+            }
+        } else if (arg == "-f" || arg == "-b") {
+            (arg == "-f" ? force : bundle) = true;
+            argc -= 1;
+            argv += 1;
+            continue;
         } else {
-            std::cerr << "shader kind " << kindStr << " is not vert nor frag" << std::endl;
+            shaderc_shader_kind kind;
+            if (argc < 2 || !parseKind(argv[1], &kind)) {
+                std::cerr << "shader kind for " << arg << " is not vert, frag nor comp" << std::endl;
+                printUsage();
+                return 1;
+            }
+            jobs.push_back({arg, kind});
         }
         
         argc -= 2;
         argv += 2;
     }
     
+    if (jobs.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    removeDuplicateJobs(&jobs);
+    
+    for (const Job& job : jobs) {
+        if (!std::filesystem::exists(job.file)) {
+            std::cerr << "file " << job.file << " doesnt exist" << std::endl;
+            return 1;
+        }
+    }
+    
     std::filesystem::path cacheDir = "__CACHE__";
     if (!std::filesystem::exists(cacheDir)) {
         std::filesystem::create_directories(cacheDir);
     }
     
-    for (uint32_t i = 0; i < files.size(); i++) {
-        std::string targetFile = files[i];
-        shaderc_shader_kind shaderKind = shaderKinds[i];
-        std::cout << "compiling " << targetFile << std::endl;
-        
-        std::string contents = readFile(targetFile);
-        
-        Car::SingleCompiledShader compiledShader;
-        compiledShader.shader = compileSingleShader(targetFile, shaderKind);
-        fillSetField(&compiledShader);
-        
-        std::filesystem::path outFile = std::string(cacheDir / targetFile) + ".crss";
+    const uint64_t compilerVersion = shaderCompilerVersion();
+    
+    std::atomic<size_t> nextJob = 0;
+    std::atomic<uint32_t> compiledCount = 0;
+    std::atomic<uint32_t> writtenCount = 0;
+    std::atomic<bool> failed = false;
+    std::mutex outputMutex;
+    // only kept for the bundle
+    std::vector<Car::SingleCompiledShader> results(bundle ? jobs.size() : 0);
+    
+    auto worker = [&]() {
+        shaderc::Compiler compiler;
         
-        std::filesystem::create_directories(outFile.parent_path());
+        for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+            const Job& job = jobs[i];
+            std::filesystem::path outFile = std::string(cacheDir / job.file) + ".crss";
+            
+            try {
+                Car::SingleCompiledShader compiledShader;
+                compiledShader.header.sourceHash =
+                    Car::computeShaderSourceHash(job.file, ".", Car::DescriptorStageExtension(kindToStage(job.kind)));
+                compiledShader.header.compilerVersion = compilerVersion;
+                
+                // the header already says whether the source changed so an up to date shader is not even compiled
+                if (!force && std::filesystem::exists(outFile)) {
+                    std::ifstream existing(outFile, std::ios::binary);
+                    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(existing)),
+                                               std::istreambuf_iterator<char>());
+                    Car::CompiledShaderHeader header;
+                    if (Car::SingleCompiledShader::readHeader(bytes, &header) &&
+                        header.sourceHash == compiledShader.header.sourceHash &&
+                        header.compilerVersion == compiledShader.header.compilerVersion) {
+                        // a write that was cut short keeps the header, so the rest is checked too and recompiled if
+                        // it is truncated
+                        try {
+                            Car::SingleCompiledShader existingShader = Car::SingleCompiledShader::fromBytes(bytes);
+                            if (bundle) {
+                                results[i] = std::move(existingShader);
+                            }
+                            continue;
+                        } catch (const std::runtime_error&) {
+                        }
+                    }
+                }
+                
+                {
+                    std::lock_guard<std::mutex> lock(outputMutex);
+                    std::cout << "compiling " << job.file << std::endl;
+                }
+                
+                compiledShader.shader = compileSingleShader(compiler, job.file, job.kind);
+                Car::ShaderReflection::reflect(&compiledShader, kindToStage(job.kind));
+                compiledCount++;
+                
+                std::filesystem::create_directories(outFile.parent_path());
+                
+                if (writeIfChanged(std::string(outFile), compiledShader.toBytes())) {
+                    writtenCount++;
+                }
+                
+                if (bundle) {
+                    results[i] = std::move(compiledShader);
+                }
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cerr << job.file << ": " << e.what() << std::endl;
+                failed = true;
+            }
+        }
+    };
+    
+    threadCount = std::min<uint32_t>(threadCount, jobs.size());
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < threadCount; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    
+    if (bundle && !failed) {
+        std::vector<Car::CompiledShaderBundleInput> inputs;
+        for (size_t i = 0; i < jobs.size(); i++) {
+            inputs.push_back({
+                std::filesystem::path(jobs[i].file).lexically_normal().generic_string(),
+                kindToStage(jobs[i].kind),
+                &results[i],
+            });
+        }
         
-        writeToFile(std::string(outFile), compiledShader.toBytes());
+        if (writeIfChanged(std::string(cacheDir / "shaders.crsb"), Car::buildShaderBundle(inputs))) {
+            std::cout << "wrote " << std::string(cacheDir / "shaders.crsb") << std::endl;
+        }
     }
     
+    std::cout << jobs.size() << " shaders, " << compiledCount << " compiled, " << writtenCount << " written"
+              << std::endl;
     
-    return 0;
+    return (failed || !ok) ? 1 : 0;
 }